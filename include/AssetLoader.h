@@ -0,0 +1,102 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_ASSET_LOADER_H_
+#define VT_ASSET_LOADER_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#define MAX_ASSET_LOADER_THREADS 8
+
+namespace vt {
+
+class Mesh;
+class Texture;
+
+// decodes assets on a worker pool, then hands them to the gl thread for upload
+// NOTE: decode tasks must not touch gl; upload tasks only run inside poll() / finish() on the caller's thread
+class AssetLoader
+{
+public:
+    typedef std::function<void()> task_t;
+
+    AssetLoader(int num_threads = 0, bool use_cooked_cache = true); // 0 threads = one per core (capped)
+    ~AssetLoader();
+
+    void submit(task_t decode, task_t upload = task_t());
+
+    // common assets (result pointers are filled in at upload)
+    void load_texture(const std::string& name,
+                      const std::string& png_filename,
+                            Texture**    texture,
+                            bool         smooth = true);
+    void load_cube_map(const std::string& name,
+                       const std::string& png_filename_pos_x,
+                       const std::string& png_filename_neg_x,
+                       const std::string& png_filename_pos_y,
+                       const std::string& png_filename_neg_y,
+                       const std::string& png_filename_pos_z,
+                       const std::string& png_filename_neg_z,
+                             Texture**    texture);
+    void load_3ds(const std::string&  filename,
+                        int           index,
+                  std::vector<Mesh*>* meshes,
+                        int           num_lods   = 0,
+                        bool          compressed = false);
+
+    // gl thread
+    int poll(bool wait = false); // runs ready uploads, returns how many ran
+    void finish();
+
+    // progress
+    int get_num_jobs() const;
+    int get_num_decoded() const;
+    int get_num_uploaded() const;
+    float get_progress() const;
+    bool is_done() const;
+
+private:
+    struct Job
+    {
+        task_t m_decode;
+        task_t m_upload;
+    };
+
+    bool                     m_use_cooked_cache;
+    std::vector<std::thread> m_threads;
+    std::deque<Job>          m_decode_queue;
+    std::deque<Job>          m_upload_queue;
+    mutable std::mutex       m_mutex;
+    std::condition_variable  m_decode_cond;
+    std::condition_variable  m_upload_cond;
+    bool                     m_shutdown;
+    int                      m_num_jobs;
+    int                      m_num_decoded;
+    int                      m_num_uploaded;
+
+    void worker();
+};
+
+}
+
+#endif
@@ -129,6 +129,7 @@ public:
     void set_image_res(glm::ivec2 image_res);
 
     const glm::mat4 &get_projection_transform();
+    float get_projected_size(glm::vec3 center, float radius);
 
 private:
     std::string       m_name;
@@ -0,0 +1,85 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_DEBUG_ARENA_H_
+#define VT_DEBUG_ARENA_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <tuple>
+
+namespace vt {
+
+class TransformObject;
+
+struct IKGuideWire
+{
+    const TransformObject* m_segment;
+    glm::vec3              m_target_dir;
+    glm::vec3              m_end_effector_tip_dir;
+    glm::vec3              m_local_pivot;
+    glm::vec3              m_local_target;
+};
+
+// per-frame storage for guide wires (for debug)
+// NOTE: recorded only while a consumer is registered; storage is reused across frames
+class DebugArena
+{
+public:
+    typedef std::tuple<glm::vec3, glm::vec3, glm::vec3, float>  debug_line_t;
+    typedef std::pair<const TransformObject*, debug_line_t>     owned_debug_line_t;
+    typedef std::vector<IKGuideWire>                            ik_guide_wires_t;
+    typedef std::vector<owned_debug_line_t>                     debug_lines_t;
+
+    static DebugArena* instance()
+    {
+        static DebugArena debug_arena;
+        return &debug_arena;
+    }
+
+    // consumers
+    void register_consumer()   { m_consumer_count++; }
+    void unregister_consumer() { if(m_consumer_count) { m_consumer_count--; } }
+    bool is_enabled() const    { return m_consumer_count > 0; }
+
+    // recording
+    void begin_frame();
+    void add_ik_guide_wire(const TransformObject* segment,
+                           glm::vec3              abs_target,
+                           glm::vec3              abs_end_effector_tip);
+    void add_debug_line(const TransformObject* owner,
+                        glm::vec3              p1,
+                        glm::vec3              p2,
+                        glm::vec3              color,
+                        float                  linewidth = 1);
+
+    // playback
+    const IKGuideWire* find_ik_guide_wire(const TransformObject* segment) const;
+    const ik_guide_wires_t &get_ik_guide_wires() const { return m_ik_guide_wires; }
+    const debug_lines_t &get_debug_lines() const       { return m_debug_lines; }
+
+private:
+    int              m_consumer_count;
+    ik_guide_wires_t m_ik_guide_wires;
+    debug_lines_t    m_debug_lines;
+
+    DebugArena();
+};
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_DEFORMER_H_
+#define VT_DEFORMER_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace vt {
+
+class MeshBase;
+
+// procedural vertex deformer, evaluated in deformer.inc.glsl (shared by every pass) with a cpu fallback
+class Deformer
+{
+public:
+    enum deformer_type_t {
+        DEFORMER_TYPE_NONE,
+        DEFORMER_TYPE_RIPPLE, // params: (amplitude, wavelength, phase, -)
+        DEFORMER_TYPE_TWIST,  // params: (radians per unit along y, -, -, -)
+        DEFORMER_TYPE_BEND,   // params: (radians per unit along x, -, -, -)
+        DEFORMER_TYPE_NOISE   // params: (amplitude, frequency, phase, -)
+    };
+
+    Deformer(deformer_type_t type   = DEFORMER_TYPE_NONE,
+             glm::vec3       origin = glm::vec3(0),
+             glm::vec4       params = glm::vec4(0));
+
+    deformer_type_t get_type() const
+    {
+        return m_type;
+    }
+    void set_type(deformer_type_t type)
+    {
+        m_type = type;
+    }
+
+    const glm::vec3 &get_origin() const
+    {
+        return m_origin;
+    }
+    void set_origin(glm::vec3 origin)
+    {
+        m_origin = origin;
+    }
+
+    const glm::vec4 &get_params() const
+    {
+        return m_params;
+    }
+    void set_params(glm::vec4 params)
+    {
+        m_params = params;
+    }
+    void set_phase(float phase)
+    {
+        m_params.z = phase;
+    }
+
+    void apply(MeshBase* mesh);
+    void inflate_bbox(glm::vec3* min, glm::vec3* max) const; // conservative, for any phase
+    void reset_rest_pose();
+
+private:
+    deformer_type_t        m_type;
+    glm::vec3              m_origin;
+    glm::vec4              m_params;
+    std::vector<glm::vec3> m_rest_vert_coords;
+    std::vector<glm::vec3> m_rest_vert_normals;
+};
+
+}
+
+#endif
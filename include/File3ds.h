@@ -18,7 +18,7 @@
 #ifndef VT_FILE_3DS_H_
 #define VT_FILE_3DS_H_
 
-#include <stdio.h>
+#include <stdint.h>
 #include <vector>
 #include <string>
 
@@ -41,11 +41,13 @@ public:
 
 private:
     static bool load3ds_impl(const std::string& filename, int index, std::vector<MeshBase*>* meshes);
-	static uint32_t enter_chunk(FILE* stream, uint32_t chunk_id, uint32_t chunk_end);
-	static void read_vertices(FILE* stream, MeshBase* mesh);
-	static void read_faces(FILE* stream, MeshBase* mesh);
-	static uint16_t read_short(FILE* stream);
-	static uint32_t read_long(FILE* stream);
+	static void parse(const uint8_t* data, uint32_t size, int index, std::vector<MeshBase*>* meshes);
+	static bool next_chunk(const uint8_t* data, uint32_t* pos, uint32_t parent_end, uint16_t* chunk_id, uint32_t* chunk_end);
+	static uint32_t enter_chunk(const uint8_t* data, uint32_t* pos, uint32_t chunk_id, uint32_t parent_end);
+	static void read_vertices(const uint8_t* vertex_list, MeshBase* mesh);
+	static void read_faces(const uint8_t* face_list, MeshBase* mesh);
+	static uint16_t read_short(const uint8_t* data);
+	static uint32_t read_long(const uint8_t* data);
 };
 
 }
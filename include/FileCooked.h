@@ -0,0 +1,146 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_FILE_COOKED_H_
+#define VT_FILE_COOKED_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+#define COOKED_MAGIC   0x4B435456 // "VTCK"
+#define COOKED_VERSION 2
+#define COOKED_EXT     ".cooked"
+
+namespace vt {
+
+class Mesh;
+
+typedef enum {
+    COOKED_FORMAT_ANY = -1, // load only, accepts whatever was cooked
+    COOKED_FORMAT_RGBA,
+    COOKED_FORMAT_BC1,
+    COOKED_FORMAT_BC3,
+    COOKED_FORMAT_BC7       // load only, there is no bc7 encoder
+} cooked_format_t;
+
+// one image with its level chain back to back (level 0 first)
+struct CookedImage
+{
+    glm::ivec2           m_dim;
+    cooked_format_t      m_format;
+    int                  m_num_levels;
+    const unsigned char* m_data;
+
+    CookedImage()
+        : m_dim(0),
+          m_format(COOKED_FORMAT_RGBA),
+          m_num_levels(0),
+          m_data(NULL)
+    {}
+};
+
+// linked program binary, with the variables found by reflection at link time
+struct CookedProgram
+{
+    uint32_t                 m_binary_format;
+    const uint8_t*           m_binary;
+    size_t                   m_binary_size;
+    std::vector<std::string> m_attribute_names;
+    std::vector<std::string> m_uniform_names;
+
+    CookedProgram()
+        : m_binary_format(0),
+          m_binary(NULL),
+          m_binary_size(0)
+    {}
+};
+
+// versioned binary cache of fully processed assets, keyed by a hash of the source file(s)
+// NOTE: native byte order and float layout, so cooked files aren't portable across architectures
+class CookedFile
+{
+public:
+    typedef enum { TYPE_MESHES, TYPE_IMAGES, TYPE_PROGRAM } type_t;
+
+    CookedFile();
+    ~CookedFile();
+
+    // fails (and stays closed) on missing file, bad magic, version or type, or stale source hash
+    bool open(const std::string& cooked_filename, type_t type, uint64_t source_hash);
+    void close();
+    bool is_open() const { return m_data != NULL; }
+
+    // meshes (with lods) are copied into mesh storage, images point into the mapping until close
+    bool read_meshes(std::vector<Mesh*>* meshes) const;
+    bool read_images(std::vector<CookedImage>* images) const;
+    bool read_program(CookedProgram* program) const;
+
+    static bool write_meshes(const std::string&        cooked_filename,
+                                   uint64_t            source_hash,
+                             const std::vector<Mesh*>& meshes);
+    static bool write_images(const std::string&              cooked_filename,
+                                   uint64_t                  source_hash,
+                             const std::vector<CookedImage>& images);
+    static bool write_program(const std::string&   cooked_filename,
+                                    uint64_t       source_hash,
+                              const CookedProgram& program);
+
+private:
+    const uint8_t* m_data;
+    size_t         m_size;
+    uint32_t       m_num_records;
+
+    // NOTE: owns the mapping, not copyable (unimplemented)
+    CookedFile(const CookedFile& other);
+    CookedFile& operator=(const CookedFile& other);
+};
+
+uint64_t hash_file(const std::string& filename);
+uint64_t hash_string(const std::string& s);
+uint64_t hash_combine(uint64_t seed, uint64_t value);
+std::string get_cooked_filename(const std::string& source_filename);
+
+// builds the full mip chain of rgba pixels and block-compresses every level (bc1 / bc3 only)
+bool compress_image(const unsigned char*        pixels,
+                          glm::ivec2            dim,
+                          cooked_format_t       format,
+                          std::vector<uint8_t>* data,
+                          int*                  num_levels);
+
+// shared by AssetLoader and the cook tool, cooking on a miss so the next load is warm
+bool load_3ds_cached(const std::string&  filename,
+                           int           index,
+                           int           num_lods,
+                     std::vector<Mesh*>* meshes,
+                           bool          cook_on_miss = true,
+                           bool*         cache_hit    = NULL);
+
+// on a hit, image data points into cooked_file (caller keeps it open), otherwise it is the decoded rgba level 0 and
+// caller owns it (delete[]), a miss is cooked as format (rgba if any)
+bool load_png_cached(const std::string&    png_filename,
+                           CookedFile*     cooked_file,
+                           CookedImage*    image,
+                           cooked_format_t format       = COOKED_FORMAT_ANY,
+                           bool            cook_on_miss = true,
+                           bool*           cache_hit    = NULL);
+
+}
+
+#endif
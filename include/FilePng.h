@@ -28,6 +28,7 @@ bool read_png(const std::string& png_filename,
                     size_t*      width,
                     size_t*      height);
 
+// NOTE: pixel_data is always 8-bit rgba (bottom row first), color_type reports the source format
 bool read_png_impl(const std::string& png_filename,
                          void**       pixel_data,
                          size_t*      width,
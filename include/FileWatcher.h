@@ -0,0 +1,55 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef VT_FILE_WATCHER_H_
+#define VT_FILE_WATCHER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+namespace vt {
+
+// reports files that were rewritten since the last poll (linux inotify)
+// NOTE: parent directories are watched, so editors that save via rename are still seen
+class FileWatcher
+{
+public:
+    FileWatcher();
+    ~FileWatcher();
+
+    bool add_file(const std::string& filename);
+    void poll(std::vector<std::string>* changed_files); // non-blocking, each changed file reported once
+    bool is_valid() const
+    {
+        return m_fd != -1;
+    }
+
+private:
+    typedef std::map<int, std::string> dirs_t;
+    typedef std::set<std::string>      files_t;
+
+    int     m_fd;
+    dirs_t  m_dirs;  // watch descriptor -> directory
+    files_t m_files;
+};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_FLOCK_H_
+#define VT_FLOCK_H_
+
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace vt {
+
+class TransformObject;
+
+// flock of boids stored as structure-of-arrays, steered by uniform grid neighbor queries
+class Flock
+{
+public:
+    Flock(glm::vec3 origin, glm::vec3 dim);
+    virtual ~Flock();
+
+    int add_boid(glm::vec3        pos,
+                 glm::vec3        heading,
+                 TransformObject* transform_object = NULL);
+    size_t get_boid_count() const { return m_pos_x.size(); }
+    glm::vec3 get_boid_pos(int index) const;
+    glm::vec3 get_boid_heading(int index) const;
+    TransformObject* get_transform_object(int index) const                   { return m_transform_objects[index]; }
+    void set_transform_object(int index, TransformObject* transform_object) { m_transform_objects[index] = transform_object; }
+
+    // tuning
+    void set_neighbor_radius(float neighbor_radius)     { m_neighbor_radius   = neighbor_radius; }
+    void set_separation_radius(float separation_radius) { m_separation_radius = separation_radius; }
+    void set_max_neighbors(int max_neighbors)           { m_max_neighbors     = max_neighbors; }
+    void set_weights(float separation_weight,
+                     float alignment_weight,
+                     float cohesion_weight,
+                     float seek_weight);
+    void set_target(glm::vec3 target, bool enable_target = true);
+
+    void update(float forward_speed, float turn_rate);
+
+private:
+    glm::vec3 m_origin;
+    glm::vec3 m_dim;
+
+    // boid state (structure-of-arrays)
+    std::vector<float>            m_pos_x;
+    std::vector<float>            m_pos_y;
+    std::vector<float>            m_pos_z;
+    std::vector<float>            m_heading_x;
+    std::vector<float>            m_heading_y;
+    std::vector<float>            m_heading_z;
+    std::vector<float>            m_steer_x;
+    std::vector<float>            m_steer_y;
+    std::vector<float>            m_steer_z;
+    std::vector<TransformObject*> m_transform_objects; // NULL if not rendered
+
+    // uniform grid (cell size is neighbor radius), rebuilt by counting sort every update
+    glm::ivec3       m_grid_dim;
+    std::vector<int> m_cell_ids;   // per boid
+    std::vector<int> m_cell_start; // per cell, prefix sum of counts (one extra for end)
+    std::vector<int> m_cell_boids; // boid ids sorted by cell
+
+    // scratch (reused across updates)
+    std::vector<int>   m_neighbor_ids;
+    std::vector<float> m_neighbor_distance2;
+
+    // tuning
+    float     m_neighbor_radius;
+    float     m_separation_radius;
+    int       m_max_neighbors;
+    float     m_separation_weight;
+    float     m_alignment_weight;
+    float     m_cohesion_weight;
+    float     m_seek_weight;
+    glm::vec3 m_target;
+    bool      m_enable_target;
+
+    void update_grid();
+    void find_neighbors(int index);
+    void update_steering();
+    void integrate(float forward_speed, float turn_rate);
+    void update_transform_objects();
+};
+
+}
+
+#endif
@@ -0,0 +1,76 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef VT_HOT_RELOADER_H_
+#define VT_HOT_RELOADER_H_
+
+#include <FileWatcher.h>
+#include <string>
+#include <vector>
+#include <set>
+
+namespace vt {
+
+class Material;
+class Mesh;
+class Texture;
+
+// picks up edited shaders, pngs and 3ds files while running
+// NOTE: update() runs on the gl thread between frames, so a frame never sees a half-swapped asset
+class HotReloader
+{
+public:
+    HotReloader();
+
+    void watch_material(Material* material);
+    void watch_texture(Texture* texture, const std::string& png_filename, int face = 0); // face for cube maps
+    void watch_3ds(const std::string&  filename,
+                         int           index,
+                   std::vector<Mesh*>* meshes); // meshes are refilled in place
+
+    int update(); // returns how many assets were swapped
+
+private:
+    struct WatchedTexture
+    {
+        Texture*    m_texture;
+        std::string m_png_filename;
+        int         m_face;
+    };
+    struct Watched3ds
+    {
+        std::string         m_filename;
+        int                 m_index;
+        std::vector<Mesh*>* m_meshes;
+    };
+
+    FileWatcher                 m_file_watcher;
+    std::vector<Material*>      m_materials;
+    std::vector<WatchedTexture> m_textures;
+    std::vector<Watched3ds>     m_3ds_files;
+    std::set<Material*>         m_pending_materials;
+
+    void watch_include_files(const Material* material);
+    bool reload_texture(const WatchedTexture& watched_texture);
+    bool reload_3ds(const Watched3ds& watched_3ds);
+    void clear_shader_contexts();
+};
+
+}
+
+#endif
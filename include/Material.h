@@ -26,6 +26,7 @@
 #include <map>
 #include <string>
 #include <memory> // std::unique_ptr
+#include <stdint.h>
 
 namespace vt {
 
@@ -36,6 +37,12 @@ class Material : public NamedObject
 public:
     typedef std::vector<Texture*> textures_t;
 
+    enum link_state_t {
+        LINK_STATE_PENDING,
+        LINK_STATE_READY,
+        LINK_STATE_FAILED
+    };
+
     Material(const std::string& name                 = "",
              const std::string& vertex_shader_file   = "",
              const std::string& fragment_shader_file = "",
@@ -54,6 +61,32 @@ public:
     {
         return m_fragment_shader;
     }
+    link_state_t get_link_state() const
+    {
+        return m_link_state;
+    }
+    bool is_ready();
+
+    // hot reload
+    const std::string &get_vertex_shader_file() const
+    {
+        return m_vertex_shader_file;
+    }
+    const std::string &get_fragment_shader_file() const
+    {
+        return m_fragment_shader_file;
+    }
+    const std::vector<std::string> &get_include_files() const
+    {
+        return m_include_files;
+    }
+    bool uses_file(const std::string& filename) const;
+    bool reload();
+    bool poll_reload();
+    bool is_reloading() const
+    {
+        return m_pending_program != NULL;
+    }
 
     void add_texture(Texture* texture);
     void clear_textures();
@@ -77,12 +110,30 @@ public:
     }
 
 private:
-    Program*   m_program;
-    Shader*    m_vertex_shader;
-    Shader*    m_fragment_shader;
-    textures_t m_textures; // TODO: Material has multiple Textures
-    bool       m_use_overlay;
-    bool       m_use_ssao;
+    Program*    m_program;
+    Shader*     m_vertex_shader;
+    Shader*     m_fragment_shader;
+    std::string m_vertex_shader_file;
+    std::string m_fragment_shader_file;
+    textures_t  m_textures; // TODO: Material has multiple Textures
+    bool        m_use_overlay;
+    bool        m_use_ssao;
+
+    // program cache / async link
+    link_state_t m_link_state;
+    std::string  m_cooked_filename;
+    uint64_t     m_cooked_key;
+
+    // shared snippets pulled in by '#include', part of the cooked key and watched for hot reload
+    std::vector<std::string> m_include_files;
+
+    // hot reload
+    Program* m_pending_program;
+    Shader*  m_pending_vertex_shader;
+    Shader*  m_pending_fragment_shader;
+
+    uint64_t get_cooked_key();
+    void clear_pending_program();
 
     typedef std::map<std::string, Texture*> texture_lookup_table_t;
     texture_lookup_table_t m_texture_lookup_table;
@@ -28,21 +28,28 @@
 #include <string>
 #include <stddef.h>
 #include <memory> // std::unique_ptr
+#include <vector>
+
+#define DEFAULT_LOD_SCREEN_SIZE 0.5
 
 namespace vt {
 
+class Deformer;
 class Material;
+class MeshAllocator;
 
 class Mesh : public TransformObject,
              public BBoxObject,
              public MeshBase
 {
 public:
-    Mesh(const std::string& name,
-               size_t       num_vertex,
-               size_t       num_tri);
+    Mesh(const std::string&   name,
+               size_t         num_vertex,
+               size_t         num_tri,
+               MeshAllocator* allocator = NULL); // NULL for MeshAllocator::get_default()
     virtual ~Mesh();
     void resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry = false);
+    void reserve(size_t num_vertex, size_t num_tri);
     void merge(const MeshBase* other, bool copy_tex_coords = false);
 
     size_t get_num_vertex() const
@@ -53,6 +60,19 @@ public:
     {
         return m_num_tri;
     }
+    size_t get_vertex_capacity() const
+    {
+        return m_vertex_capacity;
+    }
+    size_t get_tri_capacity() const
+    {
+        return m_tri_capacity;
+    }
+    MeshAllocator* get_allocator() const
+    {
+        return m_allocator;
+    }
+    void set_allocator(MeshAllocator* allocator);
 
     bool is_visible() const
     {
@@ -83,9 +103,69 @@ public:
     glm::ivec3 get_tri_indices(int index) const;
     void       set_tri_indices(int index, glm::ivec3 indices);
 
+    // NOTE: glm vector types are tightly packed, so they alias the underlying GLfloat arrays
+    glm::vec3*       get_vert_coords()         { return reinterpret_cast<glm::vec3*>(m_vert_coords); }
+    const glm::vec3* get_vert_coords() const   { return reinterpret_cast<const glm::vec3*>(m_vert_coords); }
+    glm::vec3*       get_vert_normals()        { return reinterpret_cast<glm::vec3*>(m_vert_normal); }
+    const glm::vec3* get_vert_normals() const  { return reinterpret_cast<const glm::vec3*>(m_vert_normal); }
+    glm::vec3*       get_vert_tangents()       { return reinterpret_cast<glm::vec3*>(m_vert_tangent); }
+    const glm::vec3* get_vert_tangents() const { return reinterpret_cast<const glm::vec3*>(m_vert_tangent); }
+    glm::vec2*       get_tex_coords()          { return reinterpret_cast<glm::vec2*>(m_tex_coords); }
+    const glm::vec2* get_tex_coords() const    { return reinterpret_cast<const glm::vec2*>(m_tex_coords); }
+    uint16_t*        get_tri_indices()         { return reinterpret_cast<uint16_t*>(m_tri_indices); }
+    const uint16_t*  get_tri_indices() const   { return reinterpret_cast<const uint16_t*>(m_tri_indices); }
+    void copy_vertices(const MeshBase* other, int dest_index, int src_index, int count, bool copy_tex_coords = true);
+    void copy_tri_indices(const MeshBase* other, int dest_index, int src_index, int count, int index_offset = 0);
+
     glm::vec3 get_vert_bitangent(int index) const;
 
+    // skinning
+    glm::ivec4 get_bone_indices(int index) const;
+    void       set_bone_indices(int index, glm::ivec4 indices);
+    glm::vec4  get_bone_weights(int index) const;
+    void       set_bone_weights(int index, glm::vec4 weights);
+    bool is_skinned() const
+    {
+        return !m_bones.empty();
+    }
+    int add_bone(TransformObject* bone);
+    const std::vector<TransformObject*> &get_bones() const
+    {
+        return m_bones;
+    }
+    void clear_bones();
+    void update_bone_palette();
+    const std::vector<glm::mat4> &get_bone_palette() const
+    {
+        return m_bone_palette;
+    }
+    void skin_vertices(const MeshBase* bind_pose_mesh);
+
+    // level of detail
+    void add_lod(Mesh* lod, float max_screen_size);
+    int generate_lods(int num_lods, float tri_ratio = 0.5, float max_screen_size = DEFAULT_LOD_SCREEN_SIZE);
+    void clear_lods();
+    int get_num_lods() const
+    {
+        return m_lods.size();
+    }
+    Mesh* get_lod(int lod)
+    {
+        return lod ? m_lods[lod - 1] : this;
+    }
+    float get_lod_screen_size(int lod) const
+    {
+        return m_lod_screen_sizes[lod - 1];
+    }
+    int select_lod(float screen_size, float hysteresis = 0);
+    void get_bounding_sphere(glm::vec3* center, float* radius);
+
     void update_bbox();
+    void set_min_max(glm::vec3 min, glm::vec3 max)
+    {
+        m_min = min;
+        m_max = max;
+    }
     void update_normals_and_tangents();
 
     // NOTE: strangely required by pure virtual (already defined in base class!)
@@ -95,12 +175,30 @@ public:
     glm::vec3 in_abs_system(glm::vec3 local_point = glm::vec3(0));
 
     void init_buffers();
-    void update_buffers() const;
+    void update_buffers();
     Buffer* get_vbo_vert_coords();
     Buffer* get_vbo_vert_normal();
     Buffer* get_vbo_vert_tangent();
     Buffer* get_vbo_tex_coords();
     Buffer* get_ibo_tri_indices();
+    Buffer* get_vbo_bone_indices();
+    Buffer* get_vbo_bone_weights();
+
+    // vertex compression
+    bool is_compressed() const
+    {
+        return m_compressed;
+    }
+    void set_compressed(bool compressed);
+    const glm::vec3 &get_position_dequant_offset() const
+    {
+        return m_position_dequant_offset;
+    }
+    const glm::vec3 &get_position_dequant_scale() const
+    {
+        return m_position_dequant_scale;
+    }
+    size_t get_vertex_buffer_size() const;
 
     void set_material(Material* material);
     Material* get_material() const
@@ -112,6 +210,8 @@ public:
     ShaderContext* get_normal_shader_context(Material* normal_material);
     ShaderContext* get_wireframe_shader_context(Material* wireframe_material);
     ShaderContext* get_ssao_shader_context(Material* ssao_material);
+    ShaderContext* get_fallback_shader_context(Material* fallback_material);
+    void clear_shader_contexts();
 
     int get_texture_index() const
     {
@@ -194,6 +294,12 @@ public:
         m_reflect_to_refract_ratio = reflect_to_refract_ratio;
     }
 
+    Deformer* get_deformer() const
+    {
+        return m_deformer;
+    }
+    void set_deformer(Deformer* deformer);
+
     glm::vec3 get_ambient_color() const;
     void set_ambient_color(glm::vec3 ambient_color);
 
@@ -206,6 +312,11 @@ private:
     std::string    m_name;
     size_t         m_num_vertex;
     size_t         m_num_tri;
+    size_t         m_vertex_capacity;
+    size_t         m_tri_capacity;
+    MeshAllocator* m_allocator;                // not owned
+    void*          m_storage;                  // single block backing all attribute arrays
+    size_t         m_storage_size;
     bool           m_visible;
     bool           m_smooth;
     GLfloat*       m_vert_coords;
@@ -218,12 +329,28 @@ private:
     Buffer*        m_vbo_vert_tangent;
     Buffer*        m_vbo_tex_coords;
     Buffer*        m_ibo_tri_indices;
+    GLfloat*       m_bone_indices;             // NOTE: float for GLSL 1.20 attribute compatibility
+    GLfloat*       m_bone_weights;
+    Buffer*        m_vbo_bone_indices;
+    Buffer*        m_vbo_bone_weights;
+    bool           m_compressed;
+    GLshort*       m_packed_vert_coords;       // snorm16 (x, y, z, pad) relative to bbox
+    GLshort*       m_packed_vert_normal;       // octahedral snorm16
+    GLshort*       m_packed_vert_tangent;      // octahedral snorm16
+    GLushort*      m_packed_tex_coords;        // half float
+    Buffer*        m_vbo_packed_vert_coords;
+    Buffer*        m_vbo_packed_vert_normal;
+    Buffer*        m_vbo_packed_vert_tangent;
+    Buffer*        m_vbo_packed_tex_coords;
+    glm::vec3      m_position_dequant_offset;
+    glm::vec3      m_position_dequant_scale;
     bool           m_buffers_already_init;
     Material*      m_material;                 // TODO: Mesh has one Material
     ShaderContext* m_shader_context;           // TODO: Mesh has one ShaderContext
     ShaderContext* m_normal_shader_context;    // TODO: Mesh has one normal ShaderContext
     ShaderContext* m_wireframe_shader_context; // TODO: Mesh has one wireframe ShaderContext
     ShaderContext* m_ssao_shader_context;      // TODO: Mesh has one ssao ShaderContext
+    ShaderContext* m_fallback_shader_context;  // TODO: Mesh has one fallback ShaderContext
     int            m_texture_index;
     int            m_texture2_index;
     int            m_bump_texture_index;
@@ -234,7 +361,29 @@ private:
     int            m_backface_normal_overlay_texture_index;
     float          m_reflect_to_refract_ratio;
     GLfloat*       m_ambient_color;
-
+    Deformer*      m_deformer;                 // not owned
+
+    // skinning
+    std::vector<TransformObject*> m_bones;
+    std::vector<glm::mat4>        m_bind_pose_transforms;
+    std::vector<glm::mat4>        m_bone_palette;
+
+    // level of detail
+    std::vector<Mesh*> m_lods;             // owned, coarsest last
+    std::vector<float> m_lod_screen_sizes; // lod n used below m_lod_screen_sizes[n - 1]
+    int                m_cur_lod;
+
+    void realloc_storage(size_t         vertex_capacity,
+                         size_t         tri_capacity,
+                         size_t         copy_num_vertex,
+                         size_t         copy_num_tri,
+                         MeshAllocator* allocator = NULL); // NULL for m_allocator
+    void init_float_buffers();
+    ShaderContext* create_shader_context(Material* material);
+    void pack_vertices();
+    void free_packed_data();
+    void alloc_skin_data();
+    void free_skin_data();
     void update_transform();
 };
 
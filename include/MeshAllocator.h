@@ -0,0 +1,145 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_MESH_ALLOCATOR_H_
+#define VT_MESH_ALLOCATOR_H_
+
+#include <vector>
+#include <mutex>
+#include <stddef.h>
+
+#define MESH_ALLOC_ALIGNMENT     16
+#define DEFAULT_ARENA_BLOCK_SIZE (1 << 22)
+#define MIN_POOL_SIZE_CLASS_LOG2 8  // 256 bytes
+#define MAX_POOL_SIZE_CLASS_LOG2 24 // 16 MB (larger requests bypass pool)
+
+namespace vt {
+
+// pluggable storage for mesh attributes (one aligned block per mesh)
+// NOTE: size passed to free() / grow_in_place() must match what was last requested for ptr
+class MeshAllocator
+{
+public:
+    MeshAllocator();
+    virtual ~MeshAllocator() {}
+
+    virtual void* alloc(size_t size) = 0;
+    virtual void free(void* ptr, size_t size) = 0;
+    virtual bool grow_in_place(void* ptr, size_t size, size_t new_size)
+    {
+        return false;
+    }
+
+    // used by meshes constructed without an explicit allocator
+    static MeshAllocator* get_default();
+    static void set_default(MeshAllocator* allocator);
+
+    // stats
+    size_t get_bytes_in_use() const
+    {
+        return m_bytes_in_use;
+    }
+    size_t get_peak_bytes_in_use() const
+    {
+        return m_peak_bytes_in_use;
+    }
+    size_t get_num_allocs() const
+    {
+        return m_num_allocs;
+    }
+
+protected:
+    std::mutex m_mutex;
+    size_t     m_bytes_in_use;
+    size_t     m_peak_bytes_in_use;
+    size_t     m_num_allocs;
+
+    void record_alloc(size_t size);
+    void record_free(size_t size);
+    void record_resize(size_t size, size_t new_size);
+};
+
+// plain aligned heap allocations
+class HeapMeshAllocator : public MeshAllocator
+{
+public:
+    // NOTE: never destroyed, so meshes deleted during static destruction (e.g. by Scene) can still free
+    static HeapMeshAllocator* instance()
+    {
+        static HeapMeshAllocator* heap_mesh_allocator = new HeapMeshAllocator();
+        return heap_mesh_allocator;
+    }
+
+    void* alloc(size_t size);
+    void free(void* ptr, size_t size);
+};
+
+// bump allocator for static geometry, released all at once
+// NOTE: free() only reclaims the most recent allocation, so short-lived temporaries stay cheap
+class ArenaMeshAllocator : public MeshAllocator
+{
+public:
+    ArenaMeshAllocator(size_t block_size = DEFAULT_ARENA_BLOCK_SIZE);
+    ~ArenaMeshAllocator();
+
+    void* alloc(size_t size);
+    void free(void* ptr, size_t size);
+    bool grow_in_place(void* ptr, size_t size, size_t new_size);
+    void reset(); // NOTE: invalidates every allocation
+
+    size_t get_bytes_reserved() const;
+
+private:
+    struct Block
+    {
+        char*  m_data;
+        size_t m_size;
+        size_t m_used;
+    };
+
+    size_t             m_block_size;
+    std::vector<Block> m_blocks;
+
+    bool is_top(void* ptr, size_t size) const;
+};
+
+// power-of-two size-class free lists for dynamic meshes
+class PoolMeshAllocator : public MeshAllocator
+{
+public:
+    // NOTE: never destroyed, so meshes deleted during static destruction (e.g. by Scene) can still free
+    static PoolMeshAllocator* instance()
+    {
+        static PoolMeshAllocator* pool_mesh_allocator = new PoolMeshAllocator();
+        return pool_mesh_allocator;
+    }
+    ~PoolMeshAllocator();
+
+    void* alloc(size_t size);
+    void free(void* ptr, size_t size);
+    bool grow_in_place(void* ptr, size_t size, size_t new_size);
+    void trim(); // releases cached blocks
+
+private:
+    std::vector<void*> m_free_lists[MAX_POOL_SIZE_CLASS_LOG2 - MIN_POOL_SIZE_CLASS_LOG2 + 1];
+
+    PoolMeshAllocator() {}
+};
+
+}
+
+#endif
@@ -20,6 +20,7 @@
 
 #include <BBoxObject.h>
 #include <glm/glm.hpp>
+#include <stdint.h>
 
 namespace vt {
 
@@ -48,6 +49,21 @@ public:
     virtual void       set_tex_coord(int index, glm::vec2 coord) = 0;
     virtual glm::ivec3 get_tri_indices(int index) const = 0;
     virtual void       set_tri_indices(int index, glm::ivec3 indices) = 0;
+
+    // bulk access (tightly packed contiguous views, num_vertex / num_tri * 3 long)
+    virtual glm::vec3*       get_vert_coords() = 0;
+    virtual const glm::vec3* get_vert_coords() const = 0;
+    virtual glm::vec3*       get_vert_normals() = 0;
+    virtual const glm::vec3* get_vert_normals() const = 0;
+    virtual glm::vec3*       get_vert_tangents() = 0;
+    virtual const glm::vec3* get_vert_tangents() const = 0;
+    virtual glm::vec2*       get_tex_coords() = 0;
+    virtual const glm::vec2* get_tex_coords() const = 0;
+    virtual uint16_t*        get_tri_indices() = 0;
+    virtual const uint16_t*  get_tri_indices() const = 0;
+    virtual void             copy_vertices(const MeshBase* other, int dest_index, int src_index, int count, bool copy_tex_coords = true) = 0;
+    virtual void             copy_tri_indices(const MeshBase* other, int dest_index, int src_index, int count, int index_offset = 0) = 0;
+
     virtual void       update_bbox() = 0;
     virtual void       update_normals_and_tangents() = 0;
     virtual void       get_min_max(glm::vec3* min, glm::vec3* max) const = 0;
@@ -19,6 +19,7 @@
 #define VT_MODIFIERS_H_
 
 #include <glm/glm.hpp>
+#include <stddef.h>
 
 namespace vt {
 
@@ -27,12 +28,27 @@ class Scene;
 
 enum tessellation_type_t {
     TESSELLATION_TYPE_EDGE_CENTER,
-    TESSELLATION_TYPE_TRI_CENTER
+    TESSELLATION_TYPE_TRI_CENTER,
+    TESSELLATION_TYPE_LOOP
 };
 
 void mesh_attach(Scene* scene, MeshBase* mesh1, MeshBase* mesh2);
 void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth);
-void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth);
+bool mesh_tessellate(MeshBase* mesh,
+                     tessellation_type_t tessellation_type,
+                     bool                smooth,
+                     int                 levels        = 1,
+                     float               sphere_radius = 0); // project onto sphere after each level if positive
+
+// vertex cache / fetch optimization
+float mesh_calc_acmr(const MeshBase* mesh, int cache_size = 32);
+void mesh_optimize_vertex_cache(MeshBase* mesh);
+void mesh_optimize_vertex_fetch(MeshBase* mesh);
+int mesh_weld_vertices(MeshBase* mesh, float epsilon = 0.0001f);
+void mesh_optimize(MeshBase* mesh, bool weld = false, float* acmr_before = NULL, float* acmr_after = NULL);
+
+// simplification
+int mesh_simplify(MeshBase* mesh, int target_num_tri); // returns resulting triangle count
 
 }
 
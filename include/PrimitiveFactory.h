@@ -42,10 +42,11 @@ public:
                                    float        length           = 1,
                                    float        tex_width_scale  = 1,
                                    float        tex_length_scale = 1);
-    static Mesh* create_sphere(const std::string& name = "",
-                                     int          slices = DEFAULT_SLICES,
-                                     int          stacks = DEFAULT_STACKS,
-                                     float        radius = 1);
+    static Mesh* create_sphere(const std::string& name     = "",
+                                     int          slices   = DEFAULT_SLICES,
+                                     int          stacks   = DEFAULT_STACKS,
+                                     float        radius   = 1,
+                                     int          num_lods = 0);
     static Mesh* create_hemisphere(const std::string& name   = "",
                                          int          slices = DEFAULT_SLICES,
                                          int          stacks = DEFAULT_STACKS,
@@ -62,7 +63,8 @@ public:
                                     int          slices       = DEFAULT_SLICES,
                                     int          stacks       = DEFAULT_STACKS,
                                     float        radius_major = 1,
-                                    float        radius_minor = 0.5);
+                                    float        radius_minor = 0.5,
+                                    int          num_lods     = 0);
     static Mesh* create_box(const std::string& name   = "",
                                   float        width  = 1,
                                   float        height = 1,
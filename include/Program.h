@@ -23,6 +23,7 @@
 #include <GL/glew.h>
 #include <set>
 #include <string>
+#include <stdint.h>
 
 namespace vt {
 
@@ -39,6 +40,12 @@ public:
     };
 
     enum var_attribute_type_t {
+        var_attribute_type_bone_indices,
+        var_attribute_type_bone_weights,
+        var_attribute_type_packed_normal,
+        var_attribute_type_packed_position,
+        var_attribute_type_packed_tangent,
+        var_attribute_type_packed_texcoord,
         var_attribute_type_texcoord,
         var_attribute_type_vertex_normal,
         var_attribute_type_vertex_position,
@@ -51,6 +58,7 @@ public:
         var_uniform_type_backface_depth_overlay_texture,
         var_uniform_type_backface_normal_overlay_texture,
         var_uniform_type_bloom_kernel,
+        var_uniform_type_bone_transforms,
         var_uniform_type_bump_texture,
         var_uniform_type_camera_dir,
         var_uniform_type_camera_far,
@@ -58,6 +66,9 @@ public:
         var_uniform_type_camera_pos,
         var_uniform_type_color_texture,
         var_uniform_type_color_texture2,
+        var_uniform_type_deformer_origin,
+        var_uniform_type_deformer_params,
+        var_uniform_type_deformer_type,
         var_uniform_type_env_map_texture,
         var_uniform_type_frontface_depth_overlay_texture,
         var_uniform_type_glow_cutoff_threshold,
@@ -72,6 +83,9 @@ public:
         var_uniform_type_model_transform,
         var_uniform_type_mvp_transform,
         var_uniform_type_normal_transform,
+        var_uniform_type_packed_vertices,
+        var_uniform_type_position_dequant_offset,
+        var_uniform_type_position_dequant_scale,
         var_uniform_type_random_texture,
         var_uniform_type_reflect_to_refract_ratio,
         var_uniform_type_ssao_sample_kernel_pos,
@@ -93,6 +107,12 @@ public:
     }
     bool auto_add_shader_vars();
     bool link();
+    void begin_link();
+    bool is_link_complete() const;
+    bool end_link();
+    bool load_binary(const std::string& cooked_filename, uint64_t key);
+    bool save_binary(const std::string& cooked_filename, uint64_t key) const;
+    static uint64_t get_driver_hash();
     void use() const;
     VarAttribute* get_var_attribute(const GLchar* name) const;
     VarUniform* get_var_uniform(const GLchar* name) const;
@@ -101,8 +121,6 @@ public:
             GLint* params) const;
     static std::string get_var_attribute_name(int id);
     static std::string get_var_uniform_name(int id);
-    bool check_var_exists_in_shader(var_type_t var_type, const std::string& name) const;
-    bool add_var(var_type_t var_type, std::string name);
     bool has_var(var_type_t var_type, std::string name) const;
     bool has_var(var_type_t var_type, int id) const;
     void clear_vars();
@@ -124,6 +142,8 @@ private:
     typedef std::set<std::string> var_uniform_names_t;
     var_uniform_names_t m_var_uniform_names;
     bool m_var_uniform_ids[var_uniform_type_count];
+
+    bool insert_var(var_type_t var_type, const std::string& name);
 };
 
 }
@@ -18,6 +18,7 @@
 #ifndef VT_SCENE_H_
 #define VT_SCENE_H_
 
+#include <MeshAllocator.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <GL/glew.h>
 #include <vector>
@@ -101,10 +102,18 @@ public:
     Mesh* find_mesh(std::string name);
     void add_mesh(Mesh* mesh);
     void remove_mesh(Mesh* mesh);
+    const meshes_t &get_meshes() const
+    {
+        return m_meshes;
+    }
 
     Material* find_material(std::string name);
     void add_material(Material* material);
     void remove_material(Material* material);
+    const materials_t &get_materials() const
+    {
+        return m_materials;
+    }
 
     Texture* find_texture(std::string name);
     void add_texture(Texture* texture);
@@ -155,11 +164,45 @@ public:
         return m_ssao_material;
     }
 
+    // NOTE: drawn instead of a mesh's own material until that one finishes linking (skipped if not set)
+    void set_fallback_material(Material* material)
+    {
+        m_fallback_material = material;
+    }
+    Material* get_fallback_material() const
+    {
+        return m_fallback_material;
+    }
+
     void set_glow_cutoff_threshold(float glow_cutoff_threshold)
     {
         m_glow_cutoff_threshold = glow_cutoff_threshold;
     }
 
+    // NOTE: outlives every mesh (members are destroyed after meshes are deleted in ~Scene)
+    ArenaMeshAllocator* get_mesh_arena()
+    {
+        return &m_mesh_arena;
+    }
+
+    bool get_lod_enabled() const
+    {
+        return m_lod_enabled;
+    }
+    void set_lod_enabled(bool lod_enabled)
+    {
+        m_lod_enabled = lod_enabled;
+    }
+
+    float get_lod_hysteresis() const
+    {
+        return m_lod_hysteresis;
+    }
+    void set_lod_hysteresis(float lod_hysteresis)
+    {
+        m_lod_hysteresis = lod_hysteresis;
+    }
+
     void reset();
     void use_program();
     void render(bool                clear_canvas      = true,
@@ -188,6 +231,11 @@ private:
     Material*   m_normal_material;
     Material*   m_wireframe_material;
     Material*   m_ssao_material;
+    Material*   m_fallback_material;
+    bool        m_lod_enabled;
+    float       m_lod_hysteresis;
+
+    ArenaMeshAllocator m_mesh_arena; // static geometry
 
     GLfloat  m_bloom_kernel[7];
     GLfloat  m_glow_cutoff_threshold;
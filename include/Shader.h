@@ -27,7 +27,7 @@ namespace vt {
 class Shader : public IdentObject
 {
 public:
-    Shader(std::string filename, GLenum type);
+    Shader(std::string filename, GLenum type, bool deferred = false);
     virtual ~Shader();
     std::string get_filename() const
     {
@@ -37,6 +37,7 @@ public:
     {
         return m_type;
     }
+    bool check_compile_status() const;
 
 private:
     std::string m_filename;
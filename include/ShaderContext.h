@@ -40,7 +40,13 @@ public:
                   Buffer*   vbo_vert_normal,
                   Buffer*   vbo_vert_tangent,
                   Buffer*   vbo_tex_coords,
-                  Buffer*   ibo_tri_indices);
+                  Buffer*   ibo_tri_indices,
+                  Buffer*   vbo_bone_indices        = NULL,
+                  Buffer*   vbo_bone_weights        = NULL,
+                  Buffer*   vbo_packed_vert_coords  = NULL,
+                  Buffer*   vbo_packed_vert_normal  = NULL,
+                  Buffer*   vbo_packed_vert_tangent = NULL,
+                  Buffer*   vbo_packed_tex_coords   = NULL);
     ~ShaderContext();
     Material* get_material() const
     {
@@ -51,11 +57,15 @@ public:
     void set_backface_depth_overlay_texture_index(GLint texture_id);
     void set_backface_normal_overlay_texture_index(GLint texture_id);
     void set_bloom_kernel(const float* bloom_kernel_arr);
+    void set_bone_transforms(size_t num_bones, const float* bone_transforms_arr);
     void set_bump_texture_index(GLint texture_id);
     void set_camera_dir(const float* camera_dir_arr);
     void set_camera_far(GLfloat camera_far);
     void set_camera_near(GLfloat camera_near);
     void set_camera_pos(const float* camera_pos_arr);
+    void set_deformer_origin(const float* deformer_origin_arr);
+    void set_deformer_params(const float* deformer_params_arr);
+    void set_deformer_type(GLint deformer_type);
     void set_env_map_texture_index(GLint texture_id);
     void set_frontface_depth_overlay_texture_index(GLint texture_id);
     void set_glow_cutoff_threshold(GLfloat glow_cutoff_threshold);
@@ -69,6 +79,9 @@ public:
     void set_model_transform(glm::mat4 model_transform);
     void set_mvp_transform(glm::mat4 mvp_transform);
     void set_normal_transform(glm::mat4 normal_transform);
+    void set_packed_vertices(bool packed_vertices);
+    void set_position_dequant_offset(const float* position_dequant_offset_arr);
+    void set_position_dequant_scale(const float* position_dequant_scale_arr);
     void set_random_texture_index(GLint texture_id);
     void set_reflect_to_refract_ratio(GLfloat reflect_to_refract_ratio);
     void set_ssao_sample_kernel_pos(size_t num_kernels, const float* kernel_pos_arr);
@@ -81,6 +94,8 @@ public:
 private:
     Material *m_material;
     Buffer *m_vbo_vert_coords, *m_vbo_vert_normal, *m_vbo_vert_tangent, *m_vbo_tex_coords, *m_ibo_tri_indices;
+    Buffer *m_vbo_bone_indices, *m_vbo_bone_weights;
+    Buffer *m_vbo_packed_vert_coords, *m_vbo_packed_vert_normal, *m_vbo_packed_vert_tangent, *m_vbo_packed_tex_coords;
     std::vector<VarAttribute*> m_var_attributes;
     std::vector<VarUniform*> m_var_uniforms;
     const textures_t &m_textures;
@@ -0,0 +1,88 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef VT_STATIC_BATCH_H_
+#define VT_STATIC_BATCH_H_
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace vt {
+
+class Material;
+class Mesh;
+
+// combines static meshes sharing a material into one vertex / index pool
+// NOTE: source transforms are baked in, and sub-mesh ranges are kept for per-object visibility
+class StaticBatch
+{
+public:
+    struct SubMesh
+    {
+        Mesh* m_source; // not owned
+        int   m_first_vertex;
+        int   m_num_vertex;
+        int   m_first_tri;
+        int   m_num_tri;
+        bool  m_visible;
+    };
+
+    StaticBatch(const std::string& name, Material* material);
+
+    Material* get_material() const
+    {
+        return m_material;
+    }
+    bool can_add(const Mesh* mesh) const;
+    bool add(Mesh* mesh);
+    Mesh* build(bool hide_sources = true);
+
+    // NOTE: owned by caller (e.g. Scene::add_mesh)
+    Mesh* get_mesh() const
+    {
+        return m_mesh;
+    }
+
+    int get_num_sub_meshes() const
+    {
+        return m_sub_meshes.size();
+    }
+    const SubMesh &get_sub_mesh(int index) const
+    {
+        return m_sub_meshes[index];
+    }
+    int find_sub_mesh(const Mesh* source) const;
+    void set_sub_mesh_visible(int index, bool visible);
+
+private:
+    std::string           m_name;
+    Material*             m_material;
+    Mesh*                 m_mesh;
+    std::vector<SubMesh>  m_sub_meshes;
+    size_t                m_num_vertex;
+    size_t                m_num_tri;
+    std::vector<uint16_t> m_tri_indices; // unmasked copy, for restoring hidden sub-meshes
+};
+
+// groups meshes by material and per-mesh uniforms into batches, splitting at the 16-bit index limit
+void build_static_batches(const std::vector<Mesh*> &meshes, std::vector<StaticBatch*>* batches, bool hide_sources = true);
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 
 #define DEFAULT_TEXTURE_WIDTH  256
 #define DEFAULT_TEXTURE_HEIGHT 256
+#define COMPRESSED_BLOCK_DIM   4 // bc1, bc3 and bc7 all encode 4x4 pixel blocks
 
 namespace vt {
 
@@ -38,6 +39,7 @@ class Texture : public NamedObject,
 {
 public:
     typedef enum { RGBA, RGB, RED, DEPTH } format_t;
+    typedef enum { BC1, BC3, BC7 } compressed_format_t;
 
     Texture(const std::string&         name            = "",
                   format_t             internal_format = Texture::RGBA,
@@ -45,7 +47,8 @@ public:
                                                                     DEFAULT_TEXTURE_HEIGHT),
                   bool                 smooth          = true,
                   format_t             format          = Texture::RGBA,
-                  const unsigned char* pixels          = NULL);
+                  const unsigned char* pixels          = NULL,
+                  bool                 mipmap          = false);
     Texture(const std::string& name,
             const std::string& png_filename,
                   bool         smooth = true);
@@ -56,26 +59,58 @@ public:
             const std::string& png_filename_neg_y,
             const std::string& png_filename_pos_z,
             const std::string& png_filename_neg_z);
+    Texture(const std::string&   name,
+                  glm::ivec2     dim,
+            const unsigned char* pixels_pos_x,
+            const unsigned char* pixels_neg_x,
+            const unsigned char* pixels_pos_y,
+            const unsigned char* pixels_neg_y,
+            const unsigned char* pixels_pos_z,
+            const unsigned char* pixels_neg_z,
+                  bool           mipmap = false);
+    Texture(const std::string&          name,
+                  compressed_format_t   compressed_format,
+                  glm::ivec2            dim,
+                  int                   num_levels,
+                  int                   num_faces,
+            const unsigned char* const* face_data);
     virtual ~Texture();
     void bind();
 
     // accessors
     format_t get_internal_format() const { return m_internal_format; }
     unsigned char* get_pixels() const    { return m_pixels; }
+    int get_num_levels() const           { return m_num_levels; }
+    bool is_compressed() const           { return m_compressed; }
+
+    // mipmaps
+    static int get_num_mip_levels(glm::ivec2 dim);
+    static void downsample(const unsigned char* src_pixels,
+                                 glm::ivec2     src_dim,
+                                 unsigned char* dest_pixels);
+
+    // compressed formats
+    static size_t get_compressed_size(compressed_format_t compressed_format,
+                                      glm::ivec2          dim,
+                                      int                 num_levels = 1);
+    static bool is_compressed_format_supported(compressed_format_t compressed_format);
 
 private:
     // core functionality
+    void alloc_storage();
     void alloc(format_t    internal_format,
                glm::ivec2  dim,
                bool        smooth,
-               const void* pixels);
+               const void* pixels,
+               bool        mipmap);
     void alloc(glm::ivec2  dim,
                const void* pixels_pos_x,
                const void* pixels_neg_x,
                const void* pixels_pos_y,
                const void* pixels_neg_y,
                const void* pixels_pos_z,
-               const void* pixels_neg_z);
+               const void* pixels_neg_z,
+               bool        mipmap);
 
 public:
     size_t size() const;
@@ -99,9 +134,17 @@ public:
     void set_pixel_r32f(glm::ivec2 pos, float color);
     void set_color_r32f(float color);
 
+    // hot reload -- face is in constructor order (pos x, neg x, pos y, neg y, pos z, neg z), ignored for 2d
+    bool replace_pixels(const unsigned char* pixels, glm::ivec2 dim, int face = 0);
+
     // core functionality
     void update();
+    void update(glm::ivec2 pos, glm::ivec2 dim);
+    void update_dirty();
+    void update_async();
     void refresh();
+    void refresh_async();
+    bool poll_refresh(bool wait = false);
 
 private:
     bool           m_skybox;
@@ -113,6 +156,22 @@ private:
     unsigned char* m_pixels_neg_y;
     unsigned char* m_pixels_pos_z;
     unsigned char* m_pixels_neg_z;
+    int            m_num_levels;
+    bool           m_compressed;
+
+    // gpu transfer
+    glm::ivec2 m_dirty_min;
+    glm::ivec2 m_dirty_max;
+    GLuint     m_unpack_pbo;
+    GLuint     m_pack_pbo;
+    GLsync     m_pack_fence;
+
+    unsigned char* get_face_pixels(int face) const;
+    GLenum get_gl_format() const;
+    GLenum get_gl_type() const;
+    void mark_dirty(glm::ivec2 pos, glm::ivec2 dim);
+    void clear_dirty();
+    void update_mipmaps();
 };
 
 }
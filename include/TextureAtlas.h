@@ -0,0 +1,90 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#ifndef VT_TEXTURE_ATLAS_H_
+#define VT_TEXTURE_ATLAS_H_
+
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#define DEFAULT_TEXTURE_ATLAS_SIZE    1024
+#define DEFAULT_TEXTURE_ATLAS_PADDING 4
+
+namespace vt {
+
+class Mesh;
+class Texture;
+
+// packs small rgba textures into one atlas texture, so meshes that used them can share a texture index (and batch)
+// NOTE: mesh tex coords are remapped into the entry's rect, so wrapping (tex coords outside [0, 1]) isn't supported
+class TextureAtlas
+{
+public:
+    struct Entry
+    {
+        Texture*   m_source; // not owned
+        glm::ivec2 m_pos;
+        glm::ivec2 m_dim;
+        bool       m_packed;
+    };
+
+    TextureAtlas(const std::string& name,
+                       glm::ivec2   dim     = glm::ivec2(DEFAULT_TEXTURE_ATLAS_SIZE),
+                       int          padding = DEFAULT_TEXTURE_ATLAS_PADDING);
+
+    bool can_add(const Texture* texture) const;
+    bool add(Texture* texture);
+    Texture* build(bool smooth = true);
+
+    // NOTE: owned by caller (e.g. Scene::add_texture)
+    Texture* get_texture() const
+    {
+        return m_texture;
+    }
+
+    int get_num_entries() const
+    {
+        return m_entries.size();
+    }
+    const Entry &get_entry(int index) const
+    {
+        return m_entries[index];
+    }
+    int find_entry(const Texture* source) const;
+
+    // xy = offset, zw = scale
+    glm::vec4 get_tex_coord_rect(int index) const;
+
+    // rewrites tex coords of a mesh (and its lods) textured by a packed source, then points it at the atlas (added to its material)
+    static bool can_remap(const Mesh* mesh);
+    bool remap(Mesh* mesh) const;
+
+private:
+    std::string        m_name;
+    glm::ivec2         m_dim;
+    int                m_padding;
+    Texture*           m_texture;
+    std::vector<Entry> m_entries;
+
+    void pack();
+};
+
+}
+
+#endif
@@ -22,10 +22,30 @@
 #include <Util.h>
 #include <glm/glm.hpp>
 #include <set>
-#include <tuple>
 
 namespace vt {
 
+// per-chain state for incremental (warm-started) ik
+struct IKChainState
+{
+    bool      m_has_prev_solution;
+    glm::vec3 m_prev_target;
+    glm::vec3 m_prev_end_effector_dir;
+    glm::vec3 m_prev_end_effector_tip;
+    bool      m_prev_converged;
+
+    // stats (for tuning iteration budgets)
+    int m_last_iters;
+    int m_total_iters;
+    int m_solve_count;
+    int m_skip_count;
+    int m_converge_count;
+
+    IKChainState();
+    void reset();
+    float get_avg_iters() const { return m_solve_count ? static_cast<float>(m_total_iters) / m_solve_count : 0; }
+};
+
 class TransformObject : public NamedObject
 {
 public:
@@ -34,18 +54,6 @@ public:
         JOINT_TYPE_PRISMATIC
     };
 
-    typedef enum { DEBUG_LINE_P1,
-                   DEBUG_LINE_P2,
-                   DEBUG_LINE_COLOR,
-                   DEBUG_LINE_LINEWIDTH } debug_line_attr_t;
-
-    // guide wires (for debug)
-    glm::vec3 m_debug_target_dir;
-    glm::vec3 m_debug_end_effector_tip_dir;
-    glm::vec3 m_debug_local_pivot;
-    glm::vec3 m_debug_local_target;
-    std::vector<std::tuple<glm::vec3, glm::vec3, glm::vec3, float>> m_debug_lines;
-
     TransformObject(const std::string& name,
                           glm::vec3    origin = glm::vec3(0),
                           glm::vec3    euler  = glm::vec3(0),
@@ -88,7 +96,7 @@ public:
     const glm::vec3 &get_joint_constraints_center() const        { return m_joint_constraints_center; }
     const glm::vec3 &get_joint_constraints_max_deviation() const { return m_joint_constraints_max_deviation; }
     euler_index_t get_hinge_type() const                         { return m_hinge_type; }
-    void set_joint_type(joint_type_t joint_type)                 { m_joint_type = joint_type; }
+    void set_joint_type(joint_type_t joint_type);
     void set_enable_joint_constraints(glm::ivec3 enable_joint_constraints);
     void set_joint_constraints_center(glm::vec3 joint_constraints_center)               { m_joint_constraints_center        = joint_constraints_center; }
     void set_joint_constraints_max_deviation(glm::vec3 joint_constraints_max_deviation) { m_joint_constraints_max_deviation = joint_constraints_max_deviation; }
@@ -110,7 +118,18 @@ public:
                       glm::vec3*       end_effector_dir,
                       int              iters,
                       float            accept_end_effector_distance,
-                      float            accept_avg_angle_distance);
+                      float            accept_avg_angle_distance,
+                      int*             iters_used = NULL);
+    bool solve_ik_ccd_incremental(TransformObject* root,
+                                  glm::vec3        local_end_effector_tip,
+                                  glm::vec3        target,
+                                  glm::vec3*       end_effector_dir,
+                                  int              max_iters,
+                                  float            accept_end_effector_distance,
+                                  float            accept_avg_angle_distance,
+                                  float            accept_target_delta);
+    const IKChainState &get_ik_chain_state() const { return m_ik_chain_state; }
+    void reset_ik_chain_state()                    { m_ik_chain_state.reset(); }
     void update_boid(glm::vec3 target,
                      float     forward_speed,
                      float     angle_delta,
@@ -141,6 +160,9 @@ protected:
     glm::vec3     m_joint_constraints_max_deviation;
     euler_index_t m_hinge_type;
 
+    // advanced features
+    IKChainState m_ik_chain_state; // only meaningful for end effectors
+
     // caching
     void mark_dirty_transform() {
         m_is_dirty_transform        = true;
@@ -154,7 +176,22 @@ private:
     bool m_is_dirty_normal_transform;
 
     // joint constraints
+    typedef void (TransformObject::*joint_constraints_kernel_t)();
+    joint_constraints_kernel_t m_joint_constraints_kernel; // selected by setters, so per-iteration path has no mode branches
     void check_roll_hinge();
+    void update_joint_constraints_kernel();
+    void apply_free_joint_constraints() {}
+    template<int N>                    void apply_euler_joint_constraints();
+    template<int N>                    void apply_prismatic_joint_constraints();
+    template<euler_index_t HINGE_TYPE> void apply_hinge_joint_constraints();
+    template<euler_index_t HINGE_TYPE> void recalibrate_heading_in_parent_system_impl();
+    template<euler_index_t HINGE_TYPE> void apply_hinge_constraints_within_plane_of_free_rotation_impl();
+
+    // advanced features
+    void add_ik_guide_wires(TransformObject* root,
+                            glm::vec3        local_end_effector_tip,
+                            glm::vec3        target,
+                            glm::vec3*       end_effector_dir);
 
     // optional advanced features
     virtual void flatten(glm::mat4* basis = NULL) {}
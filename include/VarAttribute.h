@@ -31,8 +31,8 @@ class VarAttribute : public IdentObject
 public:
     VarAttribute(const Program* program, const GLchar* name);
     virtual ~VarAttribute();
-    void enable_vertex_attrib_array() const;
-    void disable_vertex_attrib_array() const;
+    void enable_vertex_attrib_array();
+    void disable_vertex_attrib_array();
     bool is_enabled() const { return m_is_enabled; }
     void vertex_attrib_pointer(Buffer*       buffer,
                                GLint         size,
@@ -40,6 +40,7 @@ public:
                                GLboolean     normalized,
                                GLsizei       stride,
                                const GLvoid* pointer) const;
+    void vertex_attrib_4f(GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3);
 
 private:
     bool m_is_enabled;
@@ -24,9 +24,13 @@
 #define _CREATE_SHADER_H
 
 #include <GL/glew.h>
+#include <string>
+#include <vector>
 
 char* file_read(const char* filename);
+char* file_read_with_includes(const char* filename, std::vector<std::string>* include_files = NULL);
 void print_log(GLuint object);
+GLuint create_shader_deferred(const char* filename, GLenum type);
 GLuint create_shader(const char* filename, GLenum type);
 GLuint create_program(const char* vertexfile, const char* fragmentfile);
 GLuint create_gs_program(const char* vertexfile, const char* geometryfile, const char* fragmentfile, GLint input, GLint output, GLint vertices);
@@ -0,0 +1,354 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <AssetLoader.h>
+#include <File3ds.h>
+#include <FileCooked.h>
+#include <FilePng.h>
+#include <Mesh.h>
+#include <Texture.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+
+namespace vt {
+
+// pixels decoded by workers, waiting for the gl thread
+// NOTE: cooked images point into a mapped cooked file, decoded pixels are owned
+struct DecodedImages
+{
+    std::vector<CookedImage> m_images;
+    std::vector<CookedFile>  m_cooked_files;
+    int                      m_num_pending_uploads;
+
+    DecodedImages(int num_images)
+        : m_images(num_images),
+          m_cooked_files(num_images),
+          m_num_pending_uploads(num_images)
+    {}
+    ~DecodedImages()
+    {
+        for(int i = 0; i < static_cast<int>(m_images.size()); i++) {
+            if(m_images[i].m_data && !m_cooked_files[i].is_open()) {
+                delete[] m_images[i].m_data;
+            }
+        }
+    }
+    void decode(int index, const std::string& png_filename, bool use_cooked_cache)
+    {
+        CookedImage* image = &m_images[index];
+        if(use_cooked_cache) {
+            if(!load_png_cached(png_filename, &m_cooked_files[index], image)) {
+                image->m_data = NULL;
+            }
+            return;
+        }
+        unsigned char* pixels = NULL;
+        size_t         width  = 0;
+        size_t         height = 0;
+        if(!read_png(png_filename, (void**)&pixels, &width, &height)) {
+            return;
+        }
+        image->m_dim        = glm::ivec2(width, height);
+        image->m_format     = COOKED_FORMAT_RGBA;
+        image->m_num_levels = 1;
+        image->m_data       = pixels;
+    }
+    bool is_valid() const
+    {
+        for(int i = 0; i < static_cast<int>(m_images.size()); i++) {
+            if(!m_images[i].m_data ||
+               m_images[i].m_dim        != m_images[0].m_dim ||
+               m_images[i].m_format     != m_images[0].m_format ||
+               m_images[i].m_num_levels != m_images[0].m_num_levels)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // NOTE: NULL if the cooked format isn't supported by the driver, caller falls back to decoding the png
+    Texture* create_texture(const std::string& name, bool smooth) const
+    {
+        const CookedImage& image = m_images[0];
+        if(image.m_format == COOKED_FORMAT_RGBA) {
+            if(m_images.size() == 6) {
+                return new Texture(name,
+                                   image.m_dim,
+                                   m_images[0].m_data,
+                                   m_images[1].m_data,
+                                   m_images[2].m_data,
+                                   m_images[3].m_data,
+                                   m_images[4].m_data,
+                                   m_images[5].m_data,
+                                   true); // mipmap
+            }
+            return new Texture(name, Texture::RGBA, image.m_dim, smooth, Texture::RGBA, image.m_data, smooth); // mipmap if smooth
+        }
+        Texture::compressed_format_t compressed_format = Texture::BC1;
+        switch(image.m_format) {
+            case COOKED_FORMAT_BC1: compressed_format = Texture::BC1; break;
+            case COOKED_FORMAT_BC3: compressed_format = Texture::BC3; break;
+            case COOKED_FORMAT_BC7: compressed_format = Texture::BC7; break;
+            default:
+                return NULL;
+        }
+        if(!Texture::is_compressed_format_supported(compressed_format)) {
+            return NULL;
+        }
+        const unsigned char* face_data[6] = {};
+        for(int i = 0; i < static_cast<int>(m_images.size()); i++) {
+            face_data[i] = m_images[i].m_data;
+        }
+        return new Texture(name, compressed_format, image.m_dim, image.m_num_levels, m_images.size(), face_data);
+    }
+};
+
+AssetLoader::AssetLoader(int num_threads, bool use_cooked_cache)
+    : m_use_cooked_cache(use_cooked_cache),
+      m_shutdown(false),
+      m_num_jobs(0),
+      m_num_decoded(0),
+      m_num_uploaded(0)
+{
+    if(!num_threads) {
+        num_threads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), MAX_ASSET_LOADER_THREADS));
+    }
+    for(int i = 0; i < num_threads; i++) {
+        m_threads.push_back(std::thread(&AssetLoader::worker, this));
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_decode_cond.notify_all();
+    for(std::vector<std::thread>::iterator p = m_threads.begin(); p != m_threads.end(); p++) {
+        (*p).join();
+    }
+}
+
+void AssetLoader::submit(task_t decode, task_t upload)
+{
+    Job job;
+    job.m_decode = decode;
+    job.m_upload = upload;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decode_queue.push_back(job);
+        m_num_jobs++;
+    }
+    m_decode_cond.notify_one();
+}
+
+void AssetLoader::load_texture(const std::string& name,
+                               const std::string& png_filename,
+                                     Texture**    texture,
+                                     bool         smooth)
+{
+    DecodedImages* images           = new DecodedImages(1);
+    bool           use_cooked_cache = m_use_cooked_cache;
+    submit([=]() {
+        images->decode(0, png_filename, use_cooked_cache);
+    }, [=]() {
+        *texture = NULL;
+        if(!images->is_valid()) {
+            std::cout << "failed to decode " << png_filename << std::endl;
+        } else {
+            *texture = images->create_texture(name, smooth);
+        }
+        if(!*texture) {
+            *texture = new Texture(name, png_filename, smooth); // same result as synchronous load
+        }
+        delete images;
+    });
+}
+
+// NOTE: each face decodes as its own job, texture is created by whichever face uploads last
+void AssetLoader::load_cube_map(const std::string& name,
+                                const std::string& png_filename_pos_x,
+                                const std::string& png_filename_neg_x,
+                                const std::string& png_filename_pos_y,
+                                const std::string& png_filename_neg_y,
+                                const std::string& png_filename_pos_z,
+                                const std::string& png_filename_neg_z,
+                                      Texture**    texture)
+{
+    std::string png_filenames[] = {png_filename_pos_x,
+                                   png_filename_neg_x,
+                                   png_filename_pos_y,
+                                   png_filename_neg_y,
+                                   png_filename_pos_z,
+                                   png_filename_neg_z};
+    DecodedImages* images           = new DecodedImages(6);
+    bool           use_cooked_cache = m_use_cooked_cache;
+    for(int i = 0; i < 6; i++) {
+        std::string png_filename = png_filenames[i];
+        submit([=]() {
+            images->decode(i, png_filename, use_cooked_cache);
+        }, [=]() {
+            if(--images->m_num_pending_uploads) {
+                return;
+            }
+            *texture = NULL;
+            if(!images->is_valid()) {
+                std::cout << "failed to decode cube map " << name << std::endl;
+            } else {
+                *texture = images->create_texture(name, true);
+            }
+            if(!*texture) {
+                *texture = new Texture(name,
+                                       png_filenames[0],
+                                       png_filenames[1],
+                                       png_filenames[2],
+                                       png_filenames[3],
+                                       png_filenames[4],
+                                       png_filenames[5]); // same result as synchronous load
+            }
+            delete images;
+        });
+    }
+}
+
+// NOTE: parse, normal generation, optimization and lod generation all run on the worker (or are skipped if cooked)
+void AssetLoader::load_3ds(const std::string&  filename,
+                                 int           index,
+                           std::vector<Mesh*>* meshes,
+                                 int           num_lods,
+                                 bool          compressed)
+{
+    std::vector<Mesh*>* decoded_meshes   = new std::vector<Mesh*>;
+    bool                use_cooked_cache = m_use_cooked_cache;
+    submit([=]() {
+        if(use_cooked_cache) {
+            load_3ds_cached(filename, index, num_lods, decoded_meshes);
+            return;
+        }
+        File3ds::load3ds(filename, index, decoded_meshes);
+        for(std::vector<Mesh*>::iterator p = decoded_meshes->begin(); p != decoded_meshes->end(); p++) {
+            if(num_lods) {
+                (*p)->generate_lods(num_lods);
+            }
+        }
+    }, [=]() {
+        for(std::vector<Mesh*>::iterator p = decoded_meshes->begin(); p != decoded_meshes->end(); p++) {
+            (*p)->set_compressed(compressed);
+            for(int i = 0; i <= (*p)->get_num_lods(); i++) {
+                (*p)->get_lod(i)->init_buffers();
+            }
+            meshes->push_back(*p);
+        }
+        delete decoded_meshes;
+    });
+}
+
+int AssetLoader::poll(bool wait)
+{
+    std::deque<Job> ready_jobs;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if(wait) {
+            while(m_upload_queue.empty() && m_num_decoded < m_num_jobs) {
+                m_upload_cond.wait(lock);
+            }
+        }
+        ready_jobs.swap(m_upload_queue);
+    }
+    for(std::deque<Job>::iterator p = ready_jobs.begin(); p != ready_jobs.end(); p++) {
+        if((*p).m_upload) {
+            (*p).m_upload();
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_num_uploaded += ready_jobs.size();
+    return ready_jobs.size();
+}
+
+void AssetLoader::finish()
+{
+    while(!is_done()) {
+        poll(true);
+    }
+}
+
+int AssetLoader::get_num_jobs() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_jobs;
+}
+
+int AssetLoader::get_num_decoded() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_decoded;
+}
+
+int AssetLoader::get_num_uploaded() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_uploaded;
+}
+
+float AssetLoader::get_progress() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!m_num_jobs) {
+        return 1;
+    }
+    return static_cast<float>(m_num_decoded + m_num_uploaded) / (m_num_jobs * 2);
+}
+
+bool AssetLoader::is_done() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_uploaded == m_num_jobs;
+}
+
+void AssetLoader::worker()
+{
+    while(true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_decode_queue.empty() && !m_shutdown) {
+                m_decode_cond.wait(lock);
+            }
+            if(m_decode_queue.empty()) {
+                return;
+            }
+            job = m_decode_queue.front();
+            m_decode_queue.pop_front();
+        }
+        if(job.m_decode) {
+            job.m_decode();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_upload_queue.push_back(job);
+            m_num_decoded++;
+        }
+        m_upload_cond.notify_one();
+    }
+}
+
+}
@@ -193,6 +193,21 @@ const glm::mat4 &Camera::get_projection_transform()
     return m_projection_transform;
 }
 
+// fraction of viewport height covered by a world-space sphere
+// NOTE: reads vertical scale straight from projection transform, so it agrees with whatever fov / zoom the camera uses
+float Camera::get_projected_size(glm::vec3 center, float radius)
+{
+    float vertical_scale = get_projection_transform()[1][1];
+    if(m_projection_mode == PROJECTION_MODE_ORTHO) {
+        return radius * vertical_scale;
+    }
+    float depth = glm::dot(center - m_origin, get_dir());
+    if(depth <= m_near_plane) {
+        return BIG_NUMBER; // camera inside or in front of sphere
+    }
+    return radius * vertical_scale / depth;
+}
+
 void Camera::update_projection_transform()
 {
     if(m_projection_mode == PROJECTION_MODE_PERSPECTIVE) {
@@ -0,0 +1,95 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <DebugArena.h>
+#include <TransformObject.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <tuple>
+
+namespace vt {
+
+DebugArena::DebugArena()
+    : m_consumer_count(0)
+{
+}
+
+// clear() keeps capacity, so steady-state recording doesn't allocate
+void DebugArena::begin_frame()
+{
+    m_ik_guide_wires.clear();
+    m_debug_lines.clear();
+}
+
+void DebugArena::add_ik_guide_wire(const TransformObject* segment,
+                                   glm::vec3              abs_target,
+                                   glm::vec3              abs_end_effector_tip)
+{
+    if(!is_enabled()) {
+        return;
+    }
+
+    // overwrite record from earlier ik iteration (chains are short)
+    IKGuideWire* guide_wire = NULL;
+    for(ik_guide_wires_t::reverse_iterator p = m_ik_guide_wires.rbegin(); p != m_ik_guide_wires.rend(); ++p) {
+        if((*p).m_segment == segment) {
+            guide_wire = &(*p);
+            break;
+        }
+    }
+    if(!guide_wire) {
+        m_ik_guide_wires.push_back(IKGuideWire());
+        guide_wire = &m_ik_guide_wires.back();
+    }
+
+    glm::vec3 local_target               = segment->from_origin_in_parent_system(abs_target);
+    glm::vec3 local_target_dir           = safe_normalize(local_target);
+    glm::vec3 local_end_effector_tip_dir = safe_normalize(segment->from_origin_in_parent_system(abs_end_effector_tip));
+    glm::vec3 local_arc_delta_dir        = safe_normalize(local_target_dir - local_end_effector_tip_dir);
+    glm::vec3 local_arc_midpoint_dir     = safe_normalize((local_target_dir + local_end_effector_tip_dir) * 0.5f);
+
+    guide_wire->m_segment              = segment;
+    guide_wire->m_target_dir           = local_target_dir;
+    guide_wire->m_end_effector_tip_dir = local_end_effector_tip_dir;
+    guide_wire->m_local_pivot          = glm::cross(local_arc_delta_dir, local_arc_midpoint_dir);
+    guide_wire->m_local_target         = local_target;
+}
+
+void DebugArena::add_debug_line(const TransformObject* owner,
+                                glm::vec3              p1,
+                                glm::vec3              p2,
+                                glm::vec3              color,
+                                float                  linewidth)
+{
+    if(!is_enabled()) {
+        return;
+    }
+    m_debug_lines.push_back(owned_debug_line_t(owner, debug_line_t(p1, p2, color, linewidth)));
+}
+
+const IKGuideWire* DebugArena::find_ik_guide_wire(const TransformObject* segment) const
+{
+    for(ik_guide_wires_t::const_reverse_iterator p = m_ik_guide_wires.rbegin(); p != m_ik_guide_wires.rend(); ++p) {
+        if((*p).m_segment == segment) {
+            return &(*p);
+        }
+    }
+    return NULL;
+}
+
+}
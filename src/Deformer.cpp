@@ -0,0 +1,185 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <Deformer.h>
+#include <MeshBase.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+namespace vt {
+
+Deformer::Deformer(deformer_type_t type,
+                   glm::vec3       origin,
+                   glm::vec4       params)
+    : m_type(type),
+      m_origin(origin),
+      m_params(params)
+{
+}
+
+// cpu fallback (same math as deformer.inc.glsl)
+void Deformer::apply(MeshBase* mesh)
+{
+    size_t num_vertex = mesh->get_num_vertex();
+    if(m_rest_vert_coords.size() != num_vertex) {
+        m_rest_vert_coords.assign( mesh->get_vert_coords(),  mesh->get_vert_coords()  + num_vertex);
+        m_rest_vert_normals.assign(mesh->get_vert_normals(), mesh->get_vert_normals() + num_vertex);
+    }
+    glm::vec3* vert_coords  = mesh->get_vert_coords();
+    glm::vec3* vert_normals = mesh->get_vert_normals();
+    switch(m_type) {
+        case DEFORMER_TYPE_NONE:
+            for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                vert_coords[i]  = m_rest_vert_coords[i];
+                vert_normals[i] = m_rest_vert_normals[i];
+            }
+            break;
+        case DEFORMER_TYPE_RIPPLE:
+            {
+                float amplitude  = m_params.x;
+                float wavenumber = (PI * 2) / m_params.y;
+                float phase      = m_params.z;
+                for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                    glm::vec3 local  = m_rest_vert_coords[i] - m_origin;
+                    float     radius = sqrt(local.x * local.x + local.z * local.z);
+                    float     angle  = radius * wavenumber + phase;
+                    float     slope  = (radius > EPSILON) ? cos(angle) * amplitude * wavenumber / radius : 0;
+                    vert_coords[i]   = glm::vec3(m_rest_vert_coords[i].x, m_origin.y + sin(angle) * amplitude, m_rest_vert_coords[i].z);
+                    vert_normals[i]  = safe_normalize(glm::vec3(-local.x * slope, 1, -local.z * slope));
+                }
+            }
+            break;
+        case DEFORMER_TYPE_TWIST:
+            for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                glm::vec3 local = m_rest_vert_coords[i] - m_origin;
+                glm::vec3 n     = m_rest_vert_normals[i];
+                float     theta = local.y * m_params.x;
+                float     c     = cos(theta);
+                float     s     = sin(theta);
+                vert_coords[i]  = m_origin + glm::vec3(c * local.x - s * local.z, local.y, s * local.x + c * local.z);
+                vert_normals[i] = glm::vec3(c * n.x - s * n.z, n.y, s * n.x + c * n.z);
+            }
+            break;
+        case DEFORMER_TYPE_BEND:
+            {
+                float curvature = m_params.x;
+                if(fabs(curvature) < EPSILON) {
+                    for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                        vert_coords[i]  = m_rest_vert_coords[i];
+                        vert_normals[i] = m_rest_vert_normals[i];
+                    }
+                    break;
+                }
+                float bend_radius = 1 / curvature;
+                for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                    glm::vec3 local = m_rest_vert_coords[i] - m_origin;
+                    glm::vec3 n     = m_rest_vert_normals[i];
+                    float     theta = local.x * curvature;
+                    float     c     = cos(theta);
+                    float     s     = sin(theta);
+                    vert_coords[i]  = m_origin + glm::vec3((bend_radius - local.y) * s,
+                                                           bend_radius - (bend_radius - local.y) * c,
+                                                           local.z);
+                    vert_normals[i] = glm::vec3(c * n.x - s * n.y, s * n.x + c * n.y, n.z);
+                }
+            }
+            break;
+        case DEFORMER_TYPE_NOISE:
+            {
+                float amplitude = m_params.x;
+                float frequency = m_params.y;
+                float phase     = m_params.z;
+                for(int i = 0; i < static_cast<int>(num_vertex); i++) {
+                    glm::vec3 local = m_rest_vert_coords[i] - m_origin;
+                    glm::vec3 n     = m_rest_vert_normals[i];
+                    glm::vec3 q     = local * frequency + glm::vec3(phase);
+                    glm::vec3 sq(sin(q.x), sin(q.y), sin(q.z));
+                    glm::vec3 cq(cos(q.x), cos(q.y), cos(q.z));
+                    float     displacement = sq.x * sq.y * sq.z * amplitude;
+                    glm::vec3 grad = glm::vec3(cq.x * sq.y * sq.z,
+                                               sq.x * cq.y * sq.z,
+                                               sq.x * sq.y * cq.z) * (amplitude * frequency);
+                    vert_coords[i]  = m_rest_vert_coords[i] + n * displacement;
+                    vert_normals[i] = safe_normalize(n - (grad - n * glm::dot(grad, n)));
+                }
+            }
+            break;
+    }
+    mesh->update_bbox();
+}
+
+void Deformer::inflate_bbox(glm::vec3* min, glm::vec3* max) const
+{
+    glm::vec3 local_min = *min - m_origin;
+    glm::vec3 local_max = *max - m_origin;
+    glm::vec3 reach     = glm::max(glm::abs(local_min), glm::abs(local_max));
+    switch(m_type) {
+        case DEFORMER_TYPE_NONE:
+            break;
+        case DEFORMER_TYPE_RIPPLE:
+            {
+                float amplitude = fabs(m_params.x);
+                min->y = std::min(min->y, m_origin.y - amplitude);
+                max->y = std::max(max->y, m_origin.y + amplitude);
+            }
+            break;
+        case DEFORMER_TYPE_TWIST:
+            {
+                float radius = sqrt(reach.x * reach.x + reach.z * reach.z); // spin about y through origin
+                min->x = std::min(min->x, m_origin.x - radius);
+                min->z = std::min(min->z, m_origin.z - radius);
+                max->x = std::max(max->x, m_origin.x + radius);
+                max->z = std::max(max->z, m_origin.z + radius);
+            }
+            break;
+        case DEFORMER_TYPE_BEND:
+            {
+                float curvature = fabs(m_params.x);
+                if(curvature < EPSILON) {
+                    break;
+                }
+                // NOTE: |sin(t)| <= |t| and 1 - cos(t) <= min(t^2 / 2, 2) keep this tight for gentle bends
+                float max_theta     = reach.x * curvature;
+                float one_minus_cos = std::min(max_theta * max_theta / 2, 2.0f);
+                float reach_x       = reach.x + reach.y * max_theta;
+                float reach_y       = reach.y + std::min(reach.x * max_theta / 2, 2 / curvature) + reach.y * one_minus_cos;
+                min->x = std::min(min->x, m_origin.x - reach_x);
+                min->y = std::min(min->y, m_origin.y - reach_y);
+                max->x = std::max(max->x, m_origin.x + reach_x);
+                max->y = std::max(max->y, m_origin.y + reach_y);
+            }
+            break;
+        case DEFORMER_TYPE_NOISE:
+            {
+                glm::vec3 amplitude(fabs(m_params.x)); // along unit normals
+                *min -= amplitude;
+                *max += amplitude;
+            }
+            break;
+    }
+}
+
+void Deformer::reset_rest_pose()
+{
+    m_rest_vert_coords.clear();
+    m_rest_vert_normals.clear();
+}
+
+}
@@ -17,12 +17,25 @@
 
 #include <File3ds.h>
 #include <MeshBase.h>
+#include <Modifiers.h>
 #include <Util.h>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
+#include <algorithm>
 #include <string>
+#include <iostream>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CHUNK_HEADER_SIZE  (sizeof(uint16_t) + sizeof(uint32_t))
+#define VERTEX_RECORD_SIZE (sizeof(float) * 3)
+#define FACE_RECORD_SIZE   (sizeof(uint16_t) * 4) // tri_indices + tri_indices info
+#define READ_BUFFER_SIZE   (1 << 16)
 
 namespace vt {
 
@@ -32,12 +45,46 @@ class Mesh;
 
 Mesh* cast_mesh(MeshBase* mesh);
 
-static void read_string(FILE* stream, char* buf)
+// where a trimesh's lists live in the file, recorded in a single walk of the chunk tree
+struct TriMeshChunks
+{
+    std::string m_name;
+    uint32_t    m_vertex_list; // offset of list (past list size)
+    uint32_t    m_face_list;   // offset of list (past list size)
+    int         m_num_vertex;
+    int         m_num_tri;
+};
+
+static std::string read_string(const uint8_t* data, uint32_t* pos, uint32_t end)
 {
-    int i = 0;
+    uint32_t begin = *pos;
+    while(*pos < end && data[*pos]) {
+        (*pos)++;
+    }
+    std::string s(reinterpret_cast<const char*>(&data[begin]), *pos - begin);
+    if(*pos < end) {
+        (*pos)++; // skip terminator
+    }
+    return s;
+}
+
+// NOTE: used for inputs that can't be mapped (pipes, character devices), so size isn't known up front
+static bool read_stream(const std::string& filename, std::vector<uint8_t>* buf)
+{
+    FILE* stream = fopen(filename.c_str(), "rb");
+    if(!stream) {
+        return false;
+    }
+    size_t size = 0;
+    size_t bytes_read = 0;
     do {
-        buf[i] = fgetc(stream);
-    } while(buf[i++]);
+        buf->resize(size + READ_BUFFER_SIZE);
+        bytes_read = fread(&(*buf)[size], sizeof(uint8_t), READ_BUFFER_SIZE, stream);
+        size += bytes_read;
+    } while(bytes_read == READ_BUFFER_SIZE);
+    buf->resize(size);
+    fclose(stream);
+    return true;
 }
 
 bool File3ds::load3ds(const std::string& filename, int index, std::vector<Mesh*>* meshes)
@@ -57,125 +104,194 @@ bool File3ds::load3ds_impl(const std::string& filename, int index, std::vector<M
     if(!meshes) {
         return false;
     }
-    FILE* stream = fopen(filename.c_str(), "rb");
-    if(stream) {
-        glm::vec3 global_min(BIG_NUMBER), global_max(-BIG_NUMBER);
-        fseek(stream, 0, SEEK_END);
-        uint32_t size = ftell(stream);
-        rewind(stream);
-        uint32_t main_end = enter_chunk(stream, MAIN3DS, size);
-        uint32_t edit_end = enter_chunk(stream, EDIT3DS, main_end);
-        int count = 0;
-        while(ftell(stream) < edit_end) {
-            uint32_t object_end = enter_chunk(stream, EDIT_OBJECT, edit_end);
-            char buf[80] = {};
-            read_string(stream, buf); // read object name
-            int object_type = read_short(stream);
-            fseek(stream, -sizeof(uint16_t), SEEK_CUR); // rewind
-            if(object_type == OBJ_TRIMESH) {
-                if(count != index && index != -1) {
-                    break;
+
+    // =========================================
+    // map file, or fall back to buffered reads
+    // =========================================
+
+    const uint8_t*       data        = NULL;
+    uint32_t             size        = 0;
+    void*                mapped      = MAP_FAILED;
+    size_t               mapped_size = 0;
+    std::vector<uint8_t> buf;
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd != -1) {
+        struct stat st;
+        if(fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+            mapped_size = st.st_size;
+            mapped      = mmap(NULL, mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd); // mapping stays valid after close
+    }
+    if(mapped != MAP_FAILED) {
+        madvise(mapped, mapped_size, MADV_SEQUENTIAL);
+        data = static_cast<const uint8_t*>(mapped);
+        size = mapped_size;
+    } else if(read_stream(filename, &buf) && !buf.empty()) {
+        data = &buf[0];
+        size = buf.size();
+    }
+    if(!data) {
+        return true;
+    }
+
+    parse(data, size, index, meshes);
+
+    if(mapped != MAP_FAILED) {
+        munmap(mapped, mapped_size);
+    }
+
+    glm::vec3 global_min(BIG_NUMBER), global_max(-BIG_NUMBER);
+    for(std::vector<MeshBase*>::iterator p = meshes->begin(); p != meshes->end(); ++p) {
+        (*p)->update_bbox();
+        glm::vec3 local_min(BIG_NUMBER), local_max(-BIG_NUMBER);
+        (*p)->get_min_max(&local_min, &local_max);
+        global_min = glm::min(global_min, local_min);
+        global_max = glm::max(global_max, local_max);
+    }
+    glm::vec3 global_center = (global_min + global_max) * 0.5f;
+    for(std::vector<MeshBase*>::iterator p = meshes->begin(); p != meshes->end(); ++p) {
+        (*p)->set_axis(global_center);
+        (*p)->update_normals_and_tangents();
+        (*p)->update_bbox();
+#ifdef DEBUG
+        float acmr_before = 0, acmr_after = 0;
+        mesh_optimize(*p, false, &acmr_before, &acmr_after);
+        std::cout << "FILE: " << filename << ", MESH: " << (p - meshes->begin()) << ", ACMR: " << acmr_before << " -> " << acmr_after << std::endl;
+#else
+        mesh_optimize(*p);
+#endif
+    }
+    return true;
+}
+
+void File3ds::parse(const uint8_t* data, uint32_t size, int index, std::vector<MeshBase*>* meshes)
+{
+    // ========================================
+    // walk chunk tree once into trimesh index
+    // ========================================
+
+    std::vector<TriMeshChunks> tri_mesh_chunks;
+    uint32_t pos = 0;
+    uint32_t main_end = enter_chunk(data, &pos, MAIN3DS, size);
+    uint32_t edit_end = main_end ? enter_chunk(data, &pos, EDIT3DS, main_end) : 0;
+    int count = 0;
+    while(pos < edit_end) {
+        uint32_t object_end = enter_chunk(data, &pos, EDIT_OBJECT, edit_end);
+        if(!object_end) {
+            break;
+        }
+        TriMeshChunks entry;
+        entry.m_name        = read_string(data, &pos, object_end);
+        entry.m_vertex_list = 0;
+        entry.m_face_list   = 0;
+        entry.m_num_vertex  = 0;
+        entry.m_num_tri     = 0;
+        uint16_t object_type = 0;
+        uint32_t mesh_end    = 0;
+        if(next_chunk(data, &pos, object_end, &object_type, &mesh_end) && object_type == OBJ_TRIMESH) {
+            if(index == -1 || count == index) {
+                uint32_t mesh_pos = pos + CHUNK_HEADER_SIZE;
+                uint16_t chunk_id  = 0;
+                uint32_t chunk_end = 0;
+                while(next_chunk(data, &mesh_pos, mesh_end, &chunk_id, &chunk_end)) {
+                    uint32_t list_pos = mesh_pos + CHUNK_HEADER_SIZE;
+                    if(list_pos + sizeof(uint16_t) <= chunk_end) {
+                        int      num_items  = read_short(&data[list_pos]);
+                        uint32_t list_begin = list_pos + sizeof(uint16_t);
+                        if(chunk_id == TRI_VERTEXL && list_begin + num_items * VERTEX_RECORD_SIZE <= chunk_end) {
+                            entry.m_vertex_list = list_begin;
+                            entry.m_num_vertex  = num_items;
+                        } else if(chunk_id == TRI_FACEL && list_begin + num_items * FACE_RECORD_SIZE <= chunk_end) {
+                            entry.m_face_list = list_begin;
+                            entry.m_num_tri   = num_items;
+                        }
+                    }
+                    mesh_pos = chunk_end;
                 }
-                uint32_t mesh_end = enter_chunk(stream, OBJ_TRIMESH, object_end);
-                if(mesh_end) {
-                    uint32_t mesh_base = ftell(stream);
-
-                    enter_chunk(stream, TRI_VERTEXL, mesh_end);
-                    int num_vertex = read_short(stream);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    enter_chunk(stream, TRI_FACEL, mesh_end);
-                    int num_tri = read_short(stream);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    MeshBase* mesh = alloc_mesh_base(buf, num_vertex, num_tri);
-
-                    enter_chunk(stream, TRI_VERTEXL, mesh_end);
-                    read_vertices(stream, mesh);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    enter_chunk(stream, TRI_FACEL, mesh_end);
-                    read_faces(stream, mesh);
-                    fseek(stream, mesh_base, SEEK_SET);
-
-                    mesh->update_bbox();
-                    glm::vec3 local_min(BIG_NUMBER), local_max(-BIG_NUMBER);
-                    mesh->get_min_max(&local_min, &local_max);
-                    global_min = glm::min(global_min, local_min);
-                    global_max = glm::max(global_max, local_max);
-                    meshes->push_back(mesh);
+                if(entry.m_vertex_list && entry.m_face_list) {
+                    tri_mesh_chunks.push_back(entry);
                 }
-                fseek(stream, mesh_end, SEEK_SET);
-                count++;
             }
-            fseek(stream, object_end, SEEK_SET);
-        }
-        fclose(stream);
-        glm::vec3 global_center = (global_min + global_max) * 0.5f;
-        for(std::vector<MeshBase*>::iterator p = meshes->begin(); p != meshes->end(); ++p) {
-            (*p)->set_axis(global_center);
-            (*p)->update_normals_and_tangents();
-            (*p)->update_bbox();
+            count++;
         }
+        pos = object_end;
     }
+
+    // =====================================================
+    // bulk-convert vertex/face lists straight into meshes
+    // =====================================================
+
+    for(std::vector<TriMeshChunks>::iterator p = tri_mesh_chunks.begin(); p != tri_mesh_chunks.end(); ++p) {
+        MeshBase* mesh = alloc_mesh_base((*p).m_name, (*p).m_num_vertex, (*p).m_num_tri);
+        read_vertices(&data[(*p).m_vertex_list], mesh);
+        read_faces(&data[(*p).m_face_list], mesh);
+        meshes->push_back(mesh);
+    }
+}
+
+// NOTE: returns false at end of parent chunk, or if the header is truncated or the size overruns the parent
+bool File3ds::next_chunk(const uint8_t* data, uint32_t* pos, uint32_t parent_end, uint16_t* chunk_id, uint32_t* chunk_end)
+{
+    if(*pos + CHUNK_HEADER_SIZE > parent_end) {
+        return false;
+    }
+    uint32_t chunk_size = read_long(&data[*pos + sizeof(uint16_t)]);
+    if(chunk_size < CHUNK_HEADER_SIZE || chunk_size > parent_end - *pos) {
+        return false;
+    }
+    *chunk_id  = read_short(&data[*pos]);
+    *chunk_end = *pos + chunk_size;
     return true;
 }
 
-uint32_t File3ds::enter_chunk(FILE* stream, uint32_t chunk_id, uint32_t chunk_end)
+uint32_t File3ds::enter_chunk(const uint8_t* data, uint32_t* pos, uint32_t chunk_id, uint32_t parent_end)
 {
-    uint32_t offset = 0;
-    while(ftell(stream) < chunk_end) {
-        uint32_t _chunk_id = read_short(stream);
-        uint32_t chunk_size = read_long(stream);
+    uint16_t _chunk_id = 0;
+    uint32_t chunk_end = 0;
+    while(next_chunk(data, pos, parent_end, &_chunk_id, &chunk_end)) {
         if(_chunk_id == chunk_id) {
-            offset = -(sizeof(uint16_t) + sizeof(uint32_t)) + chunk_size;
-            break;
-        } else {
-            fseek(stream, -(sizeof(uint16_t) + sizeof(uint32_t)), SEEK_CUR); // rewind
-            fseek(stream, chunk_size, SEEK_CUR); // skip this chunk
+            *pos += CHUNK_HEADER_SIZE;
+            return chunk_end;
         }
+        *pos = chunk_end; // skip this chunk
     }
-    return ftell(stream) + offset;
+    *pos = parent_end;
+    return 0;
 }
 
-void File3ds::read_vertices(FILE* stream, MeshBase* mesh)
+void File3ds::read_vertices(const uint8_t* vertex_list, MeshBase* mesh)
 {
-    float* vert_coord = new float[3];
-    fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip list size
-    size_t num_vertex = mesh->get_num_vertex();
+    size_t     num_vertex  = mesh->get_num_vertex();
+    glm::vec3* vert_coords = mesh->get_vert_coords();
+    memcpy(vert_coords, vertex_list, num_vertex * VERTEX_RECORD_SIZE);
     for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-        fread(vert_coord, sizeof(float), 3, stream);
-        mesh->set_vert_coord(i, glm::vec3(vert_coord[0], vert_coord[2], vert_coord[1]));
+        std::swap(vert_coords[i].y, vert_coords[i].z); // z-up to y-up
     }
-    delete[] vert_coord;
 }
 
-void File3ds::read_faces(FILE* stream, MeshBase* mesh)
+void File3ds::read_faces(const uint8_t* face_list, MeshBase* mesh)
 {
-    uint16_t* tri_indices = new uint16_t[3];
-    fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip list size
-    size_t num_tri = mesh->get_num_tri();
+    size_t    num_tri     = mesh->get_num_tri();
+    uint16_t* tri_indices = mesh->get_tri_indices();
     for(int i = 0; i < static_cast<int>(num_tri); i++) {
-        fread(tri_indices, sizeof(uint16_t), 3, stream);
-        mesh->set_tri_indices(i, glm::ivec3(tri_indices[0], tri_indices[2], tri_indices[1]));
-        fseek(stream, sizeof(uint16_t), SEEK_CUR); // skip tri_indices info
+        uint16_t face_record[4]; // tri_indices + tri_indices info
+        memcpy(face_record, &face_list[i * FACE_RECORD_SIZE], FACE_RECORD_SIZE);
+        tri_indices[i * 3 + 0] = face_record[0];
+        tri_indices[i * 3 + 1] = face_record[2];
+        tri_indices[i * 3 + 2] = face_record[1];
     }
-    delete[] tri_indices;
 }
 
-uint16_t File3ds::read_short(FILE* stream)
+uint16_t File3ds::read_short(const uint8_t* data)
 {
-    uint8_t lo_byte = 0;
-    uint8_t hi_byte = 0;
-    fread(&lo_byte, sizeof(uint8_t), 1, stream);
-    fread(&hi_byte, sizeof(uint8_t), 1, stream);
-    return MAKEWORD(lo_byte, hi_byte);
+    return MAKEWORD(data[0], data[1]);
 }
 
-uint32_t File3ds::read_long(FILE* stream)
+uint32_t File3ds::read_long(const uint8_t* data)
 {
-    uint16_t lo_word = read_short(stream);
-    uint16_t hi_word = read_short(stream);
+    uint16_t lo_word = read_short(data);
+    uint16_t hi_word = read_short(data + sizeof(uint16_t));
     return MAKELONG(lo_word, hi_word);
 }
 
@@ -0,0 +1,770 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <FileCooked.h>
+#include <File3ds.h>
+#include <FilePng.h>
+#include <Mesh.h>
+#include <Texture.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define FNV_OFFSET_BASIS 0xCBF29CE484222325ULL
+#define FNV_PRIME        0x100000001B3ULL
+#define COOKED_ALIGNMENT 4
+#define COOKED_MAX_DIM   32768 // well past GL_MAX_TEXTURE_SIZE, keeps size math from overflowing
+
+namespace vt {
+
+struct CookedHeader
+{
+    uint32_t m_magic;
+    uint32_t m_version;
+    uint32_t m_type;
+    uint32_t m_num_records;
+    uint64_t m_source_hash;
+};
+
+// followed by name (padded), coords, normals, tangents, tex coords, tri indices (padded), then lods
+struct CookedMeshHeader
+{
+    uint32_t m_name_size; // padded
+    uint32_t m_num_vertex;
+    uint32_t m_num_tri;
+    uint32_t m_num_lods;
+    float    m_lod_screen_size;
+    float    m_origin[3];
+    float    m_min[3];
+    float    m_max[3];
+};
+
+// followed by rgba pixels or compressed blocks for each mip level
+struct CookedImageHeader
+{
+    uint32_t m_width;
+    uint32_t m_height;
+    uint32_t m_num_levels;
+    uint32_t m_format; // cooked_format_t
+};
+
+// followed by program binary (padded), then attribute and uniform names
+struct CookedProgramHeader
+{
+    uint32_t m_binary_format;
+    uint32_t m_binary_size;
+    uint32_t m_num_attributes;
+    uint32_t m_num_uniforms;
+};
+
+static size_t align_cooked_size(size_t size)
+{
+    return (size + COOKED_ALIGNMENT - 1) & ~static_cast<size_t>(COOKED_ALIGNMENT - 1);
+}
+
+static size_t get_mesh_data_size(size_t num_vertex, size_t num_tri)
+{
+    return sizeof(float) * num_vertex * (3 + 3 + 3 + 2) + align_cooked_size(sizeof(uint16_t) * num_tri * 3);
+}
+
+// NOTE: block sizes come from Texture so the cooked layout always matches what gets uploaded
+static size_t get_image_data_size(glm::ivec2 dim, int num_levels, cooked_format_t format)
+{
+    switch(format) {
+        case COOKED_FORMAT_BC1: return Texture::get_compressed_size(Texture::BC1, dim, num_levels);
+        case COOKED_FORMAT_BC3: return Texture::get_compressed_size(Texture::BC3, dim, num_levels);
+        case COOKED_FORMAT_BC7: return Texture::get_compressed_size(Texture::BC7, dim, num_levels);
+        default:
+            break;
+    }
+    size_t size = 0;
+    for(int i = 0; i < num_levels; i++) {
+        glm::ivec2 level_dim = glm::max(dim >> i, glm::ivec2(1));
+        size += static_cast<size_t>(level_dim.x) * level_dim.y * 4;
+    }
+    return size;
+}
+
+//==================
+// block compression
+//==================
+
+static uint16_t pack_565(const int* color)
+{
+    return ((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3);
+}
+
+static void unpack_565(uint16_t packed, int* color)
+{
+    color[0] = ((packed >> 11) & 0x1F) * 255 / 0x1F;
+    color[1] = ((packed >> 5)  & 0x3F) * 255 / 0x3F;
+    color[2] = ( packed        & 0x1F) * 255 / 0x1F;
+}
+
+// NOTE: endpoints are the corners of the color bounding box, always in 4-color mode (color0 > color1)
+static void encode_bc1_block(const unsigned char* block_pixels, uint8_t* dest)
+{
+    int min_color[3] = {255, 255, 255};
+    int max_color[3] = {0, 0, 0};
+    for(int i = 0; i < COMPRESSED_BLOCK_DIM * COMPRESSED_BLOCK_DIM; i++) {
+        for(int c = 0; c < 3; c++) {
+            min_color[c] = std::min(min_color[c], static_cast<int>(block_pixels[i * 4 + c]));
+            max_color[c] = std::max(max_color[c], static_cast<int>(block_pixels[i * 4 + c]));
+        }
+    }
+    uint16_t color0 = pack_565(max_color);
+    uint16_t color1 = pack_565(min_color);
+    if(color0 < color1) {
+        std::swap(color0, color1);
+    }
+    uint32_t indices = 0;
+    if(color0 != color1) {
+        int palette[4][3];
+        unpack_565(color0, palette[0]);
+        unpack_565(color1, palette[1]);
+        for(int c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] * 2 + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + palette[1][c] * 2) / 3;
+        }
+        for(int i = 0; i < COMPRESSED_BLOCK_DIM * COMPRESSED_BLOCK_DIM; i++) {
+            int best_index    = 0;
+            int best_distance = INT_MAX;
+            for(int j = 0; j < 4; j++) {
+                int distance = 0;
+                for(int c = 0; c < 3; c++) {
+                    int delta = static_cast<int>(block_pixels[i * 4 + c]) - palette[j][c];
+                    distance += delta * delta;
+                }
+                if(distance < best_distance) {
+                    best_distance = distance;
+                    best_index    = j;
+                }
+            }
+            indices |= best_index << (i * 2);
+        }
+    }
+    memcpy(&dest[0], &color0,  sizeof(color0));
+    memcpy(&dest[2], &color1,  sizeof(color1));
+    memcpy(&dest[4], &indices, sizeof(indices));
+}
+
+// NOTE: 8-level interpolated alpha (alpha0 > alpha1)
+static void encode_bc3_alpha_block(const unsigned char* block_pixels, uint8_t* dest)
+{
+    int alpha0 = 0;
+    int alpha1 = 255;
+    for(int i = 0; i < COMPRESSED_BLOCK_DIM * COMPRESSED_BLOCK_DIM; i++) {
+        alpha0 = std::max(alpha0, static_cast<int>(block_pixels[i * 4 + 3]));
+        alpha1 = std::min(alpha1, static_cast<int>(block_pixels[i * 4 + 3]));
+    }
+    uint64_t indices = 0;
+    if(alpha0 != alpha1) {
+        int palette[8];
+        palette[0] = alpha0;
+        palette[1] = alpha1;
+        for(int j = 1; j < 7; j++) {
+            palette[j + 1] = (alpha0 * (7 - j) + alpha1 * j) / 7;
+        }
+        for(int i = 0; i < COMPRESSED_BLOCK_DIM * COMPRESSED_BLOCK_DIM; i++) {
+            int best_index    = 0;
+            int best_distance = INT_MAX;
+            for(int j = 0; j < 8; j++) {
+                int distance = abs(static_cast<int>(block_pixels[i * 4 + 3]) - palette[j]);
+                if(distance < best_distance) {
+                    best_distance = distance;
+                    best_index    = j;
+                }
+            }
+            indices |= static_cast<uint64_t>(best_index) << (i * 3);
+        }
+    }
+    dest[0] = alpha0;
+    dest[1] = alpha1;
+    for(int i = 0; i < 6; i++) {
+        dest[2 + i] = (indices >> (i * 8)) & 0xFF;
+    }
+}
+
+// NOTE: partial edge blocks repeat the last row / column
+static void compress_level(const unsigned char* pixels, glm::ivec2 dim, cooked_format_t format, uint8_t* dest)
+{
+    unsigned char block_pixels[COMPRESSED_BLOCK_DIM * COMPRESSED_BLOCK_DIM * 4];
+    for(int block_y = 0; block_y < dim.y; block_y += COMPRESSED_BLOCK_DIM) {
+        for(int block_x = 0; block_x < dim.x; block_x += COMPRESSED_BLOCK_DIM) {
+            for(int y = 0; y < COMPRESSED_BLOCK_DIM; y++) {
+                for(int x = 0; x < COMPRESSED_BLOCK_DIM; x++) {
+                    int src_x = std::min(block_x + x, dim.x - 1);
+                    int src_y = std::min(block_y + y, dim.y - 1);
+                    memcpy(&block_pixels[(y * COMPRESSED_BLOCK_DIM + x) * 4], &pixels[(src_y * dim.x + src_x) * 4], 4);
+                }
+            }
+            if(format == COOKED_FORMAT_BC3) {
+                encode_bc3_alpha_block(block_pixels, dest);
+                dest += 8;
+            }
+            encode_bc1_block(block_pixels, dest);
+            dest += 8;
+        }
+    }
+}
+
+static bool write_padding(FILE* stream, size_t size)
+{
+    static const uint8_t zeros[COOKED_ALIGNMENT] = {};
+    size_t padding = align_cooked_size(size) - size;
+    return !padding || fwrite(zeros, 1, padding, stream) == padding;
+}
+
+// each name is a uint32_t size followed by its chars (padded)
+static bool write_names(FILE* stream, const std::vector<std::string>& names)
+{
+    for(std::vector<std::string>::const_iterator p = names.begin(); p != names.end(); p++) {
+        uint32_t name_size = (*p).size();
+        if(fwrite(&name_size, sizeof(name_size), 1, stream) != 1 ||
+           fwrite((*p).c_str(), 1, name_size, stream) != name_size ||
+           !write_padding(stream, name_size))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool read_names(const uint8_t* data, size_t size, size_t* pos, int num_names, std::vector<std::string>* names)
+{
+    for(int i = 0; i < num_names; i++) {
+        uint32_t name_size = 0;
+        if(*pos + sizeof(name_size) > size) {
+            return false;
+        }
+        memcpy(&name_size, &data[*pos], sizeof(name_size));
+        *pos += sizeof(name_size);
+        if(*pos + align_cooked_size(name_size) > size) {
+            return false;
+        }
+        names->push_back(std::string(reinterpret_cast<const char*>(&data[*pos]), name_size));
+        *pos += align_cooked_size(name_size);
+    }
+    return true;
+}
+
+static bool write_mesh(FILE* stream, Mesh* mesh, int num_lods, float lod_screen_size)
+{
+    CookedMeshHeader header;
+    memset(&header, 0, sizeof(header));
+    header.m_name_size       = align_cooked_size(mesh->get_name().size() + 1);
+    header.m_num_vertex      = mesh->get_num_vertex();
+    header.m_num_tri         = mesh->get_num_tri();
+    header.m_num_lods        = num_lods;
+    header.m_lod_screen_size = lod_screen_size;
+    glm::vec3 origin = mesh->get_origin();
+    glm::vec3 min, max;
+    mesh->get_min_max(&min, &max);
+    memcpy(header.m_origin, &origin, sizeof(header.m_origin));
+    memcpy(header.m_min,    &min,    sizeof(header.m_min));
+    memcpy(header.m_max,    &max,    sizeof(header.m_max));
+    size_t num_vertex = header.m_num_vertex;
+    size_t num_tri    = header.m_num_tri;
+    return fwrite(&header, sizeof(header), 1, stream) == 1 &&
+           fwrite(mesh->get_name().c_str(), 1, mesh->get_name().size() + 1, stream) == mesh->get_name().size() + 1 &&
+           write_padding(stream, mesh->get_name().size() + 1) &&
+           fwrite(mesh->get_vert_coords(),   sizeof(glm::vec3), num_vertex,  stream) == num_vertex &&
+           fwrite(mesh->get_vert_normals(),  sizeof(glm::vec3), num_vertex,  stream) == num_vertex &&
+           fwrite(mesh->get_vert_tangents(), sizeof(glm::vec3), num_vertex,  stream) == num_vertex &&
+           fwrite(mesh->get_tex_coords(),    sizeof(glm::vec2), num_vertex,  stream) == num_vertex &&
+           fwrite(mesh->get_tri_indices(),   sizeof(uint16_t),  num_tri * 3, stream) == num_tri * 3 &&
+           write_padding(stream, sizeof(uint16_t) * num_tri * 3);
+}
+
+static Mesh* read_mesh(const uint8_t* data, size_t size, size_t* pos, int* num_lods, float* lod_screen_size)
+{
+    if(*pos + sizeof(CookedMeshHeader) > size) {
+        return NULL;
+    }
+    CookedMeshHeader header;
+    memcpy(&header, &data[*pos], sizeof(header));
+    *pos += sizeof(header);
+    size_t num_vertex = header.m_num_vertex;
+    size_t num_tri    = header.m_num_tri;
+    if(!header.m_name_size || *pos + header.m_name_size + get_mesh_data_size(num_vertex, num_tri) > size) {
+        return NULL;
+    }
+    std::string name(reinterpret_cast<const char*>(&data[*pos]), strnlen(reinterpret_cast<const char*>(&data[*pos]), header.m_name_size));
+    *pos += header.m_name_size;
+    Mesh* mesh = new Mesh(name, num_vertex, num_tri);
+    memcpy(mesh->get_vert_coords(),   &data[*pos], sizeof(glm::vec3) * num_vertex); *pos += sizeof(glm::vec3) * num_vertex;
+    memcpy(mesh->get_vert_normals(),  &data[*pos], sizeof(glm::vec3) * num_vertex); *pos += sizeof(glm::vec3) * num_vertex;
+    memcpy(mesh->get_vert_tangents(), &data[*pos], sizeof(glm::vec3) * num_vertex); *pos += sizeof(glm::vec3) * num_vertex;
+    memcpy(mesh->get_tex_coords(),    &data[*pos], sizeof(glm::vec2) * num_vertex); *pos += sizeof(glm::vec2) * num_vertex;
+    memcpy(mesh->get_tri_indices(),   &data[*pos], sizeof(uint16_t) * num_tri * 3);
+    *pos += align_cooked_size(sizeof(uint16_t) * num_tri * 3);
+    glm::vec3 origin, min, max;
+    memcpy(&origin, header.m_origin, sizeof(header.m_origin));
+    memcpy(&min,    header.m_min,    sizeof(header.m_min));
+    memcpy(&max,    header.m_max,    sizeof(header.m_max));
+    mesh->set_origin(origin);
+    mesh->set_min_max(min, max);
+    *num_lods        = header.m_num_lods;
+    *lod_screen_size = header.m_lod_screen_size;
+    return mesh;
+}
+
+CookedFile::CookedFile()
+    : m_data(NULL),
+      m_size(0),
+      m_num_records(0)
+{
+}
+
+CookedFile::~CookedFile()
+{
+    close();
+}
+
+bool CookedFile::open(const std::string& cooked_filename, type_t type, uint64_t source_hash)
+{
+    close();
+    int fd = ::open(cooked_filename.c_str(), O_RDONLY);
+    if(fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size < static_cast<off_t>(sizeof(CookedHeader))) {
+        ::close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // mapping stays valid after close
+    if(mapped == MAP_FAILED) {
+        return false;
+    }
+    CookedHeader header;
+    memcpy(&header, mapped, sizeof(header));
+    if(header.m_magic       != COOKED_MAGIC   ||
+       header.m_version     != COOKED_VERSION ||
+       header.m_type        != static_cast<uint32_t>(type) ||
+       header.m_source_hash != source_hash)
+    {
+        munmap(mapped, st.st_size);
+        return false;
+    }
+    m_data        = static_cast<const uint8_t*>(mapped);
+    m_size        = st.st_size;
+    m_num_records = header.m_num_records;
+    return true;
+}
+
+void CookedFile::close()
+{
+    if(!m_data) {
+        return;
+    }
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+    m_data        = NULL;
+    m_size        = 0;
+    m_num_records = 0;
+}
+
+bool CookedFile::read_meshes(std::vector<Mesh*>* meshes) const
+{
+    if(!m_data || !meshes) {
+        return false;
+    }
+    std::vector<Mesh*> cooked_meshes;
+    size_t pos     = sizeof(CookedHeader);
+    bool   success = true;
+    for(int i = 0; i < static_cast<int>(m_num_records) && success; i++) {
+        int   num_lods        = 0;
+        float lod_screen_size = 0;
+        Mesh* mesh = read_mesh(m_data, m_size, &pos, &num_lods, &lod_screen_size);
+        if(!mesh) {
+            success = false;
+            break;
+        }
+        cooked_meshes.push_back(mesh);
+        for(int j = 0; j < num_lods; j++) {
+            int   lod_num_lods = 0;
+            Mesh* lod = read_mesh(m_data, m_size, &pos, &lod_num_lods, &lod_screen_size);
+            if(!lod) {
+                success = false;
+                break;
+            }
+            mesh->add_lod(lod, lod_screen_size);
+        }
+    }
+    if(!success) {
+        for(std::vector<Mesh*>::iterator p = cooked_meshes.begin(); p != cooked_meshes.end(); p++) {
+            delete *p;
+        }
+        return false;
+    }
+    meshes->insert(meshes->end(), cooked_meshes.begin(), cooked_meshes.end());
+    return true;
+}
+
+bool CookedFile::read_images(std::vector<CookedImage>* images) const
+{
+    if(!m_data || !images) {
+        return false;
+    }
+    size_t pos = sizeof(CookedHeader);
+    for(int i = 0; i < static_cast<int>(m_num_records); i++) {
+        if(pos + sizeof(CookedImageHeader) > m_size) {
+            return false;
+        }
+        CookedImageHeader header;
+        memcpy(&header, &m_data[pos], sizeof(header));
+        pos += sizeof(header);
+        if(header.m_format > static_cast<uint32_t>(COOKED_FORMAT_BC7)) {
+            return false;
+        }
+        if(!header.m_width || !header.m_height || header.m_width > COOKED_MAX_DIM || header.m_height > COOKED_MAX_DIM) {
+            return false;
+        }
+        CookedImage image;
+        image.m_dim        = glm::ivec2(header.m_width, header.m_height);
+        image.m_format     = static_cast<cooked_format_t>(header.m_format);
+        image.m_num_levels = header.m_num_levels;
+        image.m_data       = &m_data[pos];
+        if(!header.m_num_levels || header.m_num_levels > static_cast<uint32_t>(Texture::get_num_mip_levels(image.m_dim))) {
+            return false;
+        }
+        size_t data_size = get_image_data_size(image.m_dim, image.m_num_levels, image.m_format);
+        if(pos + data_size > m_size) {
+            return false;
+        }
+        images->push_back(image);
+        pos += data_size;
+    }
+    return true;
+}
+
+bool CookedFile::read_program(CookedProgram* program) const
+{
+    if(!m_data || !program || m_num_records != 1) {
+        return false;
+    }
+    size_t pos = sizeof(CookedHeader);
+    if(pos + sizeof(CookedProgramHeader) > m_size) {
+        return false;
+    }
+    CookedProgramHeader header;
+    memcpy(&header, &m_data[pos], sizeof(header));
+    pos += sizeof(header);
+    if(!header.m_binary_size || pos + align_cooked_size(header.m_binary_size) > m_size) {
+        return false;
+    }
+    program->m_binary_format = header.m_binary_format;
+    program->m_binary        = &m_data[pos];
+    program->m_binary_size   = header.m_binary_size;
+    pos += align_cooked_size(header.m_binary_size);
+    program->m_attribute_names.clear();
+    program->m_uniform_names.clear();
+    return read_names(m_data, m_size, &pos, header.m_num_attributes, &program->m_attribute_names) &&
+           read_names(m_data, m_size, &pos, header.m_num_uniforms,   &program->m_uniform_names);
+}
+
+bool CookedFile::write_meshes(const std::string&        cooked_filename,
+                                    uint64_t            source_hash,
+                              const std::vector<Mesh*>& meshes)
+{
+    // NOTE: write to a temp file then rename, so a concurrent or interrupted cook never leaves a torn file
+    std::string temp_filename = cooked_filename + ".tmp";
+    FILE* stream = fopen(temp_filename.c_str(), "wb");
+    if(!stream) {
+        return false;
+    }
+    CookedHeader header;
+    header.m_magic       = COOKED_MAGIC;
+    header.m_version     = COOKED_VERSION;
+    header.m_type        = TYPE_MESHES;
+    header.m_num_records = meshes.size();
+    header.m_source_hash = source_hash;
+    bool success = fwrite(&header, sizeof(header), 1, stream) == 1;
+    for(std::vector<Mesh*>::const_iterator p = meshes.begin(); p != meshes.end() && success; p++) {
+        int num_lods = (*p)->get_num_lods();
+        success = write_mesh(stream, *p, num_lods, 0);
+        for(int i = 1; i <= num_lods && success; i++) {
+            success = write_mesh(stream, (*p)->get_lod(i), 0, (*p)->get_lod_screen_size(i));
+        }
+    }
+    success = (fclose(stream) == 0) && success;
+    if(!success || rename(temp_filename.c_str(), cooked_filename.c_str()) != 0) {
+        unlink(temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CookedFile::write_images(const std::string&              cooked_filename,
+                                    uint64_t                  source_hash,
+                              const std::vector<CookedImage>& images)
+{
+    std::string temp_filename = cooked_filename + ".tmp";
+    FILE* stream = fopen(temp_filename.c_str(), "wb");
+    if(!stream) {
+        return false;
+    }
+    CookedHeader header;
+    header.m_magic       = COOKED_MAGIC;
+    header.m_version     = COOKED_VERSION;
+    header.m_type        = TYPE_IMAGES;
+    header.m_num_records = images.size();
+    header.m_source_hash = source_hash;
+    bool success = fwrite(&header, sizeof(header), 1, stream) == 1;
+    for(std::vector<CookedImage>::const_iterator p = images.begin(); p != images.end() && success; p++) {
+        CookedImageHeader image_header;
+        image_header.m_width      = (*p).m_dim.x;
+        image_header.m_height     = (*p).m_dim.y;
+        image_header.m_num_levels = (*p).m_num_levels;
+        image_header.m_format     = (*p).m_format;
+        size_t data_size = get_image_data_size((*p).m_dim, (*p).m_num_levels, (*p).m_format);
+        success = fwrite(&image_header, sizeof(image_header), 1, stream) == 1 &&
+                  fwrite((*p).m_data, 1, data_size, stream) == data_size;
+    }
+    success = (fclose(stream) == 0) && success;
+    if(!success || rename(temp_filename.c_str(), cooked_filename.c_str()) != 0) {
+        unlink(temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool CookedFile::write_program(const std::string&   cooked_filename,
+                                     uint64_t       source_hash,
+                               const CookedProgram& program)
+{
+    std::string temp_filename = cooked_filename + ".tmp";
+    FILE* stream = fopen(temp_filename.c_str(), "wb");
+    if(!stream) {
+        return false;
+    }
+    CookedHeader header;
+    header.m_magic       = COOKED_MAGIC;
+    header.m_version     = COOKED_VERSION;
+    header.m_type        = TYPE_PROGRAM;
+    header.m_num_records = 1;
+    header.m_source_hash = source_hash;
+    CookedProgramHeader program_header;
+    program_header.m_binary_format  = program.m_binary_format;
+    program_header.m_binary_size    = program.m_binary_size;
+    program_header.m_num_attributes = program.m_attribute_names.size();
+    program_header.m_num_uniforms   = program.m_uniform_names.size();
+    bool success = fwrite(&header, sizeof(header), 1, stream) == 1 &&
+                   fwrite(&program_header, sizeof(program_header), 1, stream) == 1 &&
+                   fwrite(program.m_binary, 1, program.m_binary_size, stream) == program.m_binary_size &&
+                   write_padding(stream, program.m_binary_size) &&
+                   write_names(stream, program.m_attribute_names) &&
+                   write_names(stream, program.m_uniform_names);
+    success = (fclose(stream) == 0) && success;
+    if(!success || rename(temp_filename.c_str(), cooked_filename.c_str()) != 0) {
+        unlink(temp_filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool compress_image(const unsigned char*        pixels,
+                          glm::ivec2            dim,
+                          cooked_format_t       format,
+                          std::vector<uint8_t>* data,
+                          int*                  num_levels)
+{
+    if(!pixels || !data || !num_levels) {
+        return false;
+    }
+    if(format != COOKED_FORMAT_BC1 && format != COOKED_FORMAT_BC3) {
+        std::cout << "unsupported compressed format" << std::endl;
+        return false;
+    }
+    *num_levels = Texture::get_num_mip_levels(dim);
+    data->resize(get_image_data_size(dim, *num_levels, format));
+    std::vector<unsigned char> src_pixels(pixels, pixels + dim.x * dim.y * 4);
+    std::vector<unsigned char> dest_pixels(src_pixels.size());
+    glm::ivec2 level_dim = dim;
+    uint8_t*   dest      = &(*data)[0];
+    for(int i = 0; i < *num_levels; i++) {
+        if(i) {
+            Texture::downsample(&src_pixels[0], level_dim, &dest_pixels[0]);
+            src_pixels.swap(dest_pixels);
+            level_dim = glm::max(level_dim >> 1, glm::ivec2(1));
+        }
+        compress_level(&src_pixels[0], level_dim, format, dest);
+        dest += get_image_data_size(level_dim, 1, format);
+    }
+    return true;
+}
+
+// fnv-1a over file contents (0 if unreadable)
+uint64_t hash_file(const std::string& filename)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd == -1) {
+        return 0;
+    }
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || !st.st_size) {
+        close(fd);
+        return 0;
+    }
+    void* mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapped == MAP_FAILED) {
+        return 0;
+    }
+    const uint8_t* data = static_cast<const uint8_t*>(mapped);
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < static_cast<size_t>(st.st_size); i++) {
+        hash = (hash ^ data[i]) * FNV_PRIME;
+    }
+    munmap(mapped, st.st_size);
+    return hash;
+}
+
+uint64_t hash_string(const std::string& s)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for(size_t i = 0; i < s.size(); i++) {
+        hash = (hash ^ static_cast<uint8_t>(s[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+uint64_t hash_combine(uint64_t seed, uint64_t value)
+{
+    for(int i = 0; i < static_cast<int>(sizeof(value)); i++) {
+        seed = (seed ^ ((value >> (i * 8)) & 0xFF)) * FNV_PRIME;
+    }
+    return seed;
+}
+
+std::string get_cooked_filename(const std::string& source_filename)
+{
+    return source_filename + COOKED_EXT;
+}
+
+// NOTE: lod count and object index are part of the key, since they change what gets cooked
+bool load_3ds_cached(const std::string&  filename,
+                           int           index,
+                           int           num_lods,
+                     std::vector<Mesh*>* meshes,
+                           bool          cook_on_miss,
+                           bool*         cache_hit)
+{
+    if(cache_hit) {
+        *cache_hit = false;
+    }
+    uint64_t source_hash = hash_file(filename);
+    if(!source_hash) {
+        return false;
+    }
+    uint64_t    key             = hash_combine(hash_combine(source_hash, index), num_lods);
+    std::string cooked_filename = get_cooked_filename(filename);
+    CookedFile  cooked_file;
+    if(cooked_file.open(cooked_filename, CookedFile::TYPE_MESHES, key) && cooked_file.read_meshes(meshes)) {
+        if(cache_hit) {
+            *cache_hit = true;
+        }
+        return true;
+    }
+    std::vector<Mesh*> loaded_meshes;
+    if(!File3ds::load3ds(filename, index, &loaded_meshes)) {
+        return false;
+    }
+    for(std::vector<Mesh*>::iterator p = loaded_meshes.begin(); p != loaded_meshes.end(); p++) {
+        if(num_lods) {
+            (*p)->generate_lods(num_lods);
+        }
+    }
+    if(cook_on_miss && !CookedFile::write_meshes(cooked_filename, key, loaded_meshes)) {
+        std::cout << "failed to write " << cooked_filename << std::endl;
+    }
+    meshes->insert(meshes->end(), loaded_meshes.begin(), loaded_meshes.end());
+    return true;
+}
+
+bool load_png_cached(const std::string&    png_filename,
+                           CookedFile*     cooked_file,
+                           CookedImage*    image,
+                           cooked_format_t format,
+                           bool            cook_on_miss,
+                           bool*           cache_hit)
+{
+    if(!cooked_file || !image) {
+        return false;
+    }
+    if(cache_hit) {
+        *cache_hit = false;
+    }
+    uint64_t source_hash = hash_file(png_filename);
+    if(!source_hash) {
+        return false;
+    }
+    std::string              cooked_filename = get_cooked_filename(png_filename);
+    std::vector<CookedImage> cooked_images;
+    if(cooked_file->open(cooked_filename, CookedFile::TYPE_IMAGES, source_hash) &&
+       cooked_file->read_images(&cooked_images) && cooked_images.size() == 1 &&
+       (format == COOKED_FORMAT_ANY || cooked_images[0].m_format == format))
+    {
+        *image = cooked_images[0];
+        if(cache_hit) {
+            *cache_hit = true;
+        }
+        return true;
+    }
+    cooked_file->close();
+    unsigned char* pixels = NULL;
+    size_t         width  = 0;
+    size_t         height = 0;
+    if(!read_png(png_filename, (void**)&pixels, &width, &height) || !pixels) {
+        return false;
+    }
+    image->m_dim        = glm::ivec2(width, height);
+    image->m_format     = COOKED_FORMAT_RGBA;
+    image->m_num_levels = 1;
+    image->m_data       = pixels;
+    if(!cook_on_miss) {
+        return true;
+    }
+    std::vector<CookedImage> images(1, *image);
+    std::vector<uint8_t>     compressed_data;
+    if(format != COOKED_FORMAT_ANY && format != COOKED_FORMAT_RGBA) {
+        if(!compress_image(pixels, image->m_dim, format, &compressed_data, &images[0].m_num_levels)) {
+            std::cout << "failed to compress " << png_filename << std::endl;
+            return true;
+        }
+        images[0].m_format = format;
+        images[0].m_data   = &compressed_data[0];
+    }
+    if(!CookedFile::write_images(cooked_filename, source_hash, images)) {
+        std::cout << "failed to write " << cooked_filename << std::endl;
+    }
+    return true;
+}
+
+}
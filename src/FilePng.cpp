@@ -21,6 +21,7 @@
 
 namespace vt {
 
+// NOTE: read_png_impl expands every format to 8-bit rgba, so rows decode straight into the returned buffer
 bool read_png(const std::string& png_filename,
                     void**       pixel_data,
                     size_t*      width,
@@ -29,55 +30,12 @@ bool read_png(const std::string& png_filename,
     if(!pixel_data || !width || !height) {
         return false;
     }
-    unsigned char* src_pixel_data = NULL;
-    size_t src_width  = 0;
-    size_t src_height = 0;
     int color_type = 0;
-    if(!read_png_impl(png_filename,
-                      reinterpret_cast<void**>(&src_pixel_data),
-                      &src_width,
-                      &src_height,
-                      &color_type) || !src_pixel_data)
-    {
-        return false;
-    }
-    size_t size_buf = src_width * src_height * sizeof(unsigned char) * 4;
-    unsigned char* dest_pixel_data = new unsigned char[size_buf];
-    if(!dest_pixel_data) {
-        return false;
-    }
-    switch(color_type) {
-        case PNG_COLOR_MASK_COLOR:
-            for(int y = 0; y < static_cast<int>(src_height); y++) {
-                for(int x = 0; x < static_cast<int>(src_width); x++) {
-                    int src_pixel_offset_scanline_start  = (y * src_width + x) * 3;
-                    int dest_pixel_offset_scanline_start = (y * src_width + x) * 4;
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 0] = src_pixel_data[src_pixel_offset_scanline_start + 0];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 1] = src_pixel_data[src_pixel_offset_scanline_start + 1];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 2] = src_pixel_data[src_pixel_offset_scanline_start + 2];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 3] = 1;
-                }
-            }
-            break;
-        case PNG_COLOR_TYPE_RGB_ALPHA:
-        case PNG_COLOR_TYPE_GRAY:
-            for(int y = 0; y < static_cast<int>(src_height); y++) {
-                for(int x = 0; x < static_cast<int>(src_width); x++) {
-                    int src_pixel_offset_scanline_start  = (y * src_width + x) * 4;
-                    int dest_pixel_offset_scanline_start = (y * src_width + x) * 4;
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 0] = src_pixel_data[src_pixel_offset_scanline_start + 0];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 1] = src_pixel_data[src_pixel_offset_scanline_start + 1];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 2] = src_pixel_data[src_pixel_offset_scanline_start + 2];
-                    dest_pixel_data[dest_pixel_offset_scanline_start + 3] = src_pixel_data[src_pixel_offset_scanline_start + 3];
-                }
-            }
-            break;
-    }
-    delete []src_pixel_data;
-    *pixel_data = dest_pixel_data;
-    *width      = src_width;
-    *height     = src_height;
-    return true;
+    return read_png_impl(png_filename,
+                         pixel_data,
+                         width,
+                         height,
+                         &color_type) && *pixel_data;
 }
 
 bool read_png_impl(const std::string& png_filename,
@@ -155,6 +113,26 @@ bool read_png_impl(const std::string& png_filename,
     // get info about png
     png_get_IHDR(png_ptr, info_ptr, &twidth, &theight, &bit_depth, color_type, NULL, NULL, NULL);
 
+    // expand palette, low bit depth gray, transparency, 16-bit and missing alpha to 8-bit rgba
+    if(*color_type == PNG_COLOR_TYPE_PALETTE) {
+        png_set_palette_to_rgb(png_ptr);
+    }
+    if(*color_type == PNG_COLOR_TYPE_GRAY && bit_depth < 8) {
+        png_set_expand_gray_1_2_4_to_8(png_ptr);
+    }
+    if(png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_set_tRNS_to_alpha(png_ptr);
+    }
+    if(bit_depth == 16) {
+        png_set_strip_16(png_ptr);
+    }
+    if(*color_type == PNG_COLOR_TYPE_GRAY || *color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+        png_set_gray_to_rgb(png_ptr);
+    }
+    if(!(*color_type & PNG_COLOR_MASK_ALPHA) && !png_get_valid(png_ptr, info_ptr, PNG_INFO_tRNS)) {
+        png_set_filler(png_ptr, 0xFF, PNG_FILLER_AFTER);
+    }
+
     // update the png info struct.
     png_read_update_info(png_ptr, info_ptr);
 
@@ -0,0 +1,96 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <FileWatcher.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <errno.h>
+
+#define EVENT_BUF_SIZE 4096
+
+namespace vt {
+
+FileWatcher::FileWatcher()
+    : m_fd(inotify_init1(IN_NONBLOCK | IN_CLOEXEC))
+{
+    if(m_fd == -1) {
+        std::cout << "failed to init file watcher" << std::endl;
+    }
+}
+
+FileWatcher::~FileWatcher()
+{
+    if(m_fd != -1) {
+        close(m_fd); // also drops the watches
+    }
+}
+
+bool FileWatcher::add_file(const std::string& filename)
+{
+    if(m_fd == -1) {
+        return false;
+    }
+    size_t      slash_pos = filename.rfind('/');
+    std::string dir       = (slash_pos == std::string::npos) ? "" : filename.substr(0, slash_pos);
+    int wd = inotify_add_watch(m_fd, dir.empty() ? "." : dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if(wd == -1) {
+        std::cout << "failed to watch " << filename << std::endl;
+        return false;
+    }
+    m_dirs[wd] = dir; // NOTE: same directory yields same descriptor
+    m_files.insert(filename);
+    return true;
+}
+
+void FileWatcher::poll(std::vector<std::string>* changed_files)
+{
+    if(!changed_files || m_fd == -1) {
+        return;
+    }
+    char buf[EVENT_BUF_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+    while(true) {
+        ssize_t len = read(m_fd, buf, sizeof(buf));
+        if(len <= 0) {
+            if(len == -1 && errno != EAGAIN) {
+                std::cout << "failed to read file watcher events" << std::endl;
+            }
+            break;
+        }
+        for(char* p = buf; p < buf + len;) {
+            const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + event->len;
+            dirs_t::iterator q = m_dirs.find(event->wd);
+            if(q == m_dirs.end() || !event->len) {
+                continue;
+            }
+            std::string filename = (*q).second.empty() ? event->name : (*q).second + "/" + event->name;
+            if(m_files.find(filename) == m_files.end()) {
+                continue;
+            }
+            if(std::find(changed_files->begin(), changed_files->end(), filename) == changed_files->end()) {
+                changed_files->push_back(filename);
+            }
+        }
+    }
+}
+
+}
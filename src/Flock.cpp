@@ -0,0 +1,285 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <Flock.h>
+#include <TransformObject.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <algorithm>
+#include <math.h>
+
+#define DEFAULT_NEIGHBOR_RADIUS   2.0f
+#define DEFAULT_SEPARATION_RADIUS 0.5f
+#define DEFAULT_MAX_NEIGHBORS     7
+#define MAX_GRID_DIM              64 // per axis
+
+namespace vt {
+
+Flock::Flock(glm::vec3 origin, glm::vec3 dim)
+    : m_origin(origin),
+      m_dim(dim),
+      m_grid_dim(1),
+      m_neighbor_radius(  DEFAULT_NEIGHBOR_RADIUS),
+      m_separation_radius(DEFAULT_SEPARATION_RADIUS),
+      m_max_neighbors(    DEFAULT_MAX_NEIGHBORS),
+      m_separation_weight(1),
+      m_alignment_weight( 1),
+      m_cohesion_weight(  1),
+      m_seek_weight(      0),
+      m_target(glm::vec3(0)),
+      m_enable_target(false)
+{
+}
+
+Flock::~Flock()
+{
+}
+
+int Flock::add_boid(glm::vec3        pos,
+                    glm::vec3        heading,
+                    TransformObject* transform_object)
+{
+    int index = m_pos_x.size();
+    glm::vec3 _heading = safe_normalize(heading);
+    m_pos_x.push_back(pos.x);
+    m_pos_y.push_back(pos.y);
+    m_pos_z.push_back(pos.z);
+    m_heading_x.push_back(_heading.x);
+    m_heading_y.push_back(_heading.y);
+    m_heading_z.push_back(_heading.z);
+    m_steer_x.push_back(0);
+    m_steer_y.push_back(0);
+    m_steer_z.push_back(0);
+    m_transform_objects.push_back(transform_object);
+    return index;
+}
+
+glm::vec3 Flock::get_boid_pos(int index) const
+{
+    return glm::vec3(m_pos_x[index], m_pos_y[index], m_pos_z[index]);
+}
+
+glm::vec3 Flock::get_boid_heading(int index) const
+{
+    return glm::vec3(m_heading_x[index], m_heading_y[index], m_heading_z[index]);
+}
+
+void Flock::set_weights(float separation_weight,
+                        float alignment_weight,
+                        float cohesion_weight,
+                        float seek_weight)
+{
+    m_separation_weight = separation_weight;
+    m_alignment_weight  = alignment_weight;
+    m_cohesion_weight   = cohesion_weight;
+    m_seek_weight       = seek_weight;
+}
+
+void Flock::set_target(glm::vec3 target, bool enable_target)
+{
+    m_target        = target;
+    m_enable_target = enable_target;
+}
+
+void Flock::update(float forward_speed, float turn_rate)
+{
+    if(m_pos_x.empty()) {
+        return;
+    }
+    update_grid();
+    update_steering();
+    integrate(forward_speed, turn_rate);
+    update_transform_objects();
+}
+
+// NOTE: counting sort keeps each cell's boids contiguous, so neighbor scans walk flat int arrays
+void Flock::update_grid()
+{
+    int boid_count = m_pos_x.size();
+    for(int k = 0; k < 3; k++) {
+        m_grid_dim[k] = std::max(1, std::min(MAX_GRID_DIM, static_cast<int>(m_dim[k] / m_neighbor_radius)));
+    }
+    int cell_count = m_grid_dim.x * m_grid_dim.y * m_grid_dim.z;
+    glm::vec3 cell_scale = glm::vec3(m_grid_dim) / m_dim;
+    m_cell_ids.resize(boid_count);
+    m_cell_start.assign(cell_count + 1, 0);
+    m_cell_boids.resize(boid_count);
+    for(int i = 0; i < boid_count; i++) {
+        int cx = glm::clamp(static_cast<int>((m_pos_x[i] - m_origin.x) * cell_scale.x), 0, m_grid_dim.x - 1);
+        int cy = glm::clamp(static_cast<int>((m_pos_y[i] - m_origin.y) * cell_scale.y), 0, m_grid_dim.y - 1);
+        int cz = glm::clamp(static_cast<int>((m_pos_z[i] - m_origin.z) * cell_scale.z), 0, m_grid_dim.z - 1);
+        int cell_id = (cz * m_grid_dim.y + cy) * m_grid_dim.x + cx;
+        m_cell_ids[i] = cell_id;
+        m_cell_start[cell_id + 1]++;
+    }
+    for(int c = 0; c < cell_count; c++) {
+        m_cell_start[c + 1] += m_cell_start[c];
+    }
+    m_neighbor_ids.assign(m_cell_start.begin(), m_cell_start.end() - 1); // reuse as per cell write cursor
+    for(int i = 0; i < boid_count; i++) {
+        m_cell_boids[m_neighbor_ids[m_cell_ids[i]]++] = i;
+    }
+}
+
+// keeps the m_max_neighbors nearest boids within neighbor radius, sorted by distance
+void Flock::find_neighbors(int index)
+{
+    m_neighbor_ids.clear();
+    m_neighbor_distance2.clear();
+    int cell_id = m_cell_ids[index];
+    int cx = cell_id % m_grid_dim.x;
+    int cy = (cell_id / m_grid_dim.x) % m_grid_dim.y;
+    int cz = cell_id / (m_grid_dim.x * m_grid_dim.y);
+    float x = m_pos_x[index];
+    float y = m_pos_y[index];
+    float z = m_pos_z[index];
+    float neighbor_radius2 = m_neighbor_radius * m_neighbor_radius;
+    for(int k = std::max(cz - 1, 0); k <= std::min(cz + 1, m_grid_dim.z - 1); k++) {
+        for(int j = std::max(cy - 1, 0); j <= std::min(cy + 1, m_grid_dim.y - 1); j++) {
+            for(int i = std::max(cx - 1, 0); i <= std::min(cx + 1, m_grid_dim.x - 1); i++) {
+                int c = (k * m_grid_dim.y + j) * m_grid_dim.x + i;
+                for(int p = m_cell_start[c]; p < m_cell_start[c + 1]; p++) {
+                    int other = m_cell_boids[p];
+                    if(other == index) {
+                        continue;
+                    }
+                    float dx = m_pos_x[other] - x;
+                    float dy = m_pos_y[other] - y;
+                    float dz = m_pos_z[other] - z;
+                    float distance2 = dx * dx + dy * dy + dz * dz;
+                    if(distance2 >= neighbor_radius2) {
+                        continue;
+                    }
+                    if(static_cast<int>(m_neighbor_ids.size()) == m_max_neighbors) {
+                        if(distance2 >= m_neighbor_distance2.back()) {
+                            continue;
+                        }
+                        m_neighbor_ids.pop_back();
+                        m_neighbor_distance2.pop_back();
+                    }
+                    // insertion into small sorted buffer
+                    int q = m_neighbor_ids.size();
+                    m_neighbor_ids.push_back(other);
+                    m_neighbor_distance2.push_back(distance2);
+                    for(; q > 0 && m_neighbor_distance2[q - 1] > distance2; q--) {
+                        m_neighbor_ids[q]       = m_neighbor_ids[q - 1];
+                        m_neighbor_distance2[q] = m_neighbor_distance2[q - 1];
+                    }
+                    m_neighbor_ids[q]       = other;
+                    m_neighbor_distance2[q] = distance2;
+                }
+            }
+        }
+    }
+}
+
+// separation, alignment, and cohesion from nearest neighbors
+void Flock::update_steering()
+{
+    int boid_count = m_pos_x.size();
+    for(int i = 0; i < boid_count; i++) {
+        glm::vec3 pos(m_pos_x[i], m_pos_y[i], m_pos_z[i]);
+        find_neighbors(i);
+        glm::vec3 separation(0);
+        glm::vec3 sum_heading(0);
+        glm::vec3 sum_pos(0);
+        int neighbor_count = 0;
+        for(std::vector<int>::const_iterator p = m_neighbor_ids.begin(); p != m_neighbor_ids.end(); ++p) {
+            int j = *p;
+            glm::vec3 offset(m_pos_x[i] - m_pos_x[j],
+                             m_pos_y[i] - m_pos_y[j],
+                             m_pos_z[i] - m_pos_z[j]);
+            float distance = glm::length(offset);
+            if(distance < m_separation_radius && distance > EPSILON) {
+                separation += offset * (1 / (distance * distance)); // push away harder when closer
+            }
+            sum_heading += glm::vec3(m_heading_x[j], m_heading_y[j], m_heading_z[j]);
+            sum_pos     += glm::vec3(m_pos_x[j], m_pos_y[j], m_pos_z[j]);
+            neighbor_count++;
+        }
+        glm::vec3 steer(0);
+        if(neighbor_count) {
+            float neighbor_count_inv = 1.0f / neighbor_count;
+            steer += separation                                         * m_separation_weight;
+            steer += safe_normalize(sum_heading)                        * m_alignment_weight;
+            steer += safe_normalize(sum_pos * neighbor_count_inv - pos) * m_cohesion_weight;
+        }
+        if(m_enable_target) {
+            steer += safe_normalize(m_target - pos) * m_seek_weight;
+        }
+        m_steer_x[i] = steer.x;
+        m_steer_y[i] = steer.y;
+        m_steer_z[i] = steer.z;
+    }
+}
+
+// tight loop over contiguous arrays (no per-boid matrix or euler math)
+void Flock::integrate(float forward_speed, float turn_rate)
+{
+    int boid_count = m_pos_x.size();
+    float*       pos_x     = &m_pos_x[0];
+    float*       pos_y     = &m_pos_y[0];
+    float*       pos_z     = &m_pos_z[0];
+    float*       heading_x = &m_heading_x[0];
+    float*       heading_y = &m_heading_y[0];
+    float*       heading_z = &m_heading_z[0];
+    const float* steer_x   = &m_steer_x[0];
+    const float* steer_y   = &m_steer_y[0];
+    const float* steer_z   = &m_steer_z[0];
+    glm::vec3 min = m_origin;
+    glm::vec3 max = m_origin + m_dim;
+    for(int i = 0; i < boid_count; i++) {
+        float x = heading_x[i] + steer_x[i] * turn_rate;
+        float y = heading_y[i] + steer_y[i] * turn_rate;
+        float z = heading_z[i] + steer_z[i] * turn_rate;
+        float length = sqrtf(x * x + y * y + z * z);
+        if(length > EPSILON) {
+            float length_inv = 1 / length;
+            heading_x[i] = x * length_inv;
+            heading_y[i] = y * length_inv;
+            heading_z[i] = z * length_inv;
+        }
+        pos_x[i] += heading_x[i] * forward_speed;
+        pos_y[i] += heading_y[i] * forward_speed;
+        pos_z[i] += heading_z[i] * forward_speed;
+
+        // wrap around (same as BBoxObject::wrap)
+        if(pos_x[i] < min.x) { pos_x[i] = max.x; }
+        if(pos_y[i] < min.y) { pos_y[i] = max.y; }
+        if(pos_z[i] < min.z) { pos_z[i] = max.z; }
+        if(pos_x[i] > max.x) { pos_x[i] = min.x; }
+        if(pos_y[i] > max.y) { pos_y[i] = min.y; }
+        if(pos_z[i] > max.z) { pos_z[i] = min.z; }
+    }
+}
+
+// only rendered agents pay for transform updates
+void Flock::update_transform_objects()
+{
+    int boid_count = m_pos_x.size();
+    for(int i = 0; i < boid_count; i++) {
+        TransformObject* transform_object = m_transform_objects[i];
+        if(!transform_object) {
+            continue;
+        }
+        transform_object->set_origin(glm::vec3(m_pos_x[i], m_pos_y[i], m_pos_z[i]));
+        transform_object->point_at_local(glm::vec3(m_heading_x[i], m_heading_y[i], m_heading_z[i]));
+    }
+}
+
+}
@@ -0,0 +1,199 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <HotReloader.h>
+#include <File3ds.h>
+#include <FilePng.h>
+#include <Material.h>
+#include <Mesh.h>
+#include <MeshAllocator.h>
+#include <Scene.h>
+#include <Texture.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <set>
+#include <iostream>
+
+namespace vt {
+
+HotReloader::HotReloader()
+{
+}
+
+void HotReloader::watch_material(Material* material)
+{
+    if(!material) {
+        return;
+    }
+    m_file_watcher.add_file(material->get_vertex_shader_file());
+    m_file_watcher.add_file(material->get_fragment_shader_file());
+    watch_include_files(material);
+    m_materials.push_back(material);
+}
+
+void HotReloader::watch_texture(Texture* texture, const std::string& png_filename, int face)
+{
+    if(!texture) {
+        return;
+    }
+    WatchedTexture watched_texture;
+    watched_texture.m_texture      = texture;
+    watched_texture.m_png_filename = png_filename;
+    watched_texture.m_face         = face;
+    m_file_watcher.add_file(png_filename);
+    m_textures.push_back(watched_texture);
+}
+
+void HotReloader::watch_3ds(const std::string&  filename,
+                                  int           index,
+                            std::vector<Mesh*>* meshes)
+{
+    if(!meshes) {
+        return;
+    }
+    Watched3ds watched_3ds;
+    watched_3ds.m_filename = filename;
+    watched_3ds.m_index    = index;
+    watched_3ds.m_meshes   = meshes;
+    m_file_watcher.add_file(filename);
+    m_3ds_files.push_back(watched_3ds);
+}
+
+// NOTE: call once per frame, before drawing
+int HotReloader::update()
+{
+    int num_swapped = 0;
+    std::vector<std::string> changed_files;
+    m_file_watcher.poll(&changed_files);
+    for(std::vector<std::string>::iterator p = changed_files.begin(); p != changed_files.end(); p++) {
+        std::cout << "reloading " << *p << std::endl;
+        for(std::vector<Material*>::iterator q = m_materials.begin(); q != m_materials.end(); q++) {
+            if((*q)->uses_file(*p)) {
+                if((*q)->reload()) {
+                    m_pending_materials.insert(*q); // NOTE: old program keeps drawing until the new one links
+                }
+            }
+        }
+        for(std::vector<WatchedTexture>::iterator q = m_textures.begin(); q != m_textures.end(); q++) {
+            if((*q).m_png_filename == *p && reload_texture(*q)) {
+                num_swapped++;
+            }
+        }
+        for(std::vector<Watched3ds>::iterator q = m_3ds_files.begin(); q != m_3ds_files.end(); q++) {
+            if((*q).m_filename == *p && reload_3ds(*q)) {
+                num_swapped++;
+            }
+        }
+    }
+    int num_swapped_materials = 0;
+    for(std::set<Material*>::iterator p = m_pending_materials.begin(); p != m_pending_materials.end();) {
+        if((*p)->poll_reload()) {
+            watch_include_files(*p); // NOTE: the new source may include different files
+            num_swapped_materials++;
+        }
+        if((*p)->is_reloading()) {
+            p++;
+            continue;
+        }
+        m_pending_materials.erase(p++);
+    }
+    if(num_swapped_materials) {
+        clear_shader_contexts();
+    }
+    return num_swapped + num_swapped_materials;
+}
+
+void HotReloader::watch_include_files(const Material* material)
+{
+    const std::vector<std::string> &include_files = material->get_include_files();
+    for(std::vector<std::string>::const_iterator p = include_files.begin(); p != include_files.end(); p++) {
+        m_file_watcher.add_file(*p);
+    }
+}
+
+bool HotReloader::reload_texture(const WatchedTexture& watched_texture)
+{
+    Texture*       texture = watched_texture.m_texture;
+    unsigned char* pixels  = NULL;
+    size_t         width   = 0;
+    size_t         height  = 0;
+    if(texture->is_compressed()) {
+        std::cout << "texture " << texture->get_name() << " is compressed, restart to reload" << std::endl;
+        return false;
+    }
+    if(!read_png(watched_texture.m_png_filename, (void**)&pixels, &width, &height) || !pixels) {
+        return false; // e.g. mid-save, try again on the next change
+    }
+    bool result = texture->replace_pixels(pixels, glm::ivec2(width, height), watched_texture.m_face);
+    delete[] pixels;
+    return result;
+}
+
+// NOTE: meshes keep their identity (scene membership, transform, material), only geometry is replaced
+bool HotReloader::reload_3ds(const Watched3ds& watched_3ds)
+{
+    std::vector<Mesh*> new_meshes;
+    bool result = File3ds::load3ds(watched_3ds.m_filename, watched_3ds.m_index, &new_meshes);
+    if(!result) {
+        std::cout << "failed to load " << watched_3ds.m_filename << ", try again on the next change" << std::endl;
+    } else if(new_meshes.size() != watched_3ds.m_meshes->size()) {
+        std::cout << "mesh count in " << watched_3ds.m_filename << " changed, restart to reload" << std::endl;
+        result = false;
+    }
+    if(result) {
+        std::vector<Mesh*>::iterator q = new_meshes.begin();
+        for(std::vector<Mesh*>::iterator p = watched_3ds.m_meshes->begin(); p != watched_3ds.m_meshes->end(); p++, q++) {
+            Mesh* mesh     = *p;
+            int   num_lods = mesh->get_num_lods();
+            mesh->set_allocator(PoolMeshAllocator::instance()); // NOTE: imported meshes start on the init arena, which can't free
+            mesh->resize((*q)->get_num_vertex(), (*q)->get_num_tri());
+            mesh->copy_vertices(*q, 0, 0, (*q)->get_num_vertex());
+            mesh->copy_tri_indices(*q, 0, 0, (*q)->get_num_tri());
+            mesh->update_bbox();
+            if(num_lods) { // NOTE: resize dropped the stale lods
+                mesh->generate_lods(num_lods);
+                mesh->set_compressed(mesh->is_compressed()); // new lods match parent
+            }
+            for(int i = 0; i <= mesh->get_num_lods(); i++) {
+                mesh->get_lod(i)->init_buffers();
+            }
+        }
+    }
+    for(std::vector<Mesh*>::iterator p = new_meshes.begin(); p != new_meshes.end(); p++) {
+        delete *p;
+    }
+    return result;
+}
+
+// NOTE: contexts hold uniform / attribute locations of the replaced program
+void HotReloader::clear_shader_contexts()
+{
+    Scene* scene = Scene::instance();
+    for(Scene::meshes_t::const_iterator p = scene->get_meshes().begin(); p != scene->get_meshes().end(); p++) {
+        (*p)->clear_shader_contexts();
+    }
+    if(scene->get_skybox()) {
+        scene->get_skybox()->clear_shader_contexts();
+    }
+    if(scene->get_overlay()) {
+        scene->get_overlay()->clear_shader_contexts();
+    }
+}
+
+}
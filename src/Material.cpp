@@ -17,18 +17,38 @@
 
 #include <Material.h>
 #include <NamedObject.h>
+#include <FileCooked.h>
 #include <Program.h>
 #include <Shader.h>
 #include <Texture.h>
+#include <shader_utils.h>
+#include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <vector>
 #include <map>
 #include <string>
 #include <algorithm>
 #include <iterator>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
 
 namespace vt {
 
+// lets the driver compile on as many threads as it likes (GL_KHR_parallel_shader_compile)
+static void init_parallel_shader_compile()
+{
+    static bool init = false;
+    if(init) {
+        return;
+    }
+    init = true;
+    if(GLEW_KHR_parallel_shader_compile) {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+    }
+}
+
 Material::Material(const std::string& name,
                    const std::string& vertex_shader_file,
                    const std::string& fragment_shader_file,
@@ -38,25 +58,146 @@ Material::Material(const std::string& name,
       m_program(NULL),
       m_vertex_shader(NULL),
       m_fragment_shader(NULL),
+      m_vertex_shader_file(vertex_shader_file),
+      m_fragment_shader_file(fragment_shader_file),
       m_use_overlay(use_overlay),
-      m_use_ssao(use_ssao)
+      m_use_ssao(use_ssao),
+      m_link_state(LINK_STATE_PENDING),
+      m_cooked_key(0),
+      m_pending_program(NULL),
+      m_pending_vertex_shader(NULL),
+      m_pending_fragment_shader(NULL)
 {
-    m_program         = new Program(name);
-    m_vertex_shader   = new Shader(vertex_shader_file,   GL_VERTEX_SHADER);
-    m_fragment_shader = new Shader(fragment_shader_file, GL_FRAGMENT_SHADER);
+    m_program = new Program(name);
+
+    // NOTE: a warm start loads the cached program binary and skips shader compilation entirely
+    size_t dir_pos = vertex_shader_file.rfind('/');
+    m_cooked_filename = get_cooked_filename(vertex_shader_file.substr(0, dir_pos + 1) + name + ".program");
+    m_cooked_key      = get_cooked_key();
+    if(m_program->load_binary(m_cooked_filename, m_cooked_key)) {
+        m_link_state = LINK_STATE_READY;
+        return;
+    }
+
+    // NOTE: compile and link are only issued here, is_ready() collects the result once the driver is done
+    init_parallel_shader_compile();
+    m_vertex_shader   = new Shader(vertex_shader_file,   GL_VERTEX_SHADER,   true); // deferred
+    m_fragment_shader = new Shader(fragment_shader_file, GL_FRAGMENT_SHADER, true); // deferred
     m_program->attach_shader(m_vertex_shader);
     m_program->attach_shader(m_fragment_shader);
-    if(!m_program->link()) {
+    m_program->begin_link();
+}
+
+Material::~Material()
+{
+    if(m_program)         { delete m_program; }
+    if(m_vertex_shader)   { delete m_vertex_shader; }
+    if(m_fragment_shader) { delete m_fragment_shader; }
+    clear_pending_program();
+}
+
+// returns false while the program is still compiling / linking (or if it failed)
+bool Material::is_ready()
+{
+    if(m_link_state != LINK_STATE_PENDING) {
+        return m_link_state == LINK_STATE_READY;
+    }
+    if(!m_program->is_link_complete()) {
+        return false;
+    }
+    if(!m_program->end_link()) {
+        m_vertex_shader->check_compile_status();
+        m_fragment_shader->check_compile_status();
         fprintf(stderr, "glLinkProgram:");
-        return;
+        print_log(m_program->id());
+        m_link_state = LINK_STATE_FAILED;
+        return false;
     }
+    m_program->save_binary(m_cooked_filename, m_cooked_key);
+    m_link_state = LINK_STATE_READY;
+    return true;
 }
 
-Material::~Material()
+// NOTE: builds a replacement program next to the current one, which keeps rendering until poll_reload() swaps it in
+bool Material::reload()
+{
+    if(access(m_vertex_shader_file.c_str(),   F_OK) == -1 ||
+       access(m_fragment_shader_file.c_str(), F_OK) == -1)
+    {
+        return false; // e.g. mid-save, try again on the next change
+    }
+    clear_pending_program();
+    m_pending_program         = new Program(get_name());
+    m_pending_vertex_shader   = new Shader(m_vertex_shader_file,   GL_VERTEX_SHADER,   true); // deferred
+    m_pending_fragment_shader = new Shader(m_fragment_shader_file, GL_FRAGMENT_SHADER, true); // deferred
+    m_pending_program->attach_shader(m_pending_vertex_shader);
+    m_pending_program->attach_shader(m_pending_fragment_shader);
+    m_pending_program->begin_link();
+    return true;
+}
+
+// returns true once the replacement program is swapped in, a failed reload is dropped and the old program kept
+// NOTE: shader contexts built on the old program must be cleared by the caller (see Mesh::clear_shader_contexts)
+bool Material::poll_reload()
 {
+    if(!m_pending_program || !m_pending_program->is_link_complete()) {
+        return false;
+    }
+    if(!m_pending_program->end_link()) {
+        m_pending_vertex_shader->check_compile_status();
+        m_pending_fragment_shader->check_compile_status();
+        fprintf(stderr, "glLinkProgram:");
+        print_log(m_pending_program->id());
+        clear_pending_program();
+        return false;
+    }
     if(m_program)         { delete m_program; }
     if(m_vertex_shader)   { delete m_vertex_shader; }
     if(m_fragment_shader) { delete m_fragment_shader; }
+    m_program                 = m_pending_program;
+    m_vertex_shader           = m_pending_vertex_shader;
+    m_fragment_shader         = m_pending_fragment_shader;
+    m_pending_program         = NULL;
+    m_pending_vertex_shader   = NULL;
+    m_pending_fragment_shader = NULL;
+    m_link_state              = LINK_STATE_READY;
+    m_cooked_key              = get_cooked_key();
+    m_program->save_binary(m_cooked_filename, m_cooked_key);
+    return true;
+}
+
+bool Material::uses_file(const std::string& filename) const
+{
+    return m_vertex_shader_file == filename || m_fragment_shader_file == filename ||
+           std::find(m_include_files.begin(), m_include_files.end(), filename) != m_include_files.end();
+}
+
+// NOTE: also refreshes m_include_files, so editing a shared snippet invalidates every program that includes it
+uint64_t Material::get_cooked_key()
+{
+    uint64_t key = hash_combine(hash_file(m_vertex_shader_file),
+                                hash_file(m_fragment_shader_file));
+    m_include_files.clear();
+    const std::string* shader_files[] = {&m_vertex_shader_file, &m_fragment_shader_file};
+    for(int i = 0; i < 2; i++) {
+        std::vector<std::string> include_files;
+        char* source = file_read_with_includes(shader_files[i]->c_str(), &include_files);
+        if(source) {
+            free(source);
+        }
+        for(std::vector<std::string>::iterator p = include_files.begin(); p != include_files.end(); p++) {
+            key = hash_combine(key, hash_file(*p));
+            m_include_files.push_back(*p);
+        }
+    }
+    return hash_combine(key, Program::get_driver_hash());
+}
+
+void Material::clear_pending_program()
+{
+    if(m_pending_program)         { delete m_pending_program;         m_pending_program = NULL; }
+    if(m_pending_vertex_shader)   { delete m_pending_vertex_shader;   m_pending_vertex_shader = NULL; }
+    if(m_pending_fragment_shader) { delete m_pending_fragment_shader; m_pending_fragment_shader = NULL; }
 }
 
 void Material::add_texture(Texture* texture)
@@ -17,39 +17,122 @@
 
 #include <Mesh.h>
 #include <Buffer.h>
+#include <Deformer.h>
+#include <MeshAllocator.h>
 #include <Material.h>
+#include <Program.h>
 #include <Texture.h>
 #include <PrimitiveFactory.h>
+#include <Modifiers.h>
 #include <Util.h>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/vector_angle.hpp>
+#include <glm/gtc/packing.hpp>
 #include <string>
 #include <cstring>
 #include <iostream>
+#include <algorithm>
+#include <vector>
+#include <thread>
+#include <sstream>
+#include <math.h>
+#include <assert.h>
+
+#define PARALLEL_NORMALS_MIN_TRI 16384
+#define MAX_NORMALS_THREADS      8
+#define MIN_LOD_TRI              8
 
 namespace vt {
 
-Mesh::Mesh(const std::string& name,
-                 size_t       num_vertex,
-                 size_t       num_tri)
+static size_t align_storage_size(size_t size)
+{
+    return (size + MESH_ALLOC_ALIGNMENT - 1) & ~static_cast<size_t>(MESH_ALLOC_ALIGNMENT - 1);
+}
+
+// accumulates area-weighted face normals and uv-derived tangents (unnormalized)
+static void accumulate_smooth_normals_and_tangents(const glm::vec3* vert_coords,
+                                                   const glm::vec2* tex_coords,
+                                                   const GLushort*  tri_indices,
+                                                   int              tri_begin,
+                                                   int              tri_end,
+                                                   size_t           num_vertex,
+                                                   glm::vec3*       normal_accum,
+                                                   glm::vec3*       tangent_accum)
+{
+    memset(normal_accum,  0, sizeof(glm::vec3) * num_vertex);
+    memset(tangent_accum, 0, sizeof(glm::vec3) * num_vertex);
+    for(int i = tri_begin; i < tri_end; i++) {
+        int i0 = tri_indices[i * 3 + 0];
+        int i1 = tri_indices[i * 3 + 1];
+        int i2 = tri_indices[i * 3 + 2];
+        glm::vec3 e1   = vert_coords[i1] - vert_coords[i0];
+        glm::vec3 e2   = vert_coords[i2] - vert_coords[i0];
+        glm::vec2 duv1 = tex_coords[i1]  - tex_coords[i0];
+        glm::vec2 duv2 = tex_coords[i2]  - tex_coords[i0];
+        glm::vec3 n    = glm::cross(e1, e2); // length is twice triangle area
+        float     r    = duv1.x * duv2.y - duv2.x * duv1.y;
+        glm::vec3 t    = (fabs(r) > EPSILON) ? (e1 * duv2.y - e2 * duv1.y) * (1 / r) : e1; // fall back to first edge without uvs
+        float     t_len = glm::length(t);
+        if(t_len > EPSILON) {
+            t *= glm::length(n) / t_len;
+        }
+        normal_accum[i0]  += n;
+        normal_accum[i1]  += n;
+        normal_accum[i2]  += n;
+        tangent_accum[i0] += t;
+        tangent_accum[i1] += t;
+        tangent_accum[i2] += t;
+    }
+}
+
+Mesh::Mesh(const std::string&   name,
+                 size_t         num_vertex,
+                 size_t         num_tri,
+                 MeshAllocator* allocator)
     : TransformObject(name),
       m_num_vertex(num_vertex),
       m_num_tri(num_tri),
+      m_vertex_capacity(0),
+      m_tri_capacity(0),
+      m_allocator(allocator ? allocator : MeshAllocator::get_default()),
+      m_storage(NULL),
+      m_storage_size(0),
       m_visible(true),
       m_smooth(false),
+      m_vert_coords(NULL),
+      m_vert_normal(NULL),
+      m_vert_tangent(NULL),
+      m_tex_coords(NULL),
+      m_tri_indices(NULL),
       m_vbo_vert_coords(NULL),
       m_vbo_vert_normal(NULL),
       m_vbo_vert_tangent(NULL),
       m_vbo_tex_coords(NULL),
       m_ibo_tri_indices(NULL),
+      m_bone_indices(NULL),
+      m_bone_weights(NULL),
+      m_vbo_bone_indices(NULL),
+      m_vbo_bone_weights(NULL),
+      m_compressed(false),
+      m_packed_vert_coords(NULL),
+      m_packed_vert_normal(NULL),
+      m_packed_vert_tangent(NULL),
+      m_packed_tex_coords(NULL),
+      m_vbo_packed_vert_coords(NULL),
+      m_vbo_packed_vert_normal(NULL),
+      m_vbo_packed_vert_tangent(NULL),
+      m_vbo_packed_tex_coords(NULL),
+      m_position_dequant_offset(0),
+      m_position_dequant_scale(1),
       m_buffers_already_init(false),
       m_material(NULL),
       m_shader_context(NULL),
       m_normal_shader_context(NULL),
       m_wireframe_shader_context(NULL),
       m_ssao_shader_context(NULL),
+      m_fallback_shader_context(NULL),
       m_texture_index(-1),
       m_texture2_index(-1),
       m_bump_texture_index(-1),
@@ -58,13 +141,11 @@ Mesh::Mesh(const std::string& name,
       m_frontface_depth_overlay_texture_index(-1),
       m_backface_depth_overlay_texture_index(-1),
       m_backface_normal_overlay_texture_index(-1),
-      m_reflect_to_refract_ratio(1)
+      m_reflect_to_refract_ratio(1),
+      m_deformer(NULL),
+      m_cur_lod(0)
 {
-    m_vert_coords   = new GLfloat[ num_vertex * 3];
-    m_vert_normal   = new GLfloat[ num_vertex * 3];
-    m_vert_tangent  = new GLfloat[ num_vertex * 3];
-    m_tex_coords    = new GLfloat[ num_vertex * 2];
-    m_tri_indices   = new GLushort[num_tri    * 3];
+    realloc_storage(num_vertex, num_tri, 0, 0);
     memset(m_vert_coords,  0, sizeof(GLfloat)  * num_vertex * 3);
     memset(m_vert_normal,  0, sizeof(GLfloat)  * num_vertex * 3);
     memset(m_vert_tangent, 0, sizeof(GLfloat)  * num_vertex * 3);
@@ -78,11 +159,7 @@ Mesh::Mesh(const std::string& name,
 
 Mesh::~Mesh()
 {
-    if(m_vert_coords)              { delete[] m_vert_coords; }
-    if(m_vert_normal)              { delete[] m_vert_normal; }
-    if(m_vert_tangent)             { delete[] m_vert_tangent; }
-    if(m_tex_coords)               { delete[] m_tex_coords; }
-    if(m_tri_indices)              { delete[] m_tri_indices; }
+    if(m_storage)                  { m_allocator->free(m_storage, m_storage_size); }
     if(m_ambient_color)            { delete[] m_ambient_color; }
     if(m_vbo_vert_coords)          { delete m_vbo_vert_coords; }
     if(m_vbo_vert_normal)          { delete m_vbo_vert_normal; }
@@ -93,40 +170,14 @@ Mesh::~Mesh()
     if(m_normal_shader_context)    { delete m_normal_shader_context; }
     if(m_wireframe_shader_context) { delete m_wireframe_shader_context; }
     if(m_ssao_shader_context)      { delete m_ssao_shader_context; }
+    if(m_fallback_shader_context)  { delete m_fallback_shader_context; }
+    free_skin_data();
+    free_packed_data();
+    clear_lods();
 }
 
 void Mesh::resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry)
 {
-    glm::vec3*  backup_vert_coord   = NULL;
-    glm::vec3*  backup_vert_normal  = NULL;
-    glm::vec3*  backup_vert_tangent = NULL;
-    glm::vec2*  backup_tex_coord    = NULL;
-    glm::ivec3* backup_tri_indices  = NULL;
-    if(preserve_mesh_geometry) {
-        backup_vert_coord   = new glm::vec3[num_vertex];
-        backup_vert_normal  = new glm::vec3[num_vertex];
-        backup_vert_tangent = new glm::vec3[num_vertex];
-        backup_tex_coord    = new glm::vec2[num_vertex];
-        backup_tri_indices  = new glm::ivec3[num_tri];
-        if(backup_vert_coord && backup_vert_normal && backup_vert_tangent && backup_tex_coord) {
-            for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-                backup_vert_coord[i]   = get_vert_coord(i);
-                backup_vert_normal[i]  = get_vert_normal(i);
-                backup_vert_tangent[i] = get_vert_tangent(i);
-                backup_tex_coord[i]    = get_tex_coord(i);
-            }
-        }
-        if(backup_tri_indices) {
-            for(int i = 0; i < static_cast<int>(num_tri); i++) {
-                backup_tri_indices[i] = get_tri_indices(i);
-            }
-        }
-    }
-    if(m_vert_coords)              { delete[] m_vert_coords; }
-    if(m_vert_normal)              { delete[] m_vert_normal; }
-    if(m_vert_tangent)             { delete[] m_vert_tangent; }
-    if(m_tex_coords)               { delete[] m_tex_coords; }
-    if(m_tri_indices)              { delete[] m_tri_indices; }
     if(m_vbo_vert_coords)          { delete m_vbo_vert_coords;          m_vbo_vert_coords = NULL; }
     if(m_vbo_vert_normal)          { delete m_vbo_vert_normal;          m_vbo_vert_normal = NULL; }
     if(m_vbo_vert_tangent)         { delete m_vbo_vert_tangent;         m_vbo_vert_tangent = NULL; }
@@ -136,41 +187,53 @@ void Mesh::resize(size_t num_vertex, size_t num_tri, bool preserve_mesh_geometry
     if(m_normal_shader_context)    { delete m_normal_shader_context;    m_normal_shader_context = NULL; }
     if(m_wireframe_shader_context) { delete m_wireframe_shader_context; m_wireframe_shader_context = NULL; }
     if(m_ssao_shader_context)      { delete m_ssao_shader_context;      m_ssao_shader_context = NULL; }
-    m_num_vertex   = num_vertex;
-    m_num_tri      = num_tri;
-    m_vert_coords  = new GLfloat[ num_vertex * 3];
-    m_vert_normal  = new GLfloat[ num_vertex * 3];
-    m_vert_tangent = new GLfloat[ num_vertex * 3];
-    m_tex_coords   = new GLfloat[ num_vertex * 2];
-    m_tri_indices  = new GLushort[num_tri    * 3];
-    memset(m_vert_coords,  0, sizeof(GLfloat)  * num_vertex * 3);
-    memset(m_vert_normal,  0, sizeof(GLfloat)  * num_vertex * 3);
-    memset(m_vert_tangent, 0, sizeof(GLfloat)  * num_vertex * 3);
-    memset(m_tex_coords,   0, sizeof(GLfloat)  * num_vertex * 2);
-    memset(m_tri_indices,  0, sizeof(GLushort) * num_tri    * 3);
+    if(m_fallback_shader_context)  { delete m_fallback_shader_context;  m_fallback_shader_context = NULL; }
+    free_skin_data(); // NOTE: bone weights don't survive topology changes
+    free_packed_data();
+    clear_lods();     // NOTE: lods were simplified from the old geometry
     m_buffers_already_init = false;
-    if(preserve_mesh_geometry) {
-        if(backup_vert_coord && backup_vert_normal && backup_vert_tangent && backup_tex_coord) {
-            for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-                set_vert_coord(i,   backup_vert_coord[i]);
-                set_vert_normal(i,  backup_vert_normal[i]);
-                set_vert_tangent(i, backup_vert_tangent[i]);
-                set_tex_coord(i,    backup_tex_coord[i]);
-            }
-            delete[] backup_vert_coord;
-            delete[] backup_vert_normal;
-            delete[] backup_vert_tangent;
-            delete[] backup_tex_coord;
-        }
-        if(backup_tri_indices) {
-            for(int i = 0; i < static_cast<int>(num_tri); i++) {
-                set_tri_indices(i, backup_tri_indices[i]);
-            }
-            delete[] backup_tri_indices;
-        }
+    size_t copy_num_vertex = preserve_mesh_geometry ? std::min(m_num_vertex, num_vertex) : 0;
+    size_t copy_num_tri    = preserve_mesh_geometry ? std::min(m_num_tri,    num_tri)    : 0;
+    if(!preserve_mesh_geometry) {
+        realloc_storage(num_vertex, num_tri, 0, 0);
+    } else if(num_vertex > m_vertex_capacity || num_tri > m_tri_capacity) {
+        // NOTE: geometric growth keeps repeated merges linear overall
+        realloc_storage((num_vertex > m_vertex_capacity) ? std::max(num_vertex, m_vertex_capacity * 2) : m_vertex_capacity,
+                        (num_tri    > m_tri_capacity)    ? std::max(num_tri,    m_tri_capacity    * 2) : m_tri_capacity,
+                        copy_num_vertex,
+                        copy_num_tri);
+    }
+    memset(get_vert_coords()   + copy_num_vertex,  0, sizeof(glm::vec3) * (num_vertex - copy_num_vertex));
+    memset(get_vert_normals()  + copy_num_vertex,  0, sizeof(glm::vec3) * (num_vertex - copy_num_vertex));
+    memset(get_vert_tangents() + copy_num_vertex,  0, sizeof(glm::vec3) * (num_vertex - copy_num_vertex));
+    memset(get_tex_coords()    + copy_num_vertex,  0, sizeof(glm::vec2) * (num_vertex - copy_num_vertex));
+    memset(m_tri_indices       + copy_num_tri * 3, 0, sizeof(GLushort)  * (num_tri    - copy_num_tri) * 3);
+    m_num_vertex = num_vertex;
+    m_num_tri    = num_tri;
+}
+
+// grows storage without changing vertex / triangle counts (e.g. before many merges)
+void Mesh::reserve(size_t num_vertex, size_t num_tri)
+{
+    if(num_vertex <= m_vertex_capacity && num_tri <= m_tri_capacity) {
+        return;
     }
+    realloc_storage(std::max(num_vertex, m_vertex_capacity),
+                    std::max(num_tri,    m_tri_capacity),
+                    m_num_vertex,
+                    m_num_tri);
 }
 
+// moves storage to another allocator (e.g. off the init arena before a mesh starts resizing)
+void Mesh::set_allocator(MeshAllocator* allocator)
+{
+    if(!allocator || allocator == m_allocator) {
+        return;
+    }
+    realloc_storage(m_vertex_capacity, m_tri_capacity, m_num_vertex, m_num_tri, allocator);
+}
+
+// NOTE: amortized linear in merged size (storage grows geometrically)
 void Mesh::merge(const MeshBase* other, bool copy_tex_coords)
 {
     size_t prev_num_vertex  = get_num_vertex();
@@ -180,21 +243,36 @@ void Mesh::merge(const MeshBase* other, bool copy_tex_coords)
     resize(prev_num_vertex + other_num_vertex,
            prev_num_tri    + other_num_tri,
            true);
-    for(int i = 0; i < static_cast<int>(other_num_vertex); i++) {
-        set_vert_coord(prev_num_vertex + i,   other->get_vert_coord(i));
-        set_vert_normal(prev_num_vertex + i,  other->get_vert_normal(i));
-        set_vert_tangent(prev_num_vertex + i, other->get_vert_tangent(i));
-    }
+    copy_vertices(other, prev_num_vertex, 0, other_num_vertex, copy_tex_coords);
+    copy_tri_indices(other, prev_num_tri, 0, other_num_tri, prev_num_vertex);
+    update_bbox();
+}
+
+void Mesh::copy_vertices(const MeshBase* other, int dest_index, int src_index, int count, bool copy_tex_coords)
+{
+    assert(dest_index >= 0 && dest_index + count <= static_cast<int>(m_num_vertex));
+    assert(src_index  >= 0 && src_index  + count <= static_cast<int>(other->get_num_vertex()));
+    memcpy(get_vert_coords()   + dest_index, other->get_vert_coords()   + src_index, sizeof(glm::vec3) * count);
+    memcpy(get_vert_normals()  + dest_index, other->get_vert_normals()  + src_index, sizeof(glm::vec3) * count);
+    memcpy(get_vert_tangents() + dest_index, other->get_vert_tangents() + src_index, sizeof(glm::vec3) * count);
     if(copy_tex_coords) {
-        for(int j = 0; j < static_cast<int>(other_num_vertex); j++) {
-            set_tex_coord(prev_num_vertex + j, other->get_tex_coord(j));
-        }
+        memcpy(get_tex_coords() + dest_index, other->get_tex_coords() + src_index, sizeof(glm::vec2) * count);
     }
-    for(int k = 0; k < static_cast<int>(other_num_tri); k++) {
-        glm::ivec3 prev_tri_indices = glm::ivec3(prev_num_vertex, prev_num_vertex, prev_num_vertex);
-        set_tri_indices(prev_num_tri + k, prev_tri_indices + other->get_tri_indices(k));
+}
+
+void Mesh::copy_tri_indices(const MeshBase* other, int dest_index, int src_index, int count, int index_offset)
+{
+    assert(dest_index >= 0 && dest_index + count <= static_cast<int>(m_num_tri));
+    assert(src_index  >= 0 && src_index  + count <= static_cast<int>(other->get_num_tri()));
+    const uint16_t* src_tri_indices  = other->get_tri_indices() + src_index * 3;
+    GLushort*       dest_tri_indices = m_tri_indices            + dest_index * 3;
+    if(!index_offset) {
+        memcpy(dest_tri_indices, src_tri_indices, sizeof(GLushort) * count * 3);
+        return;
+    }
+    for(int i = 0; i < count * 3; i++) {
+        dest_tri_indices[i] = src_tri_indices[i] + index_offset;
     }
-    update_bbox();
 }
 
 glm::vec3 Mesh::get_vert_coord(int index) const
@@ -283,74 +361,268 @@ glm::vec3 Mesh::get_vert_bitangent(int index) const
     return safe_normalize(glm::cross(get_vert_normal(index), get_vert_tangent(index)));
 }
 
+glm::ivec4 Mesh::get_bone_indices(int index) const
+{
+    if(!m_bone_indices) {
+        return glm::ivec4(0);
+    }
+    int offset = index * 4;
+    return glm::ivec4(static_cast<int>(m_bone_indices[offset + 0]),
+                      static_cast<int>(m_bone_indices[offset + 1]),
+                      static_cast<int>(m_bone_indices[offset + 2]),
+                      static_cast<int>(m_bone_indices[offset + 3]));
+}
+
+void Mesh::set_bone_indices(int index, glm::ivec4 indices)
+{
+    alloc_skin_data();
+    int offset = index * 4;
+    m_bone_indices[offset + 0] = indices[0];
+    m_bone_indices[offset + 1] = indices[1];
+    m_bone_indices[offset + 2] = indices[2];
+    m_bone_indices[offset + 3] = indices[3];
+}
+
+glm::vec4 Mesh::get_bone_weights(int index) const
+{
+    if(!m_bone_weights) {
+        return glm::vec4(0);
+    }
+    int offset = index * 4;
+    return glm::vec4(m_bone_weights[offset + 0],
+                     m_bone_weights[offset + 1],
+                     m_bone_weights[offset + 2],
+                     m_bone_weights[offset + 3]);
+}
+
+void Mesh::set_bone_weights(int index, glm::vec4 weights)
+{
+    alloc_skin_data();
+    int offset = index * 4;
+    m_bone_weights[offset + 0] = weights[0];
+    m_bone_weights[offset + 1] = weights[1];
+    m_bone_weights[offset + 2] = weights[2];
+    m_bone_weights[offset + 3] = weights[3];
+}
+
+// NOTE: bind pose is captured at time of binding, so bind with mesh and bones in rest pose
+int Mesh::add_bone(TransformObject* bone)
+{
+    m_bones.push_back(bone);
+    m_bind_pose_transforms.push_back(glm::inverse(bone->get_transform()) * get_transform());
+    m_bone_palette.push_back(glm::mat4(1));
+    return static_cast<int>(m_bones.size()) - 1;
+}
+
+void Mesh::clear_bones()
+{
+    m_bones.clear();
+    m_bind_pose_transforms.clear();
+    m_bone_palette.clear();
+}
+
+// bone palette maps bind pose mesh space to current mesh space
+void Mesh::update_bone_palette()
+{
+    glm::mat4 inv_transform = glm::inverse(get_transform());
+    for(int i = 0; i < static_cast<int>(m_bones.size()); i++) {
+        m_bone_palette[i] = inv_transform * m_bones[i]->get_transform() * m_bind_pose_transforms[i];
+    }
+}
+
+// cpu fallback for programs without skinning support (same blend as skinning.inc.glsl)
+void Mesh::skin_vertices(const MeshBase* bind_pose_mesh)
+{
+    if(!m_bone_indices || !m_bone_weights || !bind_pose_mesh) {
+        return;
+    }
+    assert(bind_pose_mesh->get_num_vertex() == m_num_vertex);
+    update_bone_palette();
+    int num_bones = static_cast<int>(m_bone_palette.size());
+    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
+        int offset = i * 4;
+        glm::mat4 skin_transform(0);
+        float sum_weights = 0;
+        for(int j = 0; j < 4; j++) {
+            float weight     = m_bone_weights[offset + j];
+            int   bone_index = static_cast<int>(m_bone_indices[offset + j]);
+            if(weight == 0 || bone_index < 0 || bone_index >= num_bones) {
+                continue;
+            }
+            skin_transform += m_bone_palette[bone_index] * weight;
+            sum_weights    += weight;
+        }
+        skin_transform += glm::mat4(1) * (1 - sum_weights); // unweighted remainder stays in bind pose
+        glm::mat3 skin_rotation(skin_transform);
+        set_vert_coord(i,   glm::vec3(skin_transform * glm::vec4(bind_pose_mesh->get_vert_coord(i), 1)));
+        set_vert_normal(i,  safe_normalize(skin_rotation * bind_pose_mesh->get_vert_normal(i)));
+        set_vert_tangent(i, safe_normalize(skin_rotation * bind_pose_mesh->get_vert_tangent(i)));
+    }
+    update_bbox();
+}
+
+// NOTE: takes ownership of lod (add from finest to coarsest)
+void Mesh::add_lod(Mesh* lod, float max_screen_size)
+{
+    lod->set_material(m_material);
+    lod->set_smooth(m_smooth);
+    lod->update_bbox();
+    m_lods.push_back(lod);
+    m_lod_screen_sizes.push_back(max_screen_size);
+}
+
+// builds a quadric-simplified lod chain, each level keeping tri_ratio of the previous level's triangles
+int Mesh::generate_lods(int num_lods, float tri_ratio, float max_screen_size)
+{
+    Mesh* prev_lod = m_lods.empty() ? this : m_lods.back();
+    for(int i = 0; i < num_lods; i++) {
+        int prev_num_tri   = prev_lod->get_num_tri();
+        int target_num_tri = static_cast<int>(prev_num_tri * tri_ratio);
+        if(target_num_tri < MIN_LOD_TRI) {
+            break;
+        }
+        std::stringstream ss;
+        ss << get_name() << "_lod" << (m_lods.size() + 1);
+        Mesh* lod = new Mesh(ss.str(), prev_lod->get_num_vertex(), prev_num_tri);
+        lod->copy_vertices(prev_lod, 0, 0, prev_lod->get_num_vertex());
+        lod->copy_tri_indices(prev_lod, 0, 0, prev_num_tri);
+        mesh_weld_vertices(lod);
+        if(mesh_simplify(lod, target_num_tri) >= prev_num_tri) {
+            delete lod; // no progress (e.g. every vertex is on a locked boundary)
+            break;
+        }
+        mesh_optimize(lod);
+
+        // NOTE: triangle density scales with projected area, so screen size thresholds scale with sqrt of triangle ratio
+        add_lod(lod, max_screen_size * pow(tri_ratio, m_lods.size() * 0.5));
+        prev_lod = lod;
+    }
+    return m_lods.size();
+}
+
+void Mesh::clear_lods()
+{
+    for(std::vector<Mesh*>::iterator p = m_lods.begin(); p != m_lods.end(); p++) {
+        delete *p;
+    }
+    m_lods.clear();
+    m_lod_screen_sizes.clear();
+    m_cur_lod = 0;
+}
+
+// screen_size is the fraction of viewport height covered by the bounding sphere
+// NOTE: hysteresis widens each threshold band to avoid popping at lod boundaries
+int Mesh::select_lod(float screen_size, float hysteresis)
+{
+    int num_lods = m_lods.size();
+    if(!num_lods) {
+        return 0;
+    }
+    m_cur_lod = std::min(m_cur_lod, num_lods);
+    while(m_cur_lod > 0 && screen_size > m_lod_screen_sizes[m_cur_lod - 1] * (1 + hysteresis)) {
+        m_cur_lod--;
+    }
+    while(m_cur_lod < num_lods && screen_size < m_lod_screen_sizes[m_cur_lod] * (1 - hysteresis)) {
+        m_cur_lod++;
+    }
+    return m_cur_lod;
+}
+
+// conservative world-space bounding sphere of local bbox
+void Mesh::get_bounding_sphere(glm::vec3* center, float* radius)
+{
+    glm::vec3 min, max;
+    get_min_max(&min, &max);
+    const glm::mat4 &transform = get_transform();
+    float max_scale = std::max(std::max(glm::length(glm::vec3(transform[0])),
+                                        glm::length(glm::vec3(transform[1]))),
+                                        glm::length(glm::vec3(transform[2])));
+    *center = glm::vec3(transform * glm::vec4((min + max) * 0.5f, 1));
+    *radius = glm::distance(min, max) * 0.5f * max_scale;
+}
+
 void Mesh::update_bbox()
 {
+    const glm::vec3* vert_coords = get_vert_coords();
 #if 1
-    glm::ivec3 tri_indices = get_tri_indices(0);
-    m_min = m_max = get_vert_coord(tri_indices[0]);
-    m_min = m_max = get_vert_coord(tri_indices[1]);
-    m_min = m_max = get_vert_coord(tri_indices[2]);
-    for(int i = 1; i < static_cast<int>(m_num_tri); i++) {
-        glm::ivec3 tri_indices = get_tri_indices(i);
-        glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-        glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-        glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-        m_max = glm::max(m_max, p0);
-        m_min = glm::min(m_min, p0);
-        m_max = glm::max(m_max, p1);
-        m_min = glm::min(m_min, p1);
-        m_max = glm::max(m_max, p2);
-        m_min = glm::min(m_min, p2);
+    int num_indices = static_cast<int>(m_num_tri) * 3;
+    m_min = m_max = vert_coords[m_tri_indices[0]];
+    for(int i = 1; i < num_indices; i++) {
+        const glm::vec3 &cur = vert_coords[m_tri_indices[i]];
+        m_max = glm::max(m_max, cur);
+        m_min = glm::min(m_min, cur);
     }
 #else
-    m_min = m_max = get_vert_coord(0);
+    m_min = m_max = vert_coords[0];
     for(int i = 1; i < static_cast<int>(m_num_vertex); i++) {
-        glm::vec3 cur = get_vert_coord(i);
+        const glm::vec3 &cur = vert_coords[i];
         m_max = glm::max(m_max, cur);
         m_min = glm::min(m_min, cur);
     }
 #endif
+    if(m_deformer) {
+        m_deformer->inflate_bbox(&m_min, &m_max); // gpu path never writes deformed positions back
+    }
 }
 
 void Mesh::update_normals_and_tangents()
 {
-    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
-        set_vert_normal( i, glm::vec3(0));
-        set_vert_tangent(i, glm::vec3(0));
-    }
+    const glm::vec3* vert_coords   = get_vert_coords();
+    const glm::vec2* tex_coords    = get_tex_coords();
+    glm::vec3*       vert_normals  = get_vert_normals();
+    glm::vec3*       vert_tangents = get_vert_tangents();
     if(m_smooth) {
-        for(int i = 0; i < static_cast<int>(m_num_tri); i++) {
-            glm::ivec3 tri_indices = get_tri_indices(i);
-            glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-            glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-            glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-            glm::vec3 e1 = safe_normalize(p1 - p0);
-            glm::vec3 e2 = safe_normalize(p2 - p0);
-            glm::vec3 n  = safe_normalize(glm::cross(e1, e2));
-            for(int j = 0; j < 3; j++) {
-                int vert_index = tri_indices[j];
-                set_vert_normal( vert_index, get_vert_normal(vert_index) + n);
-                set_vert_tangent(vert_index, glm::vec3(0));
+        int num_threads = 1;
+        if(m_num_tri >= PARALLEL_NORMALS_MIN_TRI) {
+            num_threads = std::min(static_cast<int>(std::thread::hardware_concurrency()), MAX_NORMALS_THREADS);
+            num_threads = std::max(num_threads, 1);
+        }
+
+        // NOTE: each thread accumulates into its own buffers, so shared vertices need no locking
+        std::vector<glm::vec3> thread_accum((num_threads - 1) * m_num_vertex * 2);
+        std::vector<std::thread> threads;
+        int tri_per_thread = (static_cast<int>(m_num_tri) + num_threads - 1) / num_threads;
+        for(int t = 1; t < num_threads; t++) {
+            glm::vec3* normal_accum  = &thread_accum[(t - 1) * m_num_vertex * 2];
+            glm::vec3* tangent_accum = normal_accum + m_num_vertex;
+            int tri_begin = std::min(t * tri_per_thread, static_cast<int>(m_num_tri));
+            int tri_end   = std::min(tri_begin + tri_per_thread, static_cast<int>(m_num_tri));
+            threads.push_back(std::thread(accumulate_smooth_normals_and_tangents,
+                                          vert_coords, tex_coords, m_tri_indices, tri_begin, tri_end,
+                                          m_num_vertex, normal_accum, tangent_accum));
+        }
+        accumulate_smooth_normals_and_tangents(vert_coords, tex_coords, m_tri_indices, 0, std::min(tri_per_thread, static_cast<int>(m_num_tri)),
+                                               m_num_vertex, vert_normals, vert_tangents);
+        for(int t = 0; t < static_cast<int>(threads.size()); t++) {
+            threads[t].join();
+            const glm::vec3* normal_accum  = &thread_accum[t * m_num_vertex * 2];
+            const glm::vec3* tangent_accum = normal_accum + m_num_vertex;
+            for(int k = 0; k < static_cast<int>(m_num_vertex); k++) {
+                vert_normals[k]  += normal_accum[k];
+                vert_tangents[k] += tangent_accum[k];
             }
         }
+
+        // gram-schmidt orthogonalize tangent against normal
         for(int k = 0; k < static_cast<int>(m_num_vertex); k++) {
-            set_vert_normal(k, safe_normalize(get_vert_normal(k)));
+            glm::vec3 n = safe_normalize(vert_normals[k]);
+            glm::vec3 t = vert_tangents[k] - n * glm::dot(n, vert_tangents[k]);
+            vert_normals[k]  = n;
+            vert_tangents[k] = safe_normalize(t);
         }
-        resize(m_num_vertex, m_num_tri, true);
         return;
     }
     for(int i = 0; i < static_cast<int>(m_num_tri); i++) {
-        glm::ivec3 tri_indices = get_tri_indices(i);
-        glm::vec3 p0 = get_vert_coord(tri_indices[0]);
-        glm::vec3 p1 = get_vert_coord(tri_indices[1]);
-        glm::vec3 p2 = get_vert_coord(tri_indices[2]);
-        glm::vec3 e1 = safe_normalize(p1 - p0);
-        glm::vec3 e2 = safe_normalize(p2 - p0);
+        const GLushort* tri_indices = &m_tri_indices[i * 3];
+        glm::vec3 p0 = vert_coords[tri_indices[0]];
+        glm::vec3 e1 = vert_coords[tri_indices[1]] - p0;
+        glm::vec3 e2 = vert_coords[tri_indices[2]] - p0;
         glm::vec3 n  = safe_normalize(glm::cross(e1, e2));
+        glm::vec3 t  = safe_normalize(e1);
         for(int j = 0; j < 3; j++) {
             int vert_index = tri_indices[j];
-            set_vert_normal( vert_index, n);
-            set_vert_tangent(vert_index, e1);
+            vert_normals[vert_index]  = n;
+            vert_tangents[vert_index] = t;
         }
     }
 }
@@ -372,47 +644,87 @@ void Mesh::init_buffers()
     if(m_buffers_already_init) {
         return;
     }
-    m_vbo_vert_coords  = new Buffer(GL_ARRAY_BUFFER,         sizeof(GLfloat)  * m_num_vertex * 3, m_vert_coords);
-    m_vbo_vert_normal  = new Buffer(GL_ARRAY_BUFFER,         sizeof(GLfloat)  * m_num_vertex * 3, m_vert_normal);
-    m_vbo_vert_tangent = new Buffer(GL_ARRAY_BUFFER,         sizeof(GLfloat)  * m_num_vertex * 3, m_vert_tangent);
-    m_vbo_tex_coords   = new Buffer(GL_ARRAY_BUFFER,         sizeof(GLfloat)  * m_num_vertex * 2, m_tex_coords);
-    m_ibo_tri_indices  = new Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * m_num_tri    * 3, m_tri_indices);
+    m_ibo_tri_indices = new Buffer(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLushort) * m_num_tri * 3, m_tri_indices);
+    if(m_compressed) {
+        pack_vertices();
+        m_vbo_packed_vert_coords  = new Buffer(GL_ARRAY_BUFFER, sizeof(GLshort)  * m_num_vertex * 4, m_packed_vert_coords);
+        m_vbo_packed_vert_normal  = new Buffer(GL_ARRAY_BUFFER, sizeof(GLshort)  * m_num_vertex * 2, m_packed_vert_normal);
+        m_vbo_packed_vert_tangent = new Buffer(GL_ARRAY_BUFFER, sizeof(GLshort)  * m_num_vertex * 2, m_packed_vert_tangent);
+        m_vbo_packed_tex_coords   = new Buffer(GL_ARRAY_BUFFER, sizeof(GLushort) * m_num_vertex * 2, m_packed_tex_coords);
+    } else {
+        init_float_buffers();
+    }
+    if(m_bone_indices && m_bone_weights) {
+        m_vbo_bone_indices = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 4, m_bone_indices);
+        m_vbo_bone_weights = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 4, m_bone_weights);
+    }
     m_buffers_already_init = true;
 }
 
-void Mesh::update_buffers() const
+// NOTE: compressed meshes only get float vbos if a program can't decode packed attributes (see vertex_decode.inc.glsl)
+void Mesh::init_float_buffers()
+{
+    if(m_vbo_vert_coords) {
+        return;
+    }
+    m_vbo_vert_coords  = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 3, m_vert_coords);
+    m_vbo_vert_normal  = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 3, m_vert_normal);
+    m_vbo_vert_tangent = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 3, m_vert_tangent);
+    m_vbo_tex_coords   = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 2, m_tex_coords);
+}
+
+void Mesh::update_buffers()
 {
     if(!m_buffers_already_init) {
         return;
     }
-    m_vbo_vert_coords->update();
-    m_vbo_vert_normal->update();
-    m_vbo_vert_tangent->update();
-    m_vbo_tex_coords->update();
+    if(m_vbo_vert_coords) {
+        m_vbo_vert_coords->update();
+        m_vbo_vert_normal->update();
+        m_vbo_vert_tangent->update();
+        m_vbo_tex_coords->update();
+    }
+    if(m_vbo_packed_vert_coords) {
+        pack_vertices();
+        m_vbo_packed_vert_coords->update();
+        m_vbo_packed_vert_normal->update();
+        m_vbo_packed_vert_tangent->update();
+        m_vbo_packed_tex_coords->update();
+    }
     m_ibo_tri_indices->update();
+    if(m_vbo_bone_indices) {
+        m_vbo_bone_indices->update();
+    }
+    if(m_vbo_bone_weights) {
+        m_vbo_bone_weights->update();
+    }
 }
 
 Buffer* Mesh::get_vbo_vert_coords()
 {
     init_buffers();
+    init_float_buffers();
     return m_vbo_vert_coords;
 }
 
 Buffer* Mesh::get_vbo_vert_normal()
 {
     init_buffers();
+    init_float_buffers();
     return m_vbo_vert_normal;
 }
 
 Buffer* Mesh::get_vbo_vert_tangent()
 {
     init_buffers();
+    init_float_buffers();
     return m_vbo_vert_tangent;
 }
 
 Buffer* Mesh::get_vbo_tex_coords()
 {
     init_buffers();
+    init_float_buffers();
     return m_vbo_tex_coords;
 }
 
@@ -422,6 +734,42 @@ Buffer* Mesh::get_ibo_tri_indices()
     return m_ibo_tri_indices;
 }
 
+Buffer* Mesh::get_vbo_bone_indices()
+{
+    init_buffers();
+    return m_vbo_bone_indices;
+}
+
+Buffer* Mesh::get_vbo_bone_weights()
+{
+    init_buffers();
+    return m_vbo_bone_weights;
+}
+
+// NOTE: shader contexts pick float or packed vbos by which attributes their program reads
+// NOTE: none until the material's program has linked, since the context snapshots its variable tables
+ShaderContext* Mesh::create_shader_context(Material* material)
+{
+    if(!material->is_ready()) {
+        return NULL;
+    }
+    Program* program   = material->get_program();
+    bool     use_float = !m_compressed || !program->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_packed_position);
+    init_buffers();
+    return new ShaderContext(material,
+                             use_float ? get_vbo_vert_coords()  : NULL,
+                             use_float ? get_vbo_vert_normal()  : NULL,
+                             use_float ? get_vbo_vert_tangent() : NULL,
+                             use_float ? get_vbo_tex_coords()   : NULL,
+                             get_ibo_tri_indices(),
+                             get_vbo_bone_indices(),
+                             get_vbo_bone_weights(),
+                             m_vbo_packed_vert_coords,
+                             m_vbo_packed_vert_normal,
+                             m_vbo_packed_vert_tangent,
+                             m_vbo_packed_tex_coords);
+}
+
 void Mesh::set_material(Material* material)
 {
     // NOTE: texture index for same texture varies from material to material
@@ -441,6 +789,9 @@ void Mesh::set_material(Material* material)
     }
     m_material = material;
     m_texture_index = material ? material->get_texture_index_by_name(texture_name) : -1;
+    for(std::vector<Mesh*>::iterator p = m_lods.begin(); p != m_lods.end(); p++) {
+        (*p)->set_material(material);
+    }
 }
 
 ShaderContext* Mesh::get_shader_context()
@@ -448,12 +799,7 @@ ShaderContext* Mesh::get_shader_context()
     if(m_shader_context || !m_material) { // FIX-ME! -- potential bug if Material not set
         return m_shader_context;
     }
-    m_shader_context = new ShaderContext(m_material,
-                                         get_vbo_vert_coords(),
-                                         get_vbo_vert_normal(),
-                                         get_vbo_vert_tangent(),
-                                         get_vbo_tex_coords(),
-                                         get_ibo_tri_indices());
+    m_shader_context = create_shader_context(m_material);
     return m_shader_context;
 }
 
@@ -462,12 +808,7 @@ ShaderContext* Mesh::get_normal_shader_context(Material* normal_material)
     if(m_normal_shader_context || !normal_material) { // FIX-ME! -- potential bug if Material not set
         return m_normal_shader_context;
     }
-    m_normal_shader_context = new ShaderContext(normal_material,
-                                                get_vbo_vert_coords(),
-                                                get_vbo_vert_normal(),
-                                                get_vbo_vert_tangent(),
-                                                get_vbo_tex_coords(),
-                                                get_ibo_tri_indices());
+    m_normal_shader_context = create_shader_context(normal_material);
     return m_normal_shader_context;
 }
 
@@ -476,12 +817,7 @@ ShaderContext* Mesh::get_wireframe_shader_context(Material* wireframe_material)
     if(m_wireframe_shader_context || !wireframe_material) { // FIX-ME! -- potential bug if Material not set
         return m_wireframe_shader_context;
     }
-    m_wireframe_shader_context = new ShaderContext(wireframe_material,
-                                                   get_vbo_vert_coords(),
-                                                   get_vbo_vert_normal(),
-                                                   get_vbo_vert_tangent(),
-                                                   get_vbo_tex_coords(),
-                                                   get_ibo_tri_indices());
+    m_wireframe_shader_context = create_shader_context(wireframe_material);
     return m_wireframe_shader_context;
 }
 
@@ -490,15 +826,32 @@ ShaderContext* Mesh::get_ssao_shader_context(Material* ssao_material)
     if(m_ssao_shader_context || !ssao_material) { // FIX-ME! -- potential bug if Material not set
         return m_ssao_shader_context;
     }
-    m_ssao_shader_context = new ShaderContext(ssao_material,
-                                              get_vbo_vert_coords(),
-                                              get_vbo_vert_normal(),
-                                              get_vbo_vert_tangent(),
-                                              get_vbo_tex_coords(),
-                                              get_ibo_tri_indices());
+    m_ssao_shader_context = create_shader_context(ssao_material);
     return m_ssao_shader_context;
 }
 
+// NOTE: contexts are rebuilt on next use, e.g. after a material swaps in a reloaded program
+void Mesh::clear_shader_contexts()
+{
+    if(m_shader_context)           { delete m_shader_context;           m_shader_context = NULL; }
+    if(m_normal_shader_context)    { delete m_normal_shader_context;    m_normal_shader_context = NULL; }
+    if(m_wireframe_shader_context) { delete m_wireframe_shader_context; m_wireframe_shader_context = NULL; }
+    if(m_ssao_shader_context)      { delete m_ssao_shader_context;      m_ssao_shader_context = NULL; }
+    if(m_fallback_shader_context)  { delete m_fallback_shader_context;  m_fallback_shader_context = NULL; }
+    for(std::vector<Mesh*>::iterator p = m_lods.begin(); p != m_lods.end(); p++) {
+        (*p)->clear_shader_contexts();
+    }
+}
+
+ShaderContext* Mesh::get_fallback_shader_context(Material* fallback_material)
+{
+    if(m_fallback_shader_context || !fallback_material) {
+        return m_fallback_shader_context;
+    }
+    m_fallback_shader_context = create_shader_context(fallback_material);
+    return m_fallback_shader_context;
+}
+
 glm::vec3 Mesh::get_ambient_color() const
 {
     return glm::vec3(m_ambient_color[0],
@@ -513,13 +866,23 @@ void Mesh::set_ambient_color(glm::vec3 ambient_color)
     m_ambient_color[2] = ambient_color.b;
 }
 
+// NOTE: call again after changing the deformer's amplitude (phase alone keeps the bbox)
+void Mesh::set_deformer(Deformer* deformer)
+{
+    m_deformer = deformer;
+    update_bbox();
+}
+
 void Mesh::transform_vertices(glm::mat4 transform)
 {
-    glm::mat4 normal_transform = glm::transpose(glm::inverse(transform));
+    glm::mat4  normal_transform = glm::transpose(glm::inverse(transform));
+    glm::vec3* vert_coords      = get_vert_coords();
+    glm::vec3* vert_normals     = get_vert_normals();
+    glm::vec3* vert_tangents    = get_vert_tangents();
     for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
-        set_vert_coord(i,   glm::vec3(transform        * glm::vec4(get_vert_coord(i),   1)));
-        set_vert_normal(i,  glm::vec3(normal_transform * glm::vec4(get_vert_normal(i),  1)));
-        set_vert_tangent(i, glm::vec3(normal_transform * glm::vec4(get_vert_tangent(i), 1)));
+        vert_coords[i]   = glm::vec3(transform        * glm::vec4(vert_coords[i],   1));
+        vert_normals[i]  = glm::vec3(normal_transform * glm::vec4(vert_normals[i],  1));
+        vert_tangents[i] = glm::vec3(normal_transform * glm::vec4(vert_tangents[i], 1));
     }
     update_bbox();
 }
@@ -548,6 +911,192 @@ void Mesh::center_axis(BBoxObject::align_t align)
     set_axis(glm::vec3(get_transform() * glm::vec4(get_center(align), 1)));
 }
 
+// NOTE: compressed meshes upload 20 bytes per vertex instead of 44 (cpu copy stays float for modifiers)
+void Mesh::set_compressed(bool compressed)
+{
+    for(std::vector<Mesh*>::iterator p = m_lods.begin(); p != m_lods.end(); p++) {
+        (*p)->set_compressed(compressed);
+    }
+    if(compressed == m_compressed) {
+        return;
+    }
+    m_compressed = compressed;
+    if(m_vbo_vert_coords)          { delete m_vbo_vert_coords;          m_vbo_vert_coords = NULL; }
+    if(m_vbo_vert_normal)          { delete m_vbo_vert_normal;          m_vbo_vert_normal = NULL; }
+    if(m_vbo_vert_tangent)         { delete m_vbo_vert_tangent;         m_vbo_vert_tangent = NULL; }
+    if(m_vbo_tex_coords)           { delete m_vbo_tex_coords;           m_vbo_tex_coords = NULL; }
+    if(m_ibo_tri_indices)          { delete m_ibo_tri_indices;          m_ibo_tri_indices = NULL; }
+    if(m_vbo_bone_indices)         { delete m_vbo_bone_indices;         m_vbo_bone_indices = NULL; }
+    if(m_vbo_bone_weights)         { delete m_vbo_bone_weights;         m_vbo_bone_weights = NULL; }
+    if(m_shader_context)           { delete m_shader_context;           m_shader_context = NULL; }
+    if(m_normal_shader_context)    { delete m_normal_shader_context;    m_normal_shader_context = NULL; }
+    if(m_wireframe_shader_context) { delete m_wireframe_shader_context; m_wireframe_shader_context = NULL; }
+    if(m_ssao_shader_context)      { delete m_ssao_shader_context;      m_ssao_shader_context = NULL; }
+    if(m_fallback_shader_context)  { delete m_fallback_shader_context;  m_fallback_shader_context = NULL; }
+    free_packed_data();
+    m_buffers_already_init = false;
+}
+
+// bytes of vertex attribute data uploaded to gpu (0 until buffers are created)
+size_t Mesh::get_vertex_buffer_size() const
+{
+    Buffer* vbos[] = {m_vbo_vert_coords,
+                      m_vbo_vert_normal,
+                      m_vbo_vert_tangent,
+                      m_vbo_tex_coords,
+                      m_vbo_packed_vert_coords,
+                      m_vbo_packed_vert_normal,
+                      m_vbo_packed_vert_tangent,
+                      m_vbo_packed_tex_coords};
+    size_t size = 0;
+    for(int i = 0; i < static_cast<int>(sizeof(vbos) / sizeof(vbos[0])); i++) {
+        if(vbos[i]) {
+            size += vbos[i]->size();
+        }
+    }
+    return size;
+}
+
+static glm::vec2 oct_encode(glm::vec3 v)
+{
+    float     l1_norm = fabs(v.x) + fabs(v.y) + fabs(v.z);
+    glm::vec2 e       = (l1_norm > EPSILON) ? glm::vec2(v.x, v.y) / l1_norm : glm::vec2(0);
+    if(v.z < 0) {
+        e = (glm::vec2(1) - glm::abs(glm::vec2(e.y, e.x))) * glm::vec2(e.x >= 0 ? 1 : -1, e.y >= 0 ? 1 : -1);
+    }
+    return e;
+}
+
+static GLshort pack_snorm16(float x)
+{
+    return static_cast<GLshort>(floor(CLAMP(x, -1.0f, 1.0f) * 32767 + 0.5f));
+}
+
+// quantizes positions to bbox, octahedral-encodes normals / tangents and halves uvs
+void Mesh::pack_vertices()
+{
+    if(!m_packed_vert_coords) {
+        m_packed_vert_coords  = new GLshort[ m_num_vertex * 4];
+        m_packed_vert_normal  = new GLshort[ m_num_vertex * 2];
+        m_packed_vert_tangent = new GLshort[ m_num_vertex * 2];
+        m_packed_tex_coords   = new GLushort[m_num_vertex * 2];
+    }
+    const glm::vec3* vert_coords   = get_vert_coords();
+    const glm::vec3* vert_normals  = get_vert_normals();
+    const glm::vec3* vert_tangents = get_vert_tangents();
+    const glm::vec2* tex_coords    = get_tex_coords();
+    glm::vec3 min(BIG_NUMBER), max(-BIG_NUMBER);
+    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
+        min = glm::min(min, vert_coords[i]);
+        max = glm::max(max, vert_coords[i]);
+    }
+    m_position_dequant_offset = m_num_vertex ? (min + max) * 0.5f : glm::vec3(0);
+    m_position_dequant_scale  = m_num_vertex ? glm::max((max - min) * 0.5f, glm::vec3(EPSILON)) : glm::vec3(1);
+    for(int i = 0; i < static_cast<int>(m_num_vertex); i++) {
+        glm::vec3 q = (vert_coords[i] - m_position_dequant_offset) / m_position_dequant_scale;
+        glm::vec2 n = oct_encode(vert_normals[i]);
+        glm::vec2 t = oct_encode(vert_tangents[i]);
+        m_packed_vert_coords[i * 4 + 0]  = pack_snorm16(q.x);
+        m_packed_vert_coords[i * 4 + 1]  = pack_snorm16(q.y);
+        m_packed_vert_coords[i * 4 + 2]  = pack_snorm16(q.z);
+        m_packed_vert_coords[i * 4 + 3]  = 0;
+        m_packed_vert_normal[i * 2 + 0]  = pack_snorm16(n.x);
+        m_packed_vert_normal[i * 2 + 1]  = pack_snorm16(n.y);
+        m_packed_vert_tangent[i * 2 + 0] = pack_snorm16(t.x);
+        m_packed_vert_tangent[i * 2 + 1] = pack_snorm16(t.y);
+        m_packed_tex_coords[i * 2 + 0]   = glm::packHalf1x16(tex_coords[i].x);
+        m_packed_tex_coords[i * 2 + 1]   = glm::packHalf1x16(tex_coords[i].y);
+    }
+}
+
+void Mesh::free_packed_data()
+{
+    if(m_packed_vert_coords)      { delete[] m_packed_vert_coords;    m_packed_vert_coords = NULL; }
+    if(m_packed_vert_normal)      { delete[] m_packed_vert_normal;    m_packed_vert_normal = NULL; }
+    if(m_packed_vert_tangent)     { delete[] m_packed_vert_tangent;   m_packed_vert_tangent = NULL; }
+    if(m_packed_tex_coords)       { delete[] m_packed_tex_coords;     m_packed_tex_coords = NULL; }
+    if(m_vbo_packed_vert_coords)  { delete m_vbo_packed_vert_coords;  m_vbo_packed_vert_coords = NULL; }
+    if(m_vbo_packed_vert_normal)  { delete m_vbo_packed_vert_normal;  m_vbo_packed_vert_normal = NULL; }
+    if(m_vbo_packed_vert_tangent) { delete m_vbo_packed_vert_tangent; m_vbo_packed_vert_tangent = NULL; }
+    if(m_vbo_packed_tex_coords)   { delete m_vbo_packed_tex_coords;   m_vbo_packed_tex_coords = NULL; }
+}
+
+void Mesh::alloc_skin_data()
+{
+    if(m_bone_indices && m_bone_weights) {
+        return;
+    }
+    m_bone_indices = new GLfloat[m_num_vertex * 4];
+    m_bone_weights = new GLfloat[m_num_vertex * 4];
+    memset(m_bone_indices, 0, sizeof(GLfloat) * m_num_vertex * 4);
+    memset(m_bone_weights, 0, sizeof(GLfloat) * m_num_vertex * 4);
+    if(m_buffers_already_init) {
+        m_vbo_bone_indices = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 4, m_bone_indices);
+        m_vbo_bone_weights = new Buffer(GL_ARRAY_BUFFER, sizeof(GLfloat) * m_num_vertex * 4, m_bone_weights);
+    }
+
+    // NOTE: shader contexts cache vbos, so rebuild them to pick up bone vbos
+    if(m_shader_context)           { delete m_shader_context;           m_shader_context = NULL; }
+    if(m_normal_shader_context)    { delete m_normal_shader_context;    m_normal_shader_context = NULL; }
+    if(m_wireframe_shader_context) { delete m_wireframe_shader_context; m_wireframe_shader_context = NULL; }
+    if(m_ssao_shader_context)      { delete m_ssao_shader_context;      m_ssao_shader_context = NULL; }
+    if(m_fallback_shader_context)  { delete m_fallback_shader_context;  m_fallback_shader_context = NULL; }
+}
+
+// NOTE: all attributes share one aligned block, laid out as coords / normals / tangents / tex coords / indices
+void Mesh::realloc_storage(size_t         vertex_capacity,
+                           size_t         tri_capacity,
+                           size_t         copy_num_vertex,
+                           size_t         copy_num_tri,
+                           MeshAllocator* allocator)
+{
+    if(!allocator) {
+        allocator = m_allocator;
+    }
+    size_t vec3_array_size  = align_storage_size(sizeof(GLfloat)  * vertex_capacity * 3);
+    size_t vec2_array_size  = align_storage_size(sizeof(GLfloat)  * vertex_capacity * 2);
+    size_t index_array_size = align_storage_size(sizeof(GLushort) * tri_capacity    * 3);
+    size_t storage_size     = vec3_array_size * 3 + vec2_array_size + index_array_size;
+    bool   in_place         = m_storage && allocator == m_allocator && storage_size >= m_storage_size &&
+                              m_allocator->grow_in_place(m_storage, m_storage_size, storage_size);
+    char*  storage          = in_place ? reinterpret_cast<char*>(m_storage) : reinterpret_cast<char*>(allocator->alloc(storage_size));
+    assert(storage);
+    GLfloat*  vert_coords  = reinterpret_cast<GLfloat*>( storage);
+    GLfloat*  vert_normal  = reinterpret_cast<GLfloat*>( storage + vec3_array_size);
+    GLfloat*  vert_tangent = reinterpret_cast<GLfloat*>( storage + vec3_array_size * 2);
+    GLfloat*  tex_coords   = reinterpret_cast<GLfloat*>( storage + vec3_array_size * 3);
+    GLushort* tri_indices  = reinterpret_cast<GLushort*>(storage + vec3_array_size * 3 + vec2_array_size);
+    if(m_storage) {
+        // NOTE: when growing in place arrays only move towards the end, so move back to front
+        memmove(tri_indices,  m_tri_indices,  sizeof(GLushort) * copy_num_tri    * 3);
+        memmove(tex_coords,   m_tex_coords,   sizeof(GLfloat)  * copy_num_vertex * 2);
+        memmove(vert_tangent, m_vert_tangent, sizeof(GLfloat)  * copy_num_vertex * 3);
+        memmove(vert_normal,  m_vert_normal,  sizeof(GLfloat)  * copy_num_vertex * 3);
+        memmove(vert_coords,  m_vert_coords,  sizeof(GLfloat)  * copy_num_vertex * 3);
+        if(!in_place) {
+            m_allocator->free(m_storage, m_storage_size);
+        }
+    }
+    m_allocator       = allocator;
+    m_storage         = storage;
+    m_storage_size    = storage_size;
+    m_vert_coords     = vert_coords;
+    m_vert_normal     = vert_normal;
+    m_vert_tangent    = vert_tangent;
+    m_tex_coords      = tex_coords;
+    m_tri_indices     = tri_indices;
+    m_vertex_capacity = vertex_capacity;
+    m_tri_capacity    = tri_capacity;
+}
+
+void Mesh::free_skin_data()
+{
+    if(m_bone_indices)     { delete[] m_bone_indices;   m_bone_indices = NULL; }
+    if(m_bone_weights)     { delete[] m_bone_weights;   m_bone_weights = NULL; }
+    if(m_vbo_bone_indices) { delete m_vbo_bone_indices; m_vbo_bone_indices = NULL; }
+    if(m_vbo_bone_weights) { delete m_vbo_bone_weights; m_vbo_bone_weights = NULL; }
+}
+
 void Mesh::update_transform()
 {
     m_transform = glm::translate(glm::mat4(1), m_origin) * get_local_rotation_transform() * glm::scale(glm::mat4(1), m_scale);
@@ -0,0 +1,284 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <MeshAllocator.h>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <stdlib.h>
+#include <stddef.h>
+
+namespace vt {
+
+static MeshAllocator* default_mesh_allocator = NULL;
+
+static size_t align_size(size_t size)
+{
+    return (size + MESH_ALLOC_ALIGNMENT - 1) & ~static_cast<size_t>(MESH_ALLOC_ALIGNMENT - 1);
+}
+
+static void* aligned_alloc_or_null(size_t size)
+{
+    void* ptr = NULL;
+    if(posix_memalign(&ptr, MESH_ALLOC_ALIGNMENT, std::max(size, static_cast<size_t>(MESH_ALLOC_ALIGNMENT)))) {
+        return NULL;
+    }
+    return ptr;
+}
+
+// smallest n such that size fits in (1 << n), or -1 if above largest size class
+static int get_size_class(size_t size)
+{
+    int n = MIN_POOL_SIZE_CLASS_LOG2;
+    while(n <= MAX_POOL_SIZE_CLASS_LOG2 && (static_cast<size_t>(1) << n) < size) {
+        n++;
+    }
+    return (n <= MAX_POOL_SIZE_CLASS_LOG2) ? n : -1;
+}
+
+//============================================================================
+// MeshAllocator
+//============================================================================
+
+MeshAllocator::MeshAllocator()
+    : m_bytes_in_use(0),
+      m_peak_bytes_in_use(0),
+      m_num_allocs(0)
+{
+}
+
+MeshAllocator* MeshAllocator::get_default()
+{
+    return default_mesh_allocator ? default_mesh_allocator : HeapMeshAllocator::instance();
+}
+
+void MeshAllocator::set_default(MeshAllocator* allocator)
+{
+    default_mesh_allocator = allocator;
+}
+
+// NOTE: caller holds m_mutex
+void MeshAllocator::record_alloc(size_t size)
+{
+    m_bytes_in_use += size;
+    m_peak_bytes_in_use = std::max(m_peak_bytes_in_use, m_bytes_in_use);
+    m_num_allocs++;
+}
+
+// NOTE: caller holds m_mutex
+void MeshAllocator::record_free(size_t size)
+{
+    m_bytes_in_use -= std::min(size, m_bytes_in_use);
+}
+
+// NOTE: caller holds m_mutex
+void MeshAllocator::record_resize(size_t size, size_t new_size)
+{
+    m_bytes_in_use = m_bytes_in_use - std::min(size, m_bytes_in_use) + new_size;
+    m_peak_bytes_in_use = std::max(m_peak_bytes_in_use, m_bytes_in_use);
+}
+
+//============================================================================
+// HeapMeshAllocator
+//============================================================================
+
+void* HeapMeshAllocator::alloc(size_t size)
+{
+    void* ptr = aligned_alloc_or_null(size);
+    if(ptr) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        record_alloc(size);
+    }
+    return ptr;
+}
+
+void HeapMeshAllocator::free(void* ptr, size_t size)
+{
+    if(!ptr) {
+        return;
+    }
+    ::free(ptr);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    record_free(size);
+}
+
+//============================================================================
+// ArenaMeshAllocator
+//============================================================================
+
+ArenaMeshAllocator::ArenaMeshAllocator(size_t block_size)
+    : m_block_size(align_size(block_size))
+{
+}
+
+ArenaMeshAllocator::~ArenaMeshAllocator()
+{
+    reset();
+}
+
+void* ArenaMeshAllocator::alloc(size_t size)
+{
+    size_t aligned_size = align_size(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_blocks.empty() || m_blocks.back().m_size - m_blocks.back().m_used < aligned_size) {
+        Block block;
+        block.m_size = std::max(m_block_size, aligned_size);
+        block.m_data = reinterpret_cast<char*>(aligned_alloc_or_null(block.m_size));
+        block.m_used = 0;
+        if(!block.m_data) {
+            return NULL;
+        }
+        m_blocks.push_back(block);
+    }
+    Block &block = m_blocks.back();
+    void* ptr = block.m_data + block.m_used;
+    block.m_used += aligned_size;
+    record_alloc(size);
+    return ptr;
+}
+
+void ArenaMeshAllocator::free(void* ptr, size_t size)
+{
+    if(!ptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(is_top(ptr, size)) {
+        m_blocks.back().m_used -= align_size(size);
+    }
+    record_free(size);
+}
+
+bool ArenaMeshAllocator::grow_in_place(void* ptr, size_t size, size_t new_size)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(!is_top(ptr, size)) {
+        return false;
+    }
+    Block &block = m_blocks.back();
+    size_t new_used = block.m_used - align_size(size) + align_size(new_size);
+    if(new_used > block.m_size) {
+        return false;
+    }
+    block.m_used = new_used;
+    record_resize(size, new_size);
+    return true;
+}
+
+void ArenaMeshAllocator::reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(std::vector<Block>::iterator p = m_blocks.begin(); p != m_blocks.end(); p++) {
+        ::free((*p).m_data);
+    }
+    m_blocks.clear();
+    m_bytes_in_use = 0;
+}
+
+size_t ArenaMeshAllocator::get_bytes_reserved() const
+{
+    size_t bytes_reserved = 0;
+    for(std::vector<Block>::const_iterator p = m_blocks.begin(); p != m_blocks.end(); p++) {
+        bytes_reserved += (*p).m_size;
+    }
+    return bytes_reserved;
+}
+
+// NOTE: caller holds m_mutex
+bool ArenaMeshAllocator::is_top(void* ptr, size_t size) const
+{
+    if(m_blocks.empty()) {
+        return false;
+    }
+    const Block &block = m_blocks.back();
+    return block.m_used >= align_size(size) && ptr == block.m_data + block.m_used - align_size(size);
+}
+
+//============================================================================
+// PoolMeshAllocator
+//============================================================================
+
+PoolMeshAllocator::~PoolMeshAllocator()
+{
+    trim();
+}
+
+void* PoolMeshAllocator::alloc(size_t size)
+{
+    int size_class = get_size_class(size);
+    if(size_class == -1) {
+        void* ptr = aligned_alloc_or_null(size);
+        if(ptr) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            record_alloc(size);
+        }
+        return ptr;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::vector<void*> &free_list = m_free_lists[size_class - MIN_POOL_SIZE_CLASS_LOG2];
+    void* ptr = NULL;
+    if(free_list.empty()) {
+        ptr = aligned_alloc_or_null(static_cast<size_t>(1) << size_class);
+    } else {
+        ptr = free_list.back();
+        free_list.pop_back();
+    }
+    if(ptr) {
+        record_alloc(size);
+    }
+    return ptr;
+}
+
+void PoolMeshAllocator::free(void* ptr, size_t size)
+{
+    if(!ptr) {
+        return;
+    }
+    int size_class = get_size_class(size);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(size_class == -1) {
+        ::free(ptr);
+    } else {
+        m_free_lists[size_class - MIN_POOL_SIZE_CLASS_LOG2].push_back(ptr);
+    }
+    record_free(size);
+}
+
+// blocks are allocated at full size-class size, so growing within the class is free
+bool PoolMeshAllocator::grow_in_place(void* ptr, size_t size, size_t new_size)
+{
+    int size_class = get_size_class(size);
+    if(size_class == -1 || get_size_class(new_size) != size_class) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    record_resize(size, new_size);
+    return true;
+}
+
+void PoolMeshAllocator::trim()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for(int i = 0; i <= MAX_POOL_SIZE_CLASS_LOG2 - MIN_POOL_SIZE_CLASS_LOG2; i++) {
+        for(std::vector<void*>::iterator p = m_free_lists[i].begin(); p != m_free_lists[i].end(); p++) {
+            ::free(*p);
+        }
+        m_free_lists[i].clear();
+    }
+}
+
+}
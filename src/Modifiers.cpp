@@ -20,7 +20,22 @@
 #include <Scene.h>
 #include <Util.h>
 #include <glm/glm.hpp>
-#include <map>
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <iostream>
+#include <unordered_map>
+#include <queue>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#define PARALLEL_TESSELLATION_MIN_ITEMS 4096
+#define MAX_TESSELLATION_THREADS        8
+#define MAX_TESSELLATION_VERTEX         65536 // tri indices are 16-bit
+#define MAX_TESSELLATION_TRI            (1 << 22)
+#define VERTEX_CACHE_SIZE               32
+#define SIMPLIFY_MIN_TRI                4
 
 namespace vt {
 
@@ -37,14 +52,14 @@ void mesh_attach(Scene* scene, MeshBase* mesh1, MeshBase* mesh2)
 
 void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float wavelength, float phase, bool smooth)
 {
-    size_t num_vertex = mesh->get_num_vertex();
+    size_t     num_vertex  = mesh->get_num_vertex();
+    glm::vec3* vert_coords = mesh->get_vert_coords();
+    float      wavenumber  = (PI * 2) / wavelength;
     for(int i = 0; i < static_cast<int>(num_vertex); i++) {
-        glm::vec3 pos = mesh->get_vert_coord(i);
-        glm::vec2 p1(origin.x, origin.z);
-        glm::vec2 p2(pos.x, pos.z);
-        float radius = glm::distance(p1, p2);
-        pos.y = origin.y + static_cast<float>(sin(radius / (wavelength / (PI * 2)) + phase)) * amplitude;
-        mesh->set_vert_coord(i, pos);
+        float dx     = vert_coords[i].x - origin.x;
+        float dz     = vert_coords[i].z - origin.z;
+        float radius = sqrt(dx * dx + dz * dz);
+        vert_coords[i].y = origin.y + static_cast<float>(sin(radius * wavenumber + phase)) * amplitude;
     }
     if(smooth) {
         mesh->set_smooth(true);
@@ -53,140 +68,797 @@ void mesh_apply_ripple(MeshBase* mesh, glm::vec3 origin, float amplitude, float
     mesh->update_bbox();
 }
 
-void mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth)
+//============================================================================
+// tessellation
+//============================================================================
+
+// per-level working set (pooled, ping-ponged between levels so no level touches the mesh)
+struct TessellationBuffers
 {
-    size_t prev_num_vert = mesh->get_num_vertex();
-    size_t prev_num_tri  = mesh->get_num_tri();
-    switch(tessellation_type) {
-        case TESSELLATION_TYPE_EDGE_CENTER:
-            {
-                size_t new_num_vertex = prev_num_vert + prev_num_tri * 3;
-                size_t new_num_tri    = prev_num_tri * 4;
-                glm::vec3  new_vert_coord[new_num_vertex];
-                glm::vec2  new_tex_coord[new_num_vertex];
-                glm::ivec3 new_tri_indices[new_num_tri];
-                for(int i = 0; i < static_cast<int>(prev_num_vert); i++) {
-                    new_vert_coord[i] = mesh->get_vert_coord(i);
-                    new_tex_coord[i]  = mesh->get_tex_coord(i);
-                }
+    std::vector<glm::vec3>  m_vert_coords;
+    std::vector<glm::vec2>  m_tex_coords;
+    std::vector<glm::ivec3> m_tri_indices;
+};
 
-                int current_vert_index = prev_num_vert;
-                int current_face_index = 0;
-                std::map<uint32_t, int> shared_vert_map;
-                for(int j = 0; j < static_cast<int>(prev_num_tri); j++) {
-                    glm::ivec3 tri_indices = mesh->get_tri_indices(j);
-                    glm::vec3 vert_a_coord = mesh->get_vert_coord(tri_indices[0]);
-                    glm::vec3 vert_b_coord = mesh->get_vert_coord(tri_indices[1]);
-                    glm::vec3 vert_c_coord = mesh->get_vert_coord(tri_indices[2]);
-                    glm::vec2 tex_a_coord  = mesh->get_tex_coord(tri_indices[0]);
-                    glm::vec2 tex_b_coord  = mesh->get_tex_coord(tri_indices[1]);
-                    glm::vec2 tex_c_coord  = mesh->get_tex_coord(tri_indices[2]);
-
-                    uint32_t new_vert_shared_ab_key = MAKELONG(std::min(tri_indices[0], tri_indices[1]), std::max(tri_indices[0], tri_indices[1]));
-                    int new_vert_shared_ab_index = 0;
-                    std::map<uint32_t, int>::iterator p = shared_vert_map.find(new_vert_shared_ab_key);
-                    if(p == shared_vert_map.end()) {
-                        new_vert_shared_ab_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_ab_key, new_vert_shared_ab_index));
-                    } else {
-                        new_vert_shared_ab_index = (*p).second;
-                    }
-                    new_vert_coord[new_vert_shared_ab_index] = (vert_a_coord + vert_b_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_ab_index]  = (tex_a_coord + tex_b_coord) * 0.5f;
-
-                    uint32_t new_vert_shared_bc_key = MAKELONG(std::min(tri_indices[1], tri_indices[2]), std::max(tri_indices[1], tri_indices[2]));
-                    int new_vert_shared_bc_index = 0;
-                    std::map<uint32_t, int>::iterator q = shared_vert_map.find(new_vert_shared_bc_key);
-                    if(q == shared_vert_map.end()) {
-                        new_vert_shared_bc_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_bc_key, new_vert_shared_bc_index));
-                    } else {
-                        new_vert_shared_bc_index = (*q).second;
-                    }
-                    new_vert_coord[new_vert_shared_bc_index] = (vert_b_coord + vert_c_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_bc_index]  = (tex_b_coord + tex_c_coord) * 0.5f;
-
-                    uint32_t new_vert_shared_ca_key = MAKELONG(std::min(tri_indices[2], tri_indices[0]), std::max(tri_indices[2], tri_indices[0]));
-                    int new_vert_shared_ca_index = 0;
-                    std::map<uint32_t, int>::iterator r = shared_vert_map.find(new_vert_shared_ca_key);
-                    if(r == shared_vert_map.end()) {
-                        new_vert_shared_ca_index = current_vert_index++;
-                        shared_vert_map.insert(std::pair<uint32_t, int>(new_vert_shared_ca_key, new_vert_shared_ca_index));
-                    } else {
-                        new_vert_shared_ca_index = (*r).second;
-                    }
-                    new_vert_coord[new_vert_shared_ca_index] = (vert_c_coord + vert_a_coord) * 0.5f;
-                    new_tex_coord[new_vert_shared_ca_index]  = (tex_c_coord + tex_a_coord) * 0.5f;
+static const uint64_t EMPTY_EDGE_KEY = ~0ULL;
 
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[0], new_vert_shared_ab_index, new_vert_shared_ca_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[1], new_vert_shared_bc_index, new_vert_shared_ab_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[2], new_vert_shared_ca_index, new_vert_shared_bc_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(new_vert_shared_ab_index, new_vert_shared_bc_index, new_vert_shared_ca_index);
-                }
+// open-addressed (linear probing) undirected edge table
+class EdgeTable
+{
+public:
+    void reset(size_t max_edges)
+    {
+        size_t capacity = 16;
+        while(capacity < max_edges * 2) {
+            capacity <<= 1;
+        }
+        m_keys.assign(capacity, EMPTY_EDGE_KEY);
+        m_values.resize(capacity);
+        m_mask = capacity - 1;
+    }
+    int find_or_insert(int a, int b, int new_value, bool* inserted)
+    {
+        uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | static_cast<uint32_t>(std::max(a, b));
+        size_t   pos = static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & m_mask;
+        while(m_keys[pos] != EMPTY_EDGE_KEY) {
+            if(m_keys[pos] == key) {
+                *inserted = false;
+                return m_values[pos];
+            }
+            pos = (pos + 1) & m_mask;
+        }
+        m_keys[pos]   = key;
+        m_values[pos] = new_value;
+        *inserted = true;
+        return new_value;
+    }
 
-                new_num_vertex = current_vert_index;
-                new_num_tri    = current_face_index;
-                mesh->resize(new_num_vertex, new_num_tri);
-                for(int k = 0; k < static_cast<int>(new_num_vertex); k++) {
-                    mesh->set_vert_coord(k, new_vert_coord[k]);
-                    mesh->set_tex_coord(k,  new_tex_coord[k]);
-                }
-                for(int t = 0; t < static_cast<int>(new_num_tri); t++) {
-                    mesh->set_tri_indices(t, new_tri_indices[t]);
-                }
+private:
+    std::vector<uint64_t> m_keys;
+    std::vector<int>      m_values;
+    size_t                m_mask;
+};
+
+// runs f(begin, end) over [0, count) split across threads
+template<class F>
+static void parallel_for(int count, F f)
+{
+    int num_threads = 1;
+    if(count >= PARALLEL_TESSELLATION_MIN_ITEMS) {
+        num_threads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), MAX_TESSELLATION_THREADS));
+    }
+    int per_thread = (count + num_threads - 1) / num_threads;
+    std::vector<std::thread> threads;
+    for(int t = 1; t < num_threads; t++) {
+        int begin = std::min(t * per_thread, count);
+        int end   = std::min(begin + per_thread, count);
+        threads.push_back(std::thread(f, begin, end));
+    }
+    f(0, std::min(per_thread, count));
+    for(int t = 0; t < static_cast<int>(threads.size()); t++) {
+        threads[t].join();
+    }
+}
+
+static void tessellate_tri_center(const TessellationBuffers &src, TessellationBuffers* dst)
+{
+    int prev_num_vert = src.m_vert_coords.size();
+    int prev_num_tri  = src.m_tri_indices.size();
+    dst->m_vert_coords.resize(prev_num_vert + prev_num_tri);
+    dst->m_tex_coords.resize( prev_num_vert + prev_num_tri);
+    dst->m_tri_indices.resize(prev_num_tri * 3);
+    std::copy(src.m_vert_coords.begin(), src.m_vert_coords.end(), dst->m_vert_coords.begin());
+    std::copy(src.m_tex_coords.begin(),  src.m_tex_coords.end(),  dst->m_tex_coords.begin());
+    parallel_for(prev_num_tri, [&](int begin, int end) {
+        for(int j = begin; j < end; j++) {
+            glm::ivec3 tri_indices    = src.m_tri_indices[j];
+            int        new_vert_index = prev_num_vert + j;
+            dst->m_vert_coords[new_vert_index] = (src.m_vert_coords[tri_indices[0]] +
+                                                  src.m_vert_coords[tri_indices[1]] +
+                                                  src.m_vert_coords[tri_indices[2]]) * (1.0f / 3);
+            dst->m_tex_coords[new_vert_index]  = (src.m_tex_coords[tri_indices[0]] +
+                                                  src.m_tex_coords[tri_indices[1]] +
+                                                  src.m_tex_coords[tri_indices[2]]) * (1.0f / 3);
+            dst->m_tri_indices[j * 3 + 0] = glm::ivec3(tri_indices[0], tri_indices[1], new_vert_index);
+            dst->m_tri_indices[j * 3 + 1] = glm::ivec3(tri_indices[1], tri_indices[2], new_vert_index);
+            dst->m_tri_indices[j * 3 + 2] = glm::ivec3(tri_indices[2], tri_indices[0], new_vert_index);
+        }
+    });
+}
+
+// NOTE: loop subdivision works on index topology, so unwelded seams are treated as boundaries
+static void tessellate_edge_center(const TessellationBuffers &src, TessellationBuffers* dst, EdgeTable* edge_table, bool loop)
+{
+    int prev_num_vert = src.m_vert_coords.size();
+    int prev_num_tri  = src.m_tri_indices.size();
+
+    // edge adjacency (sequential, since edge numbering must be deterministic)
+    std::vector<glm::ivec4> edges; // (a, b, opposite vert 0, opposite vert 1)
+    std::vector<int>        tri_edges(prev_num_tri * 3);
+    edges.reserve(prev_num_tri * 3 / 2 + 1);
+    edge_table->reset(prev_num_tri * 3);
+    for(int j = 0; j < prev_num_tri; j++) {
+        glm::ivec3 tri_indices = src.m_tri_indices[j];
+        for(int k = 0; k < 3; k++) {
+            int  a        = tri_indices[k];
+            int  b        = tri_indices[(k + 1) % 3];
+            int  c        = tri_indices[(k + 2) % 3];
+            bool inserted = false;
+            int  edge_index = edge_table->find_or_insert(a, b, edges.size(), &inserted);
+            if(inserted) {
+                edges.push_back(glm::ivec4(a, b, c, -1));
+            } else {
+                edges[edge_index][3] = c;
             }
-            break;
-        case TESSELLATION_TYPE_TRI_CENTER:
-            {
-                size_t new_num_vertex = prev_num_vert + prev_num_tri;
-                size_t new_num_tri    = prev_num_tri * 3;
-                glm::vec3  new_vert_coord[new_num_vertex];
-                glm::vec2  new_tex_coord[new_num_vertex];
-                glm::ivec3 new_tri_indices[new_num_tri];
-                for(int i = 0; i < static_cast<int>(prev_num_vert); i++) {
-                    new_vert_coord[i] = mesh->get_vert_coord(i);
-                    new_tex_coord[i]  = mesh->get_tex_coord(i);
-                }
+            tri_edges[j * 3 + k] = edge_index;
+        }
+    }
+    int num_edges = edges.size();
 
-                int current_vert_index = prev_num_vert;
-                int current_face_index = 0;
-                std::map<uint32_t, int> shared_vert_map;
-                for(int j = 0; j < static_cast<int>(prev_num_tri); j++) {
-                    glm::ivec3 tri_indices = mesh->get_tri_indices(j);
-                    glm::vec3 vert_a_coord = mesh->get_vert_coord(tri_indices[0]);
-                    glm::vec3 vert_b_coord = mesh->get_vert_coord(tri_indices[1]);
-                    glm::vec3 vert_c_coord = mesh->get_vert_coord(tri_indices[2]);
-                    glm::vec2 tex_a_coord  = mesh->get_tex_coord(tri_indices[0]);
-                    glm::vec2 tex_b_coord  = mesh->get_tex_coord(tri_indices[1]);
-                    glm::vec2 tex_c_coord  = mesh->get_tex_coord(tri_indices[2]);
-
-                    int new_vert_index = current_vert_index;
-                    new_vert_coord[new_vert_index] = (vert_a_coord + vert_b_coord + vert_c_coord) * (1.0f / 3);
-                    new_tex_coord[new_vert_index]  = (tex_a_coord + tex_b_coord + tex_c_coord) * (1.0f / 3);
-                    current_vert_index++;
-
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[0], tri_indices[1], new_vert_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[1], tri_indices[2], new_vert_index);
-                    new_tri_indices[current_face_index++] = glm::ivec3(tri_indices[2], tri_indices[0], new_vert_index);
-                }
+    dst->m_vert_coords.resize(prev_num_vert + num_edges);
+    dst->m_tex_coords.resize( prev_num_vert + num_edges);
+    dst->m_tri_indices.resize(prev_num_tri * 4);
+    std::copy(src.m_tex_coords.begin(), src.m_tex_coords.end(), dst->m_tex_coords.begin());
 
-                new_num_vertex = current_vert_index;
-                new_num_tri    = current_face_index;
-                mesh->resize(new_num_vertex, new_num_tri);
-                for(int k = 0; k < static_cast<int>(new_num_vertex); k++) {
-                    mesh->set_vert_coord(k, new_vert_coord[k]);
-                    mesh->set_tex_coord(k,  new_tex_coord[k]);
+    // even (original) vertices
+    if(loop) {
+        std::vector<glm::vec3> neighbor_sum(prev_num_vert, glm::vec3(0));
+        std::vector<glm::vec3> boundary_sum(prev_num_vert, glm::vec3(0));
+        std::vector<int>       valence(prev_num_vert, 0);
+        std::vector<int>       boundary_count(prev_num_vert, 0);
+        for(int e = 0; e < num_edges; e++) {
+            int a = edges[e][0];
+            int b = edges[e][1];
+            neighbor_sum[a] += src.m_vert_coords[b];
+            neighbor_sum[b] += src.m_vert_coords[a];
+            valence[a]++;
+            valence[b]++;
+            if(edges[e][3] == -1) {
+                boundary_sum[a] += src.m_vert_coords[b];
+                boundary_sum[b] += src.m_vert_coords[a];
+                boundary_count[a]++;
+                boundary_count[b]++;
+            }
+        }
+        parallel_for(prev_num_vert, [&](int begin, int end) {
+            for(int i = begin; i < end; i++) {
+                const glm::vec3 &v = src.m_vert_coords[i];
+                if(boundary_count[i]) {
+                    dst->m_vert_coords[i] = (boundary_count[i] == 2) ? v * 0.75f + boundary_sum[i] * 0.125f : v;
+                    continue;
                 }
-                for(int t = 0; t < static_cast<int>(new_num_tri); t++) {
-                    mesh->set_tri_indices(t, new_tri_indices[t]);
+                int n = valence[i];
+                if(!n) {
+                    dst->m_vert_coords[i] = v;
+                    continue;
                 }
+                float beta = (n == 3) ? 3.0f / 16 : 3.0f / (8 * n);
+                dst->m_vert_coords[i] = v * (1 - n * beta) + neighbor_sum[i] * beta;
             }
-            break;
+        });
+    } else {
+        std::copy(src.m_vert_coords.begin(), src.m_vert_coords.end(), dst->m_vert_coords.begin());
+    }
+
+    // odd (edge) vertices
+    parallel_for(num_edges, [&](int begin, int end) {
+        for(int e = begin; e < end; e++) {
+            const glm::ivec4 &edge = edges[e];
+            const glm::vec3  &pa   = src.m_vert_coords[edge[0]];
+            const glm::vec3  &pb   = src.m_vert_coords[edge[1]];
+            int new_vert_index = prev_num_vert + e;
+            if(loop && edge[3] != -1) {
+                dst->m_vert_coords[new_vert_index] = (pa + pb) * 0.375f + (src.m_vert_coords[edge[2]] + src.m_vert_coords[edge[3]]) * 0.125f;
+            } else {
+                dst->m_vert_coords[new_vert_index] = (pa + pb) * 0.5f;
+            }
+            dst->m_tex_coords[new_vert_index] = (src.m_tex_coords[edge[0]] + src.m_tex_coords[edge[1]]) * 0.5f;
+        }
+    });
+
+    // faces
+    parallel_for(prev_num_tri, [&](int begin, int end) {
+        for(int j = begin; j < end; j++) {
+            glm::ivec3 tri_indices = src.m_tri_indices[j];
+            int new_vert_shared_ab_index = prev_num_vert + tri_edges[j * 3 + 0];
+            int new_vert_shared_bc_index = prev_num_vert + tri_edges[j * 3 + 1];
+            int new_vert_shared_ca_index = prev_num_vert + tri_edges[j * 3 + 2];
+            dst->m_tri_indices[j * 4 + 0] = glm::ivec3(tri_indices[0], new_vert_shared_ab_index, new_vert_shared_ca_index);
+            dst->m_tri_indices[j * 4 + 1] = glm::ivec3(tri_indices[1], new_vert_shared_bc_index, new_vert_shared_ab_index);
+            dst->m_tri_indices[j * 4 + 2] = glm::ivec3(tri_indices[2], new_vert_shared_ca_index, new_vert_shared_bc_index);
+            dst->m_tri_indices[j * 4 + 3] = glm::ivec3(new_vert_shared_ab_index, new_vert_shared_bc_index, new_vert_shared_ca_index);
+        }
+    });
+}
+
+bool mesh_tessellate(MeshBase* mesh, tessellation_type_t tessellation_type, bool smooth, int levels, float sphere_radius)
+{
+    size_t prev_num_vert = mesh->get_num_vertex();
+    size_t prev_num_tri  = mesh->get_num_tri();
+
+    // bound memory up front (vertex count is checked per level, since edge count depends on topology)
+    size_t new_num_tri = prev_num_tri;
+    for(int level = 0; level < levels; level++) {
+        new_num_tri *= (tessellation_type == TESSELLATION_TYPE_TRI_CENTER) ? 3 : 4;
+    }
+    if(new_num_tri > MAX_TESSELLATION_TRI) {
+        std::cout << "mesh_tessellate: too many triangles (" << new_num_tri << ")" << std::endl;
+        return false;
+    }
+
+    TessellationBuffers buffers[2];
+    TessellationBuffers* src = &buffers[0];
+    TessellationBuffers* dst = &buffers[1];
+    src->m_vert_coords.assign(mesh->get_vert_coords(), mesh->get_vert_coords() + prev_num_vert);
+    src->m_tex_coords.assign( mesh->get_tex_coords(),  mesh->get_tex_coords()  + prev_num_vert);
+    src->m_tri_indices.resize(prev_num_tri);
+    const uint16_t* tri_index = mesh->get_tri_indices();
+    for(int j = 0; j < static_cast<int>(prev_num_tri); j++) {
+        src->m_tri_indices[j] = glm::ivec3(tri_index[j * 3 + 0], tri_index[j * 3 + 1], tri_index[j * 3 + 2]);
+    }
+
+    EdgeTable edge_table;
+    for(int level = 0; level < levels; level++) {
+        switch(tessellation_type) {
+            case TESSELLATION_TYPE_EDGE_CENTER:
+                tessellate_edge_center(*src, dst, &edge_table, false);
+                break;
+            case TESSELLATION_TYPE_TRI_CENTER:
+                tessellate_tri_center(*src, dst);
+                break;
+            case TESSELLATION_TYPE_LOOP:
+                tessellate_edge_center(*src, dst, &edge_table, true);
+                break;
+        }
+        if(dst->m_vert_coords.size() > MAX_TESSELLATION_VERTEX) {
+            std::cout << "mesh_tessellate: too many vertices (" << dst->m_vert_coords.size() << ")" << std::endl;
+            return false;
+        }
+        if(sphere_radius > 0) {
+            std::vector<glm::vec3> &vert_coords = dst->m_vert_coords;
+            parallel_for(vert_coords.size(), [&](int begin, int end) {
+                for(int i = begin; i < end; i++) {
+                    vert_coords[i] = safe_normalize(vert_coords[i]) * sphere_radius;
+                }
+            });
+        }
+        std::swap(src, dst);
+    }
+
+    size_t new_num_vertex = src->m_vert_coords.size();
+    new_num_tri = src->m_tri_indices.size();
+    mesh->resize(new_num_vertex, new_num_tri);
+    memcpy(mesh->get_vert_coords(), &src->m_vert_coords[0], sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_tex_coords(),  &src->m_tex_coords[0],  sizeof(glm::vec2) * new_num_vertex);
+    uint16_t* new_tri_index = mesh->get_tri_indices();
+    for(int t = 0; t < static_cast<int>(new_num_tri); t++) {
+        new_tri_index[t * 3 + 0] = src->m_tri_indices[t][0];
+        new_tri_index[t * 3 + 1] = src->m_tri_indices[t][1];
+        new_tri_index[t * 3 + 2] = src->m_tri_indices[t][2];
     }
     if(smooth) {
         mesh->set_smooth(true);
     }
     mesh->update_normals_and_tangents();
+    mesh->update_bbox();
+    return true;
+}
+
+//============================================================================
+// vertex cache / fetch optimization
+//============================================================================
+
+// fifo post-transform cache simulation (average cache misses per triangle)
+float mesh_calc_acmr(const MeshBase* mesh, int cache_size)
+{
+    int num_tri = mesh->get_num_tri();
+    if(!num_tri) {
+        return 0;
+    }
+    const uint16_t*  tri_indices = mesh->get_tri_indices();
+    std::vector<int> cache_time(mesh->get_num_vertex(), -1);
+    int misses = 0;
+    for(int i = 0; i < num_tri * 3; i++) {
+        int vert_index = tri_indices[i];
+        if(cache_time[vert_index] == -1 || misses - cache_time[vert_index] >= cache_size) {
+            cache_time[vert_index] = misses++;
+        }
+    }
+    return static_cast<float>(misses) / num_tri;
+}
+
+static float calc_forsyth_vertex_score(int cache_pos, int remaining_valence)
+{
+    if(!remaining_valence) {
+        return -1;
+    }
+    float score = 0;
+    if(cache_pos >= 0) {
+        // last triangle's vertices get a fixed score so they aren't reused right away
+        score = (cache_pos < 3) ? 0.75f : pow(1 - static_cast<float>(cache_pos - 3) / (VERTEX_CACHE_SIZE - 3), 1.5f);
+    }
+    return score + 2 * pow(static_cast<float>(remaining_valence), -0.5f); // favor finishing off low-valence vertices
+}
+
+// tom forsyth's linear-speed vertex cache optimization
+void mesh_optimize_vertex_cache(MeshBase* mesh)
+{
+    int       num_vertex  = mesh->get_num_vertex();
+    int       num_tri     = mesh->get_num_tri();
+    uint16_t* tri_indices = mesh->get_tri_indices();
+    if(!num_tri) {
+        return;
+    }
+
+    // vertex to triangle adjacency
+    std::vector<int> vert_tri_offset(num_vertex + 1, 0);
+    for(int i = 0; i < num_tri * 3; i++) {
+        vert_tri_offset[tri_indices[i] + 1]++;
+    }
+    for(int v = 0; v < num_vertex; v++) {
+        vert_tri_offset[v + 1] += vert_tri_offset[v];
+    }
+    std::vector<int> vert_tris(num_tri * 3);
+    std::vector<int> remaining_valence(num_vertex, 0);
+    for(int i = 0; i < num_tri * 3; i++) {
+        int vert_index = tri_indices[i];
+        vert_tris[vert_tri_offset[vert_index] + remaining_valence[vert_index]++] = i / 3;
+    }
+
+    std::vector<float> vert_score(num_vertex);
+    std::vector<bool>  tri_added(num_tri, false);
+    for(int v = 0; v < num_vertex; v++) {
+        vert_score[v] = calc_forsyth_vertex_score(-1, remaining_valence[v]);
+    }
+
+    std::vector<uint16_t> new_tri_indices(num_tri * 3);
+    std::vector<int>      cache;
+    std::vector<int>      new_cache;
+    cache.reserve(VERTEX_CACHE_SIZE + 3);
+    new_cache.reserve(VERTEX_CACHE_SIZE + 3);
+    int best_tri      = -1;
+    int scan_position = 0;
+    for(int n = 0; n < num_tri; n++) {
+        if(best_tri == -1) {
+            // nothing adjacent to the cache, fall back to next remaining triangle (keeps it linear)
+            while(tri_added[scan_position]) {
+                scan_position++;
+            }
+            best_tri = scan_position;
+        }
+        tri_added[best_tri] = true;
+        new_cache.clear();
+        for(int k = 0; k < 3; k++) {
+            int vert_index = tri_indices[best_tri * 3 + k];
+            new_tri_indices[n * 3 + k] = vert_index;
+            new_cache.push_back(vert_index);
+
+            // remove emitted triangle from vertex's remaining list
+            int* begin = &vert_tris[vert_tri_offset[vert_index]];
+            int* end   = begin + remaining_valence[vert_index];
+            std::swap(*std::find(begin, end, best_tri), *(end - 1));
+            remaining_valence[vert_index]--;
+        }
+        for(int c = 0; c < static_cast<int>(cache.size()); c++) {
+            int vert_index = cache[c];
+            if(std::find(new_cache.begin(), new_cache.end(), vert_index) == new_cache.end()) {
+                new_cache.push_back(vert_index);
+            }
+        }
+        for(int c = VERTEX_CACHE_SIZE; c < static_cast<int>(new_cache.size()); c++) {
+            vert_score[new_cache[c]] = calc_forsyth_vertex_score(-1, remaining_valence[new_cache[c]]); // evicted
+        }
+        if(static_cast<int>(new_cache.size()) > VERTEX_CACHE_SIZE) {
+            new_cache.resize(VERTEX_CACHE_SIZE);
+        }
+        cache.swap(new_cache);
+        for(int c = 0; c < static_cast<int>(cache.size()); c++) {
+            vert_score[cache[c]] = calc_forsyth_vertex_score(c, remaining_valence[cache[c]]);
+        }
+
+        // rescore triangles touching the cache and pick the next one from them
+        best_tri = -1;
+        float best_score = -1;
+        for(int c = 0; c < static_cast<int>(cache.size()); c++) {
+            int vert_index = cache[c];
+            for(int j = 0; j < remaining_valence[vert_index]; j++) {
+                int t = vert_tris[vert_tri_offset[vert_index] + j];
+                float tri_score = vert_score[tri_indices[t * 3 + 0]] + vert_score[tri_indices[t * 3 + 1]] + vert_score[tri_indices[t * 3 + 2]];
+                if(tri_score > best_score) {
+                    best_score = tri_score;
+                    best_tri   = t;
+                }
+            }
+        }
+    }
+    memcpy(tri_indices, &new_tri_indices[0], sizeof(uint16_t) * num_tri * 3);
+}
+
+// NOTE: reorders all vertex attributes, so call before binding skin weights
+void mesh_optimize_vertex_fetch(MeshBase* mesh)
+{
+    int       num_vertex  = mesh->get_num_vertex();
+    int       num_tri     = mesh->get_num_tri();
+    uint16_t* tri_indices = mesh->get_tri_indices();
+    std::vector<int> remap(num_vertex, -1);
+    int next_vert_index = 0;
+    for(int i = 0; i < num_tri * 3; i++) {
+        int &new_vert_index = remap[tri_indices[i]];
+        if(new_vert_index == -1) {
+            new_vert_index = next_vert_index++;
+        }
+        tri_indices[i] = new_vert_index;
+    }
+    for(int v = 0; v < num_vertex; v++) {
+        if(remap[v] == -1) {
+            remap[v] = next_vert_index++; // keep unreferenced vertices at the end
+        }
+    }
+    std::vector<glm::vec3> vert_coords(  mesh->get_vert_coords(),   mesh->get_vert_coords()   + num_vertex);
+    std::vector<glm::vec3> vert_normals( mesh->get_vert_normals(),  mesh->get_vert_normals()  + num_vertex);
+    std::vector<glm::vec3> vert_tangents(mesh->get_vert_tangents(), mesh->get_vert_tangents() + num_vertex);
+    std::vector<glm::vec2> tex_coords(   mesh->get_tex_coords(),    mesh->get_tex_coords()    + num_vertex);
+    for(int v = 0; v < num_vertex; v++) {
+        mesh->get_vert_coords()[remap[v]]   = vert_coords[v];
+        mesh->get_vert_normals()[remap[v]]  = vert_normals[v];
+        mesh->get_vert_tangents()[remap[v]] = vert_tangents[v];
+        mesh->get_tex_coords()[remap[v]]    = tex_coords[v];
+    }
+}
+
+static bool is_same_vertex(const MeshBase* mesh, int a, int b, float epsilon)
+{
+    glm::vec3 d_coord   = glm::abs(mesh->get_vert_coords()[a]  - mesh->get_vert_coords()[b]);
+    glm::vec3 d_normal  = glm::abs(mesh->get_vert_normals()[a] - mesh->get_vert_normals()[b]);
+    glm::vec2 d_texcoord = glm::abs(mesh->get_tex_coords()[a]  - mesh->get_tex_coords()[b]);
+    return std::max(std::max(d_coord.x,  d_coord.y),  d_coord.z)  <= epsilon &&
+           std::max(std::max(d_normal.x, d_normal.y), d_normal.z) <= epsilon &&
+           std::max(d_texcoord.x, d_texcoord.y)                   <= epsilon;
+}
+
+static uint64_t make_cell_key(glm::ivec3 cell)
+{
+    return ((static_cast<uint64_t>(cell.x) & 0x1FFFFF) << 42) |
+           ((static_cast<uint64_t>(cell.y) & 0x1FFFFF) << 21) |
+            (static_cast<uint64_t>(cell.z) & 0x1FFFFF);
+}
+
+// merges vertices whose position, normal and uv all match (seams and hard edges are kept)
+int mesh_weld_vertices(MeshBase* mesh, float epsilon)
+{
+    int num_vertex = mesh->get_num_vertex();
+    int num_tri    = mesh->get_num_tri();
+    const glm::vec3* vert_coords = mesh->get_vert_coords();
+
+    // spatial hash (chained through next_in_cell) of representative vertices
+    std::unordered_map<uint64_t, int> cell_head;
+    std::vector<int> next_in_cell(num_vertex, -1);
+    std::vector<int> remap(num_vertex, -1);
+    std::vector<int> kept_verts;
+    float cell_size = std::max(epsilon, EPSILON) * 2;
+    for(int v = 0; v < num_vertex; v++) {
+        glm::ivec3 cell = glm::ivec3(glm::floor(vert_coords[v] / cell_size));
+        for(int dx = -1; dx <= 1 && remap[v] == -1; dx++) {
+            for(int dy = -1; dy <= 1 && remap[v] == -1; dy++) {
+                for(int dz = -1; dz <= 1 && remap[v] == -1; dz++) {
+                    std::unordered_map<uint64_t, int>::iterator p = cell_head.find(make_cell_key(cell + glm::ivec3(dx, dy, dz)));
+                    for(int u = (p == cell_head.end()) ? -1 : (*p).second; u != -1; u = next_in_cell[u]) {
+                        if(is_same_vertex(mesh, u, v, epsilon)) {
+                            remap[v] = remap[u];
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+        if(remap[v] != -1) {
+            continue;
+        }
+        remap[v] = kept_verts.size();
+        kept_verts.push_back(v);
+        uint64_t key = make_cell_key(cell);
+        std::unordered_map<uint64_t, int>::iterator q = cell_head.find(key);
+        next_in_cell[v] = (q == cell_head.end()) ? -1 : (*q).second;
+        cell_head[key] = v;
+    }
+    int num_welded = num_vertex - kept_verts.size();
+    if(!num_welded) {
+        return 0;
+    }
+
+    int new_num_vertex = kept_verts.size();
+    std::vector<glm::vec3> new_vert_coords(new_num_vertex);
+    std::vector<glm::vec3> new_vert_normals(new_num_vertex);
+    std::vector<glm::vec3> new_vert_tangents(new_num_vertex);
+    std::vector<glm::vec2> new_tex_coords(new_num_vertex);
+    std::vector<uint16_t>  new_tri_indices(num_tri * 3);
+    for(int k = 0; k < new_num_vertex; k++) {
+        new_vert_coords[k]   = mesh->get_vert_coords()[kept_verts[k]];
+        new_vert_normals[k]  = mesh->get_vert_normals()[kept_verts[k]];
+        new_vert_tangents[k] = mesh->get_vert_tangents()[kept_verts[k]];
+        new_tex_coords[k]    = mesh->get_tex_coords()[kept_verts[k]];
+    }
+    for(int i = 0; i < num_tri * 3; i++) {
+        new_tri_indices[i] = remap[mesh->get_tri_indices()[i]];
+    }
+    mesh->resize(new_num_vertex, num_tri);
+    memcpy(mesh->get_vert_coords(),   &new_vert_coords[0],   sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_vert_normals(),  &new_vert_normals[0],  sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_vert_tangents(), &new_vert_tangents[0], sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_tex_coords(),    &new_tex_coords[0],    sizeof(glm::vec2) * new_num_vertex);
+    memcpy(mesh->get_tri_indices(),   &new_tri_indices[0],   sizeof(uint16_t)  * num_tri * 3);
+    return num_welded;
+}
+
+void mesh_optimize(MeshBase* mesh, bool weld, float* acmr_before, float* acmr_after)
+{
+    if(acmr_before) {
+        *acmr_before = mesh_calc_acmr(mesh);
+    }
+    if(weld) {
+        mesh_weld_vertices(mesh);
+    }
+    mesh_optimize_vertex_cache(mesh);
+    mesh_optimize_vertex_fetch(mesh);
+    if(acmr_after) {
+        *acmr_after = mesh_calc_acmr(mesh);
+    }
+}
+
+//============================================================================
+// simplification
+//============================================================================
+
+struct EdgeCollapse
+{
+    float m_cost;
+    int   m_from;
+    int   m_to;
+    int   m_from_version;
+    int   m_to_version;
+
+    // NOTE: inverted so std::priority_queue pops the cheapest collapse first
+    bool operator<(const EdgeCollapse &other) const { return m_cost > other.m_cost; }
+};
+
+// garland-heckbert quadric error metric with half-edge collapses (surviving vertices keep their attributes)
+class QuadricSimplifier
+{
+public:
+    QuadricSimplifier(const MeshBase* mesh);
+    int simplify(int target_num_tri);
+    void write(MeshBase* mesh) const;
+
+private:
+    int                               m_num_vertex;
+    int                               m_num_tri;
+    int                               m_num_alive_tri;
+    std::vector<glm::vec3>            m_vert_coords;
+    std::vector<glm::ivec3>           m_tris;
+    std::vector<bool>                 m_tri_alive;
+    std::vector<std::vector<int> >    m_vert_tris;
+    std::vector<glm::mat4>            m_quadrics;
+    std::vector<int>                  m_vert_version;
+    std::vector<bool>                 m_vert_locked;
+    std::priority_queue<EdgeCollapse> m_heap;
+
+    float calc_cost(int from, int to) const;
+    void push_collapse(int from, int to);
+    void push_vertex_collapses(int v);
+    bool is_collapse_valid(int from, int to) const;
+    void collapse(int from, int to);
+};
+
+QuadricSimplifier::QuadricSimplifier(const MeshBase* mesh)
+    : m_num_vertex(mesh->get_num_vertex()),
+      m_num_tri(mesh->get_num_tri()),
+      m_num_alive_tri(mesh->get_num_tri()),
+      m_vert_coords(mesh->get_vert_coords(), mesh->get_vert_coords() + mesh->get_num_vertex()),
+      m_tris(mesh->get_num_tri()),
+      m_tri_alive(mesh->get_num_tri(), true),
+      m_vert_tris(mesh->get_num_vertex()),
+      m_quadrics(mesh->get_num_vertex(), glm::mat4(0)),
+      m_vert_version(mesh->get_num_vertex(), 0),
+      m_vert_locked(mesh->get_num_vertex(), false)
+{
+    const uint16_t* tri_indices = mesh->get_tri_indices();
+    std::unordered_map<uint64_t, int> edge_use_count;
+    for(int t = 0; t < m_num_tri; t++) {
+        glm::ivec3 tri(tri_indices[t * 3 + 0], tri_indices[t * 3 + 1], tri_indices[t * 3 + 2]);
+        m_tris[t] = tri;
+        glm::vec3 n   = glm::cross(m_vert_coords[tri[1]] - m_vert_coords[tri[0]], m_vert_coords[tri[2]] - m_vert_coords[tri[0]]);
+        float     len = glm::length(n);
+        glm::mat4 q(0);
+        if(len > EPSILON) {
+            n /= len;
+            glm::vec4 plane(n, -glm::dot(n, m_vert_coords[tri[0]]));
+            q = glm::outerProduct(plane, plane) * (len * 0.5f); // area-weighted
+        }
+        for(int k = 0; k < 3; k++) {
+            m_quadrics[tri[k]] += q;
+            m_vert_tris[tri[k]].push_back(t);
+            int a = std::min(tri[k], tri[(k + 1) % 3]);
+            int b = std::max(tri[k], tri[(k + 1) % 3]);
+            edge_use_count[(static_cast<uint64_t>(a) << 32) | b]++;
+        }
+    }
+
+    // NOTE: lock open boundaries (incl. unwelded uv / normal seams) so they stay watertight
+    for(std::unordered_map<uint64_t, int>::iterator p = edge_use_count.begin(); p != edge_use_count.end(); p++) {
+        if((*p).second == 1) {
+            m_vert_locked[(*p).first >> 32]        = true;
+            m_vert_locked[(*p).first & 0xFFFFFFFF] = true;
+        }
+    }
+    for(int v = 0; v < m_num_vertex; v++) {
+        push_vertex_collapses(v);
+    }
+}
+
+int QuadricSimplifier::simplify(int target_num_tri)
+{
+    while(m_num_alive_tri > target_num_tri && !m_heap.empty()) {
+        EdgeCollapse c = m_heap.top();
+        m_heap.pop();
+        if(m_vert_version[c.m_from] != c.m_from_version || m_vert_version[c.m_to] != c.m_to_version) {
+            continue; // stale
+        }
+        if(!is_collapse_valid(c.m_from, c.m_to)) {
+            continue;
+        }
+        collapse(c.m_from, c.m_to);
+    }
+    return m_num_alive_tri;
+}
+
+void QuadricSimplifier::write(MeshBase* mesh) const
+{
+    std::vector<int> remap(m_num_vertex, -1);
+    std::vector<int> kept_verts;
+    std::vector<uint16_t> new_tri_indices;
+    new_tri_indices.reserve(m_num_alive_tri * 3);
+    for(int t = 0; t < m_num_tri; t++) {
+        if(!m_tri_alive[t]) {
+            continue;
+        }
+        for(int k = 0; k < 3; k++) {
+            int &new_vert_index = remap[m_tris[t][k]];
+            if(new_vert_index == -1) {
+                new_vert_index = kept_verts.size();
+                kept_verts.push_back(m_tris[t][k]);
+            }
+            new_tri_indices.push_back(new_vert_index);
+        }
+    }
+    int new_num_vertex = kept_verts.size();
+    std::vector<glm::vec3> new_vert_coords(new_num_vertex);
+    std::vector<glm::vec3> new_vert_normals(new_num_vertex);
+    std::vector<glm::vec3> new_vert_tangents(new_num_vertex);
+    std::vector<glm::vec2> new_tex_coords(new_num_vertex);
+    for(int k = 0; k < new_num_vertex; k++) {
+        new_vert_coords[k]   = mesh->get_vert_coords()[kept_verts[k]];
+        new_vert_normals[k]  = mesh->get_vert_normals()[kept_verts[k]];
+        new_vert_tangents[k] = mesh->get_vert_tangents()[kept_verts[k]];
+        new_tex_coords[k]    = mesh->get_tex_coords()[kept_verts[k]];
+    }
+    mesh->resize(new_num_vertex, m_num_alive_tri);
+    if(!new_num_vertex) {
+        return;
+    }
+    memcpy(mesh->get_vert_coords(),   &new_vert_coords[0],   sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_vert_normals(),  &new_vert_normals[0],  sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_vert_tangents(), &new_vert_tangents[0], sizeof(glm::vec3) * new_num_vertex);
+    memcpy(mesh->get_tex_coords(),    &new_tex_coords[0],    sizeof(glm::vec2) * new_num_vertex);
+    memcpy(mesh->get_tri_indices(),   &new_tri_indices[0],   sizeof(uint16_t)  * m_num_alive_tri * 3);
+}
+
+// error of moving "from" onto "to" under the combined quadric
+float QuadricSimplifier::calc_cost(int from, int to) const
+{
+    glm::vec4 p(m_vert_coords[to], 1);
+    return glm::dot(p, (m_quadrics[from] + m_quadrics[to]) * p);
+}
+
+void QuadricSimplifier::push_collapse(int from, int to)
+{
+    if(m_vert_locked[from]) {
+        return;
+    }
+    EdgeCollapse c;
+    c.m_cost         = calc_cost(from, to);
+    c.m_from         = from;
+    c.m_to           = to;
+    c.m_from_version = m_vert_version[from];
+    c.m_to_version   = m_vert_version[to];
+    m_heap.push(c);
+}
+
+// pushes collapses of v into each neighbor and of each neighbor into v
+void QuadricSimplifier::push_vertex_collapses(int v)
+{
+    for(std::vector<int>::const_iterator p = m_vert_tris[v].begin(); p != m_vert_tris[v].end(); p++) {
+        if(!m_tri_alive[*p]) {
+            continue;
+        }
+        for(int k = 0; k < 3; k++) {
+            int w = m_tris[*p][k];
+            if(w == v) {
+                continue;
+            }
+            push_collapse(v, w);
+            push_collapse(w, v);
+        }
+    }
+}
+
+// rejects collapses that would flip a surviving triangle
+bool QuadricSimplifier::is_collapse_valid(int from, int to) const
+{
+    for(std::vector<int>::const_iterator p = m_vert_tris[from].begin(); p != m_vert_tris[from].end(); p++) {
+        if(!m_tri_alive[*p]) {
+            continue;
+        }
+        const glm::ivec3 &tri = m_tris[*p];
+        if(tri[0] == to || tri[1] == to || tri[2] == to) {
+            continue; // removed by collapse
+        }
+        glm::vec3 old_coords[3];
+        glm::vec3 new_coords[3];
+        for(int k = 0; k < 3; k++) {
+            old_coords[k] = m_vert_coords[tri[k]];
+            new_coords[k] = (tri[k] == from) ? m_vert_coords[to] : old_coords[k];
+        }
+        glm::vec3 old_normal = glm::cross(old_coords[1] - old_coords[0], old_coords[2] - old_coords[0]);
+        glm::vec3 new_normal = glm::cross(new_coords[1] - new_coords[0], new_coords[2] - new_coords[0]);
+        if(glm::dot(old_normal, new_normal) <= 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void QuadricSimplifier::collapse(int from, int to)
+{
+    for(std::vector<int>::const_iterator p = m_vert_tris[from].begin(); p != m_vert_tris[from].end(); p++) {
+        if(!m_tri_alive[*p]) {
+            continue;
+        }
+        glm::ivec3 &tri = m_tris[*p];
+        if(tri[0] == to || tri[1] == to || tri[2] == to) {
+            m_tri_alive[*p] = false;
+            m_num_alive_tri--;
+            continue;
+        }
+        for(int k = 0; k < 3; k++) {
+            if(tri[k] == from) {
+                tri[k] = to;
+            }
+        }
+        m_vert_tris[to].push_back(*p);
+    }
+    m_vert_tris[from].clear();
+    m_quadrics[to] += m_quadrics[from];
+    m_vert_version[from]++;
+    m_vert_version[to]++;
+    push_vertex_collapses(to);
+}
+
+// NOTE: vertex attributes are not blended, so works best on welded meshes
+int mesh_simplify(MeshBase* mesh, int target_num_tri)
+{
+    int num_tri = mesh->get_num_tri();
+    target_num_tri = std::max(target_num_tri, SIMPLIFY_MIN_TRI);
+    if(target_num_tri >= num_tri) {
+        return num_tri;
+    }
+    QuadricSimplifier simplifier(mesh);
+    int new_num_tri = simplifier.simplify(target_num_tri);
+    if(new_num_tri == num_tri) {
+        return num_tri;
+    }
+    simplifier.write(mesh);
+    mesh->update_bbox();
+    return new_num_tri;
 }
 
 }
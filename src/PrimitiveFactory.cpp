@@ -16,14 +16,24 @@
 // along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <PrimitiveFactory.h>
+#include <Mesh.h>
 #include <Modifiers.h>
 #include <MeshBase.h>
 #include <Util.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <string>
+#include <sstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <algorithm>
+#include <float.h>
 #include <assert.h>
 
+#define PARALLEL_PRIMITIVE_MIN_VERTEX 16384
+#define MAX_PRIMITIVE_THREADS         8
+
 namespace vt {
 
 MeshBase* alloc_mesh_base(const std::string& name, size_t num_vertex, size_t num_tri);
@@ -68,105 +78,174 @@ void PrimitiveFactory::get_box_corners(glm::vec3        (&points)[8],
     }
 }
 
-Mesh* PrimitiveFactory::create_grid(const std::string& name,
-                                          int          cols,
-                                          int          rows,
-                                          float        width,
-                                          float        length,
-                                          float        tex_width_scale,
-                                          float        tex_length_scale)
+// NOTE: rows are independent, so large lattices are generated by several threads writing disjoint ranges
+template<class F>
+static void parallel_rows(int num_rows, int num_vertex, F f)
 {
-    int       num_vertex = (rows + 1) * (cols + 1);
-    int       num_tri    = rows * cols * 2;
-    MeshBase* mesh       = alloc_mesh_base(name, num_vertex, num_tri);
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            mesh->set_vert_coord( vert_index, glm::vec3(
-                    width * (static_cast<float>(col) / cols),
-                    0,
-                    length * (1 - static_cast<float>(row) / rows)));
-            mesh->set_vert_normal( vert_index, glm::vec3(0, 1, 0));
-            mesh->set_vert_tangent(vert_index, glm::vec3(1, 0, 0));
-            vert_index++;
-        }
+    int num_threads = 1;
+    if(num_vertex >= PARALLEL_PRIMITIVE_MIN_VERTEX) {
+        num_threads = std::max(1, std::min(static_cast<int>(std::thread::hardware_concurrency()), MAX_PRIMITIVE_THREADS));
     }
+    int per_thread = (num_rows + num_threads - 1) / num_threads;
+    std::vector<std::thread> threads;
+    for(int t = 1; t < num_threads; t++) {
+        int begin = std::min(t * per_thread, num_rows);
+        int end   = std::min(begin + per_thread, num_rows);
+        threads.push_back(std::thread(f, begin, end));
+    }
+    f(0, std::min(per_thread, num_rows));
+    for(int t = 0; t < static_cast<int>(threads.size()); t++) {
+        threads[t].join();
+    }
+}
 
-    // ========================
-    // init mesh texture coords
-    // ========================
-
-    int tex_vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            mesh->set_tex_coord(tex_vert_index++, glm::vec2(
-                    static_cast<float>(col) / cols / tex_width_scale,
-                    1 - static_cast<float>(row) / rows / tex_length_scale));
-        }
+static void calc_col_dirs(int cols, float yaw_offset, std::vector<glm::vec3>* col_dirs)
+{
+    col_dirs->resize(cols + 1);
+    for(int col = 0; col <= cols; col++) {
+        (*col_dirs)[col] = euler_to_offset(glm::vec3(
+                0,
+                0,                                                   // pitch
+                static_cast<float>(col) / cols * 360 + yaw_offset)); // yaw
     }
+}
 
-    // ==========================
-    // init mesh triangle indices
-    // ==========================
+// NOTE: writes coords, normals, tangents, tex coords, tri indices and bbox in a single pass over pre-sized buffers
+template<class F>
+static MeshBase* create_lattice(const std::string& name,
+                                      int          cols,
+                                      int          rows,
+                                      float        tex_width_scale,
+                                      float        tex_length_scale,
+                                      F            vertex_fn)
+{
+    int       num_vertex = (rows + 1) * (cols + 1);
+    int       num_tri    = rows * cols * 2;
+    MeshBase* mesh       = alloc_mesh_base(name, num_vertex, num_tri);
 
-    int tri_index = 0;
-    for(int row = 0; row < rows; row++) {
-        for(int col = 0; col < cols; col++) {
-            int lower_left  = row * (cols + 1) + col;
-            int lower_right = lower_left + 1;
-            int upper_left  = (row + 1) * (cols + 1) + col;
-            int upper_right = upper_left + 1;
-            mesh->set_tri_indices(tri_index++, glm::ivec3(lower_left, lower_right, upper_right));
-            mesh->set_tri_indices(tri_index++, glm::ivec3(upper_right, upper_left, lower_left));
-        }
-    }
+    glm::vec3* vert_coords   = mesh->get_vert_coords();
+    glm::vec3* vert_normals  = mesh->get_vert_normals();
+    glm::vec3* vert_tangents = mesh->get_vert_tangents();
+    glm::vec2* tex_coords    = mesh->get_tex_coords();
+    uint16_t*  tri_indices   = mesh->get_tri_indices();
+
+    glm::vec3  min(FLT_MAX);
+    glm::vec3  max(-FLT_MAX);
+    std::mutex min_max_mutex;
+    parallel_rows(rows + 1, num_vertex, [&](int row_begin, int row_end) {
+        glm::vec3 local_min(FLT_MAX);
+        glm::vec3 local_max(-FLT_MAX);
+        for(int row = row_begin; row < row_end; row++) {
+            int vert_index = row * (cols + 1);
+            for(int col = 0; col <= cols; col++) {
+
+                // ==============================
+                // init mesh vertex/normal coords
+                // ==============================
+
+                vertex_fn(row, col, &vert_coords[vert_index], &vert_normals[vert_index], &vert_tangents[vert_index]);
+                local_min = glm::min(local_min, vert_coords[vert_index]);
+                local_max = glm::max(local_max, vert_coords[vert_index]);
+
+                // ========================
+                // init mesh texture coords
+                // ========================
+
+                tex_coords[vert_index] = glm::vec2(
+                        static_cast<float>(col) / cols / tex_width_scale,
+                        1 - static_cast<float>(row) / rows / tex_length_scale);
+                vert_index++;
+            }
+            if(row == rows) {
+                continue;
+            }
 
-    mesh->update_bbox();
+            // ==========================
+            // init mesh triangle indices
+            // ==========================
+
+            uint16_t* cur_indices = &tri_indices[row * cols * 6];
+            for(int col = 0; col < cols; col++) {
+                int lower_left  = row * (cols + 1) + col;
+                int lower_right = lower_left + 1;
+                int upper_left  = (row + 1) * (cols + 1) + col;
+                int upper_right = upper_left + 1;
+                *cur_indices++ = lower_left;
+                *cur_indices++ = lower_right;
+                *cur_indices++ = upper_right;
+                *cur_indices++ = upper_right;
+                *cur_indices++ = upper_left;
+                *cur_indices++ = lower_left;
+            }
+        }
+        std::lock_guard<std::mutex> lock(min_max_mutex);
+        min = glm::min(min, local_min);
+        max = glm::max(max, local_max);
+    });
+
+    // NOTE: every lattice vertex is referenced by a triangle, so this matches update_bbox
+    cast_mesh(mesh)->set_min_max(min, max);
+    return mesh;
+}
 
-    assert(vert_index == num_vertex);
-    assert(tri_index  == num_tri);
+Mesh* PrimitiveFactory::create_grid(const std::string& name,
+                                          int          cols,
+                                          int          rows,
+                                          float        width,
+                                          float        length,
+                                          float        tex_width_scale,
+                                          float        tex_length_scale)
+{
+    MeshBase* mesh = create_lattice(name, cols, rows, tex_width_scale, tex_length_scale,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                *coord = glm::vec3(
+                        width * (static_cast<float>(col) / cols),
+                        0,
+                        length * (1 - static_cast<float>(row) / rows));
+                *normal  = glm::vec3(0, 1, 0);
+                *tangent = glm::vec3(1, 0, 0);
+            });
     return cast_mesh(mesh);
 }
 
+static std::string make_lod_name(const std::string& name, int lod)
+{
+    std::stringstream ss;
+    ss << name << "_lod" << lod;
+    return ss.str();
+}
+
 Mesh* PrimitiveFactory::create_sphere(const std::string& name,
                                             int          slices,
                                             int          stacks,
-                                            float        radius)
+                                            float        radius,
+                                            int          num_lods)
 {
-    int       cols = slices;
-    int       rows = stacks;
-    MeshBase* mesh = cast_mesh_base(create_grid(name, cols, rows));
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            glm::vec3 normal = euler_to_offset(glm::vec3(
-                    0,
-                    -(static_cast<float>(row) / rows * 180 - 90), // pitch
-                    static_cast<float>(col) / cols * 360));       // yaw
-            glm::vec3 offset = normal * radius;
-            mesh->set_vert_coord(  vert_index, offset);
-            mesh->set_vert_normal( vert_index, safe_normalize(offset));
-            mesh->set_vert_tangent(vert_index, euler_to_offset(glm::vec3(
-                    0,
-                    0,                                            // pitch
-                    static_cast<float>(col) / cols * 360 + 90))); // yaw
-            vert_index++;
-        }
+    int cols = slices;
+    int rows = stacks;
+    std::vector<glm::vec3> col_tangents;
+    calc_col_dirs(cols, 90, &col_tangents);
+    MeshBase* mesh = create_lattice(name, cols, rows, 1, 1,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                glm::vec3 dir = euler_to_offset(glm::vec3(
+                        0,
+                        -(static_cast<float>(row) / rows * 180 - 90), // pitch
+                        static_cast<float>(col) / cols * 360));       // yaw
+                *coord   = dir * radius;
+                *normal  = safe_normalize(*coord);
+                *tangent = col_tangents[col];
+            });
+
+    mesh_optimize(mesh);
+
+    // NOTE: halving slices and stacks quarters triangle count, so halve screen size threshold per lod
+    Mesh* result = cast_mesh(mesh);
+    for(int i = 1; i <= num_lods && (slices >> i) >= 4 && (stacks >> i) >= 2; i++) {
+        result->add_lod(create_sphere(make_lod_name(name, i), slices >> i, stacks >> i, radius),
+                        DEFAULT_LOD_SCREEN_SIZE / (1 << (i - 1)));
     }
 
-    mesh->update_bbox();
-
-    return cast_mesh(mesh);
+    return result;
 }
 
 Mesh* PrimitiveFactory::create_hemisphere(const std::string& name,
@@ -174,44 +253,33 @@ Mesh* PrimitiveFactory::create_hemisphere(const std::string& name,
                                                 int          stacks,
                                                 float        radius)
 {
-    int       cols = slices;
-    int       rows = stacks * 0.5 + 2;
-    MeshBase* mesh = cast_mesh_base(create_grid(name, cols, rows));
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            switch(row) {
-                case 0: // bottom
-                    mesh->set_vert_coord( vert_index, glm::vec3(0,  0, 0));
-                    mesh->set_vert_normal(vert_index, glm::vec3(0, -1, 0));
-                    break;
-                default:
-                    {
-                        glm::vec3 offset = euler_to_offset(glm::vec3(
-                                0,
-                                (row == 1) ? 0 : -(static_cast<float>(row - 2) / (rows - 2) * 90), // pitch
-                                static_cast<float>(col) / cols * 360))                             // yaw
-                                *radius;
-                        mesh->set_vert_coord( vert_index, offset);
-                        mesh->set_vert_normal(vert_index, (row == 1) ?
-                                glm::vec3(0, -1, 0) : safe_normalize(offset));
-                    }
-                    break;
-            }
-            mesh->set_vert_tangent(vert_index, euler_to_offset(glm::vec3(
-                    0,
-                    0,                                            // pitch
-                    static_cast<float>(col) / cols * 360 + 90))); // yaw
-            vert_index++;
-        }
-    }
-
-    mesh->update_bbox();
+    int cols = slices;
+    int rows = stacks * 0.5 + 2;
+    std::vector<glm::vec3> col_tangents;
+    calc_col_dirs(cols, 90, &col_tangents);
+    MeshBase* mesh = create_lattice(name, cols, rows, 1, 1,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                switch(row) {
+                    case 0: // bottom
+                        *coord  = glm::vec3(0,  0, 0);
+                        *normal = glm::vec3(0, -1, 0);
+                        break;
+                    default:
+                        {
+                            glm::vec3 offset = euler_to_offset(glm::vec3(
+                                    0,
+                                    (row == 1) ? 0 : -(static_cast<float>(row - 2) / (rows - 2) * 90), // pitch
+                                    static_cast<float>(col) / cols * 360))                             // yaw
+                                    *radius;
+                            *coord  = offset;
+                            *normal = (row == 1) ? glm::vec3(0, -1, 0) : safe_normalize(offset);
+                        }
+                        break;
+                }
+                *tangent = col_tangents[col];
+            });
+
+    mesh_optimize(mesh);
 
     return cast_mesh(mesh);
 }
@@ -221,62 +289,39 @@ Mesh* PrimitiveFactory::create_cylinder(const std::string& name,
                                               float        radius,
                                               float        height)
 {
-    int       cols = slices;
-    int       rows = 5;
-    MeshBase* mesh = cast_mesh_base(create_grid(name, cols, rows));
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            switch(row) {
-                case 0: // bottom
-                    mesh->set_vert_coord( vert_index, glm::vec3(0,  0, 0));
-                    mesh->set_vert_normal(vert_index, glm::vec3(0, -1, 0));
-                    break;
-                case 1: // bottom rim
-                case 2: // bottom side rim
-                    {
-                        glm::vec3 offset = euler_to_offset(glm::vec3(
-                                0,
-                                0,                                     // pitch
-                                static_cast<float>(col) / cols * 360)) // yaw
-                                *radius;
-                        mesh->set_vert_coord( vert_index, glm::vec3(offset.x, 0, offset.z));
-                        mesh->set_vert_normal(vert_index, (row == 1) ?
-                                glm::vec3(0, -1, 0) : safe_normalize(offset));
-                    }
-                    break;
-                case 3: // top side rim
-                case 4: // top rim
-                    {
-                        glm::vec3 offset = euler_to_offset(glm::vec3(
-                                0,
-                                0,                                     // pitch
-                                static_cast<float>(col) / cols * 360)) // yaw
-                                *radius;
-                        mesh->set_vert_coord( vert_index, glm::vec3(offset.x, height, offset.z));
-                        mesh->set_vert_normal(vert_index, (row == 4) ?
-                                glm::vec3(0, 1, 0) : safe_normalize(offset));
-                    }
-                    break;
-                case 5: // top
-                    mesh->set_vert_coord( vert_index, glm::vec3(0, height, 0));
-                    mesh->set_vert_normal(vert_index, glm::vec3(0, 1, 0));
-                    break;
-            }
-            mesh->set_vert_tangent(vert_index, euler_to_offset(glm::vec3(
-                    0,
-                    0,                                            // pitch
-                    static_cast<float>(col) / cols * 360 + 90))); // yaw
-            vert_index++;
-        }
-    }
-
-    mesh->update_bbox();
+    int cols = slices;
+    int rows = 5;
+    std::vector<glm::vec3> col_dirs;
+    std::vector<glm::vec3> col_tangents;
+    calc_col_dirs(cols, 0,  &col_dirs);
+    calc_col_dirs(cols, 90, &col_tangents);
+    MeshBase* mesh = create_lattice(name, cols, rows, 1, 1,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                glm::vec3 offset = col_dirs[col] * radius;
+                switch(row) {
+                    case 0: // bottom
+                        *coord  = glm::vec3(0,  0, 0);
+                        *normal = glm::vec3(0, -1, 0);
+                        break;
+                    case 1: // bottom rim
+                    case 2: // bottom side rim
+                        *coord  = glm::vec3(offset.x, 0, offset.z);
+                        *normal = (row == 1) ? glm::vec3(0, -1, 0) : safe_normalize(offset);
+                        break;
+                    case 3: // top side rim
+                    case 4: // top rim
+                        *coord  = glm::vec3(offset.x, height, offset.z);
+                        *normal = (row == 4) ? glm::vec3(0, 1, 0) : safe_normalize(offset);
+                        break;
+                    case 5: // top
+                        *coord  = glm::vec3(0, height, 0);
+                        *normal = glm::vec3(0, 1, 0);
+                        break;
+                }
+                *tangent = col_tangents[col];
+            });
+
+    mesh_optimize(mesh);
 
     return cast_mesh(mesh);
 }
@@ -286,57 +331,36 @@ Mesh* PrimitiveFactory::create_cone(const std::string& name,
                                           float        radius,
                                           float        height)
 {
-    int       cols = slices;
-    int       rows = 3;
-    MeshBase* mesh = cast_mesh_base(create_grid(name, cols, rows));
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
+    int cols = slices;
+    int rows = 3;
+    std::vector<glm::vec3> col_dirs;
+    std::vector<glm::vec3> col_tangents;
+    calc_col_dirs(cols, 0,  &col_dirs);
+    calc_col_dirs(cols, 90, &col_tangents);
     float rim_y_offset = radius * sin(HALF_PI - atan(height / radius));
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            switch(row) {
-                case 0: // bottom
-                    mesh->set_vert_coord( vert_index, glm::vec3(0,  0, 0));
-                    mesh->set_vert_normal(vert_index, glm::vec3(0, -1, 0));
-                    break;
-                case 1: // bottom rim
-                case 2: // side rim
-                    {
-                        glm::vec3 offset = euler_to_offset(glm::vec3(
-                                0,
-                                0,                                     // pitch
-                                static_cast<float>(col) / cols * 360)) // yaw
-                                *radius;
-                        mesh->set_vert_coord( vert_index, offset);
-                        mesh->set_vert_normal(vert_index, (row == 1) ?
-                                glm::vec3(0, -1, 0) : safe_normalize(offset + glm::vec3(0, rim_y_offset, 0)));
-                    }
-                    break;
-                case 3: // tip
-                    {
-                        glm::vec3 offset = euler_to_offset(glm::vec3(
-                                0,
-                                0,                                     // pitch
-                                static_cast<float>(col) / cols * 360)) // yaw
-                                *radius;
-                        mesh->set_vert_coord( vert_index, glm::vec3(0, height, 0));
-                        mesh->set_vert_normal(vert_index, safe_normalize(offset + glm::vec3(0, rim_y_offset, 0)));
-                    }
-                    break;
-            }
-            mesh->set_vert_tangent(vert_index, euler_to_offset(glm::vec3(
-                    0,
-                    0,                                            // pitch
-                    static_cast<float>(col) / cols * 360 + 90))); // yaw
-            vert_index++;
-        }
-    }
-
-    mesh->update_bbox();
+    MeshBase* mesh = create_lattice(name, cols, rows, 1, 1,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                glm::vec3 offset = col_dirs[col] * radius;
+                switch(row) {
+                    case 0: // bottom
+                        *coord  = glm::vec3(0,  0, 0);
+                        *normal = glm::vec3(0, -1, 0);
+                        break;
+                    case 1: // bottom rim
+                    case 2: // side rim
+                        *coord  = offset;
+                        *normal = (row == 1) ?
+                                glm::vec3(0, -1, 0) : safe_normalize(offset + glm::vec3(0, rim_y_offset, 0));
+                        break;
+                    case 3: // tip
+                        *coord  = glm::vec3(0, height, 0);
+                        *normal = safe_normalize(offset + glm::vec3(0, rim_y_offset, 0));
+                        break;
+                }
+                *tangent = col_tangents[col];
+            });
+
+    mesh_optimize(mesh);
 
     return cast_mesh(mesh);
 }
@@ -345,40 +369,35 @@ Mesh* PrimitiveFactory::create_torus(const std::string& name,
                                            int          slices,
                                            int          stacks,
                                            float        radius_major,
-                                           float        radius_minor)
+                                           float        radius_minor,
+                                           int          num_lods)
 {
-    int       cols = slices;
-    int       rows = stacks;
-    MeshBase* mesh = cast_mesh_base(create_grid(name, cols, rows));
-
-    // ==============================
-    // init mesh vertex/normal coords
-    // ==============================
-
-    int vert_index = 0;
-    for(int row = 0; row <= rows; row++) {
-        for(int col = 0; col <= cols; col++) {
-            glm::vec3 normal_major = euler_to_offset(glm::vec3(
-                    0,
-                    0,                                      // pitch
-                    static_cast<float>(col) / cols * 360)); // yaw
-            glm::vec3 normal_minor = euler_to_offset(glm::vec3(
-                    0,
-                    -(static_cast<float>(row) / rows * 360 - 180), // pitch
-                    static_cast<float>(col) / cols * 360));        // yaw
-            mesh->set_vert_coord(  vert_index, normal_major * radius_major + normal_minor * radius_minor);
-            mesh->set_vert_normal( vert_index, normal_minor);
-            mesh->set_vert_tangent(vert_index, euler_to_offset(glm::vec3(
-                    0,
-                    0,                                            // pitch
-                    static_cast<float>(col) / cols * 360 + 90))); // yaw
-            vert_index++;
-        }
+    int cols = slices;
+    int rows = stacks;
+    std::vector<glm::vec3> col_dirs;
+    std::vector<glm::vec3> col_tangents;
+    calc_col_dirs(cols, 0,  &col_dirs);
+    calc_col_dirs(cols, 90, &col_tangents);
+    MeshBase* mesh = create_lattice(name, cols, rows, 1, 1,
+            [&](int row, int col, glm::vec3* coord, glm::vec3* normal, glm::vec3* tangent) {
+                glm::vec3 normal_minor = euler_to_offset(glm::vec3(
+                        0,
+                        -(static_cast<float>(row) / rows * 360 - 180), // pitch
+                        static_cast<float>(col) / cols * 360));        // yaw
+                *coord   = col_dirs[col] * radius_major + normal_minor * radius_minor;
+                *normal  = normal_minor;
+                *tangent = col_tangents[col];
+            });
+
+    mesh_optimize(mesh);
+
+    Mesh* result = cast_mesh(mesh);
+    for(int i = 1; i <= num_lods && (slices >> i) >= 4 && (stacks >> i) >= 4; i++) {
+        result->add_lod(create_torus(make_lod_name(name, i), slices >> i, stacks >> i, radius_major, radius_minor),
+                        DEFAULT_LOD_SCREEN_SIZE / (1 << (i - 1)));
     }
 
-    mesh->update_bbox();
-
-    return cast_mesh(mesh);
+    return result;
 }
 
 Mesh* PrimitiveFactory::create_box(const std::string& name,
@@ -634,14 +653,9 @@ Mesh* PrimitiveFactory::create_geosphere(const std::string& name,
 {
     MeshBase* mesh = cast_mesh_base(create_sphere(name, 4, 2, radius));
     mesh->center_axis();
-    for(int i = 0; i < tessellation_iters; i++) {
-        mesh_tessellate(mesh, TESSELLATION_TYPE_EDGE_CENTER, true);
-        size_t num_vertex = mesh->get_num_vertex();
-        for(int j = 0; j < static_cast<int>(num_vertex); j++) {
-            mesh->set_vert_coord(j, safe_normalize(mesh->get_vert_coord(j)) * radius);
-        }
-        mesh->center_axis();
-    }
+    mesh_tessellate(mesh, TESSELLATION_TYPE_EDGE_CENTER, true, tessellation_iters, radius);
+    mesh->center_axis();
+    mesh_optimize(mesh);
     return cast_mesh(mesh);
 }
 
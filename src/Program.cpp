@@ -19,19 +19,26 @@
 #include <Shader.h>
 #include <VarAttribute.h>
 #include <VarUniform.h>
-#include <Util.h>
+#include <FileCooked.h>
 #include <GL/glew.h>
 #include <stdlib.h>
 #include <iostream>
-#include <sstream>
+#include <vector>
 #include <algorithm>
 #include <iterator>
 #include <memory.h>
+#include <stdint.h>
 #include <assert.h>
 
 namespace vt {
 
 Program::var_attribute_type_to_name_table_t Program::m_var_attribute_type_to_name_table[] = {
+        {Program::var_attribute_type_bone_indices,    "bone_indices"},
+        {Program::var_attribute_type_bone_weights,    "bone_weights"},
+        {Program::var_attribute_type_packed_normal,   "packed_normal"},
+        {Program::var_attribute_type_packed_position, "packed_position"},
+        {Program::var_attribute_type_packed_tangent,  "packed_tangent"},
+        {Program::var_attribute_type_packed_texcoord, "packed_texcoord"},
         {Program::var_attribute_type_texcoord,        "texcoord"},
         {Program::var_attribute_type_vertex_normal,   "vertex_normal"},
         {Program::var_attribute_type_vertex_position, "vertex_position"},
@@ -44,6 +51,7 @@ Program::var_uniform_type_to_name_table_t Program::m_var_uniform_type_to_name_ta
         {Program::var_uniform_type_backface_depth_overlay_texture,  "backface_depth_overlay_texture"},
         {Program::var_uniform_type_backface_normal_overlay_texture, "backface_normal_overlay_texture"},
         {Program::var_uniform_type_bloom_kernel,                    "bloom_kernel"},
+        {Program::var_uniform_type_bone_transforms,                 "bone_transforms"},
         {Program::var_uniform_type_bump_texture,                    "bump_texture"},
         {Program::var_uniform_type_camera_dir,                      "camera_dir"},
         {Program::var_uniform_type_camera_far,                      "camera_far"},
@@ -51,6 +59,9 @@ Program::var_uniform_type_to_name_table_t Program::m_var_uniform_type_to_name_ta
         {Program::var_uniform_type_camera_pos,                      "camera_pos"},
         {Program::var_uniform_type_color_texture,                   "color_texture"},
         {Program::var_uniform_type_color_texture2,                  "color_texture2"},
+        {Program::var_uniform_type_deformer_origin,                 "deformer_origin"},
+        {Program::var_uniform_type_deformer_params,                 "deformer_params"},
+        {Program::var_uniform_type_deformer_type,                   "deformer_type"},
         {Program::var_uniform_type_env_map_texture,                 "env_map_texture"},
         {Program::var_uniform_type_frontface_depth_overlay_texture, "frontface_depth_overlay_texture"},
         {Program::var_uniform_type_glow_cutoff_threshold,           "glow_cutoff_threshold"},
@@ -65,6 +76,9 @@ Program::var_uniform_type_to_name_table_t Program::m_var_uniform_type_to_name_ta
         {Program::var_uniform_type_model_transform,                 "model_transform"},
         {Program::var_uniform_type_mvp_transform,                   "mvp_transform"},
         {Program::var_uniform_type_normal_transform,                "normal_transform"},
+        {Program::var_uniform_type_packed_vertices,                 "packed_vertices"},
+        {Program::var_uniform_type_position_dequant_offset,         "position_dequant_offset"},
+        {Program::var_uniform_type_position_dequant_scale,          "position_dequant_scale"},
         {Program::var_uniform_type_random_texture,                  "random_texture"},
         {Program::var_uniform_type_reflect_to_refract_ratio,        "reflect_to_refract_ratio"},
         {Program::var_uniform_type_ssao_sample_kernel_pos,          "ssao_sample_kernel_pos"},
@@ -101,39 +115,35 @@ void Program::attach_shader(Shader* shader)
     }
 }
 
+// NOTE: reflects active variables from the linked program, so inactive (optimized out) declarations are skipped
 bool Program::auto_add_shader_vars()
 {
-    for(int i = 0; i<2; i++) {
-        std::string filename = (i == 0 ? m_vertex_shader : m_fragment_shader)->get_filename();
-        std::string file_data;
-        if(!read_file(filename, file_data)) {
-            return false;
-        }
-        std::stringstream ss;
-        ss << file_data;
-        std::string line;
-        while(getline(ss, line, '\n')) {
-            //std::cout << "LINE: " << line << std::endl;
-            std::string type_name;
-            std::string var_name;
-            if(regexp(line, "attribute[ ]+([^ ]+)[ ]+([^ ;\[]+)[;\[]", 3,
-                      reinterpret_cast<char*>(NULL),
-                      &type_name,
-                      &var_name))
-            {
-                //std::cout << "VAR ATTRIBUTE TYPE: " << type_name << std::endl;
-                //std::cout << "VAR ATTRIBUTE NAME: " << var_name << std::endl;
-                add_var(Program::VAR_TYPE_ATTRIBUTE, var_name);
+    clear_vars();
+    for(int i = 0; i < 2; i++) {
+        var_type_t var_type = (i == 0) ? Program::VAR_TYPE_ATTRIBUTE : Program::VAR_TYPE_UNIFORM;
+        GLint num_vars        = 0;
+        GLint max_name_length = 0;
+        get_program_iv((i == 0) ? GL_ACTIVE_ATTRIBUTES           : GL_ACTIVE_UNIFORMS,           &num_vars);
+        get_program_iv((i == 0) ? GL_ACTIVE_ATTRIBUTE_MAX_LENGTH : GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_name_length);
+        std::vector<GLchar> name_buf(std::max(max_name_length, 1));
+        for(int j = 0; j < num_vars; j++) {
+            GLsizei length = 0;
+            GLint   size   = 0;
+            GLenum  type   = 0;
+            if(i == 0) {
+                glGetActiveAttrib(m_id, j, name_buf.size(), &length, &size, &type, &name_buf[0]);
+            } else {
+                glGetActiveUniform(m_id, j, name_buf.size(), &length, &size, &type, &name_buf[0]);
             }
-            if(regexp(line, "uniform[ ]+([^ ]+)[ ]+([^ ;\[]+)[;\[]", 3,
-                      reinterpret_cast<char*>(NULL),
-                      &type_name,
-                      &var_name))
-            {
-                //std::cout << "VAR UNIFORM TYPE: " << type_name << std::endl;
-                //std::cout << "VAR UNIFORM NAME: " << var_name << std::endl;
-                add_var(Program::VAR_TYPE_UNIFORM, var_name);
+            std::string var_name(&name_buf[0], length);
+            if(!var_name.compare(0, 3, "gl_")) {
+                continue; // built-in
+            }
+            size_t array_pos = var_name.find('[');
+            if(array_pos != std::string::npos) {
+                var_name = var_name.substr(0, array_pos); // arrays report as "name[0]"
             }
+            insert_var(var_type, var_name);
         }
     }
     return true;
@@ -141,13 +151,99 @@ bool Program::auto_add_shader_vars()
 
 bool Program::link()
 {
+    begin_link();
+    return end_link();
+}
+
+// NOTE: only issues the link, so the driver can compile and link in the background until end_link()
+void Program::begin_link()
+{
+    if(GLEW_ARB_get_program_binary) {
+        glProgramParameteri(m_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(m_id);
+}
+
+// without GL_KHR_parallel_shader_compile there is no way to ask, so end_link() will block instead
+bool Program::is_link_complete() const
+{
+    if(!GLEW_KHR_parallel_shader_compile) {
+        return true;
+    }
+    GLint complete = GL_FALSE;
+    get_program_iv(GL_COMPLETION_STATUS_KHR, &complete);
+    return complete == GL_TRUE;
+}
+
+bool Program::end_link()
+{
     GLint link_ok = GL_FALSE;
     get_program_iv(GL_LINK_STATUS, &link_ok);
-    if(!auto_add_shader_vars()) {
+    if(link_ok != GL_TRUE) {
         return false;
     }
-    return (link_ok == GL_TRUE);
+    return auto_add_shader_vars();
+}
+
+// NOTE: key should cover shader sources and driver (see get_driver_hash), drivers also reject binaries on their own
+bool Program::load_binary(const std::string& cooked_filename, uint64_t key)
+{
+    if(!GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    CookedFile    cooked_file;
+    CookedProgram cooked_program;
+    if(!cooked_file.open(cooked_filename, CookedFile::TYPE_PROGRAM, key) || !cooked_file.read_program(&cooked_program)) {
+        return false;
+    }
+    glProgramBinary(m_id, cooked_program.m_binary_format, cooked_program.m_binary, cooked_program.m_binary_size);
+    GLint link_ok = GL_FALSE;
+    get_program_iv(GL_LINK_STATUS, &link_ok);
+    if(link_ok != GL_TRUE) {
+        return false;
+    }
+    clear_vars();
+    for(std::vector<std::string>::const_iterator p = cooked_program.m_attribute_names.begin(); p != cooked_program.m_attribute_names.end(); p++) {
+        insert_var(Program::VAR_TYPE_ATTRIBUTE, *p);
+    }
+    for(std::vector<std::string>::const_iterator q = cooked_program.m_uniform_names.begin(); q != cooked_program.m_uniform_names.end(); q++) {
+        insert_var(Program::VAR_TYPE_UNIFORM, *q);
+    }
+    return true;
+}
+
+bool Program::save_binary(const std::string& cooked_filename, uint64_t key) const
+{
+    if(!GLEW_ARB_get_program_binary) {
+        return false;
+    }
+    GLint binary_size = 0;
+    get_program_iv(GL_PROGRAM_BINARY_LENGTH, &binary_size);
+    if(!binary_size) {
+        return false;
+    }
+    std::vector<uint8_t> binary(binary_size);
+    GLenum binary_format = 0;
+    glGetProgramBinary(m_id, binary_size, NULL, &binary_format, &binary[0]);
+    CookedProgram cooked_program;
+    cooked_program.m_binary_format = binary_format;
+    cooked_program.m_binary        = &binary[0];
+    cooked_program.m_binary_size   = binary_size;
+    cooked_program.m_attribute_names.assign(m_var_attribute_names.begin(), m_var_attribute_names.end());
+    cooked_program.m_uniform_names.assign(m_var_uniform_names.begin(), m_var_uniform_names.end());
+    return CookedFile::write_program(cooked_filename, key, cooked_program);
+}
+
+// binaries are only valid for the driver that produced them
+uint64_t Program::get_driver_hash()
+{
+    uint64_t hash = 0;
+    const GLenum names[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    for(int i = 0; i < static_cast<int>(sizeof(names) / sizeof(names[0])); i++) {
+        const GLubyte* s = glGetString(names[i]);
+        hash = hash_combine(hash, hash_string(s ? reinterpret_cast<const char*>(s) : ""));
+    }
+    return hash;
 }
 
 void Program::use() const
@@ -194,45 +290,8 @@ std::string Program::get_var_uniform_name(int id)
     return m_var_uniform_type_to_name_table[id].second;
 }
 
-bool Program::check_var_exists_in_shader(var_type_t var_type, const std::string& name) const
-{
-    if(!m_vertex_shader || !m_fragment_shader) {
-        return false;
-    }
-    switch(var_type) {
-        case VAR_TYPE_ATTRIBUTE:
-            {
-                std::string cmd1 = std::string("/bin/grep \"attribute .* ") + name + "[;\[]\" " + m_vertex_shader->get_filename()   + " > /dev/null";
-                std::string cmd2 = std::string("/bin/grep \"attribute .* ") + name + "[;\[]\" " + m_fragment_shader->get_filename() + " > /dev/null";
-                if(!system(cmd1.c_str()) || !system(cmd2.c_str())) {
-                    std::cout << "\tFound attribute var \"" << name << "\"" << std::endl;
-                } else {
-                    std::cout << "\tError: Cannot find attribute var \"" << name << "\"" << std::endl;
-                    return false;
-                }
-            }
-            break;
-        case VAR_TYPE_UNIFORM:
-            {
-                std::string cmd1 = std::string("/bin/grep \"uniform .* ") + name + "[;\[]\" " + m_vertex_shader->get_filename()   + " > /dev/null";
-                std::string cmd2 = std::string("/bin/grep \"uniform .* ") + name + "[;\[]\" " + m_fragment_shader->get_filename() + " > /dev/null";
-                if(!system(cmd1.c_str()) || !system(cmd2.c_str())) {
-                    std::cout << "\tFound uniform var \"" << name << "\"" << std::endl;
-                } else {
-                    std::cout << "\tError: Cannot find uniform var \"" << name << "\"" << std::endl;
-                    return false;
-                }
-            }
-            break;
-    }
-    return true;
-}
-
-bool Program::add_var(var_type_t var_type, std::string name)
+bool Program::insert_var(var_type_t var_type, const std::string& name)
 {
-    if(!check_var_exists_in_shader(var_type, name)) {
-        exit(1);
-    }
     switch(var_type) {
         case VAR_TYPE_ATTRIBUTE:
             {
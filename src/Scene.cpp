@@ -18,6 +18,8 @@
 #include <Scene.h>
 #include <ShaderContext.h>
 #include <Camera.h>
+#include <DebugArena.h>
+#include <Deformer.h>
 #include <FrameBuffer.h>
 #include <Light.h>
 #include <Mesh.h>
@@ -64,6 +66,8 @@
 #define OCTREE_MARGIN              0.01f
 #define OCTREE_RENDER_LABEL_LEVELS -1
 
+#define DEFAULT_LOD_HYSTERESIS 0.1f
+
 namespace vt {
 
 DebugObjectContext::DebugObjectContext()
@@ -78,7 +82,10 @@ Scene::Scene()
       m_overlay(NULL),
       m_normal_material(NULL),
       m_wireframe_material(NULL),
-      m_ssao_material(NULL)
+      m_ssao_material(NULL),
+      m_fallback_material(NULL),
+      m_lod_enabled(true),
+      m_lod_hysteresis(DEFAULT_LOD_HYSTERESIS)
 {
     //const int bloom_kernel_row[BLOOM_KERNEL_SIZE] = {1, 4, 6, 4, 1};
     const int bloom_kernel_row[BLOOM_KERNEL_SIZE] = {1, 6, 15, 20, 15, 6, 1};
@@ -262,7 +269,11 @@ void Scene::remove_texture(Texture* texture)
 void Scene::use_program()
 {
     for(meshes_t::const_iterator q = m_meshes.begin(); q != m_meshes.end(); ++q) {
-        (*q)->get_shader_context()->get_material()->get_program()->use();
+        ShaderContext* shader_context = (*q)->get_shader_context();
+        if(!shader_context) {
+            continue; // still linking
+        }
+        shader_context->get_material()->get_program()->use();
     }
 }
 
@@ -358,19 +369,31 @@ void Scene::render(bool                clear_canvas,
         if(!mesh->is_visible()) {
             continue;
         }
+
+        // NOTE: geometry comes from selected lod, uniforms from base mesh
+        Mesh* lod_mesh = mesh;
+        if(m_lod_enabled && mesh->get_num_lods()) {
+            glm::vec3 center;
+            float     radius = 0;
+            mesh->get_bounding_sphere(&center, &radius);
+            lod_mesh = mesh->get_lod(mesh->select_lod(m_camera->get_projected_size(center, radius), m_lod_hysteresis));
+        }
         ShaderContext* shader_context = NULL;
         switch(use_material_type) {
             case use_material_type_t::USE_MESH_MATERIAL:
-                shader_context = mesh->get_shader_context();
+                shader_context = lod_mesh->get_shader_context();
+                if(!shader_context) {
+                    shader_context = lod_mesh->get_fallback_shader_context(m_fallback_material);
+                }
                 break;
             case use_material_type_t::USE_NORMAL_MATERIAL:
-                shader_context = mesh->get_normal_shader_context(m_normal_material);
+                shader_context = lod_mesh->get_normal_shader_context(m_normal_material);
                 break;
             case use_material_type_t::USE_WIREFRAME_MATERIAL:
-                shader_context = mesh->get_wireframe_shader_context(m_wireframe_material);
+                shader_context = lod_mesh->get_wireframe_shader_context(m_wireframe_material);
                 break;
             case use_material_type_t::USE_SSAO_MATERIAL:
-                shader_context = mesh->get_ssao_shader_context(m_ssao_material);
+                shader_context = lod_mesh->get_ssao_shader_context(m_ssao_material);
                 break;
         }
         if(!shader_context) {
@@ -400,6 +423,10 @@ void Scene::render(bool                clear_canvas,
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_bloom_kernel)) {
             shader_context->set_bloom_kernel(m_bloom_kernel);
         }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_bone_transforms) && mesh->is_skinned()) {
+            mesh->update_bone_palette();
+            shader_context->set_bone_transforms(mesh->get_bone_palette().size(), glm::value_ptr(mesh->get_bone_palette()[0]));
+        }
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_bump_texture)) {
             shader_context->set_bump_texture_index(mesh->get_bump_texture_index());
         }
@@ -415,6 +442,15 @@ void Scene::render(bool                clear_canvas,
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_camera_pos)) {
             shader_context->set_camera_pos(glm::value_ptr(m_camera->get_origin()));
         }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_deformer_origin) && mesh->get_deformer()) {
+            shader_context->set_deformer_origin(glm::value_ptr(mesh->get_deformer()->get_origin()));
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_deformer_params) && mesh->get_deformer()) {
+            shader_context->set_deformer_params(glm::value_ptr(mesh->get_deformer()->get_params()));
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_deformer_type)) {
+            shader_context->set_deformer_type(mesh->get_deformer() ? mesh->get_deformer()->get_type() : Deformer::DEFORMER_TYPE_NONE);
+        }
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_env_map_texture)) {
             shader_context->set_env_map_texture_index(0); // skymap texture index
         }
@@ -458,6 +494,15 @@ void Scene::render(bool                clear_canvas,
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_normal_transform)) {
             shader_context->set_normal_transform(mesh->get_normal_transform());
         }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_packed_vertices)) {
+            shader_context->set_packed_vertices(lod_mesh->is_compressed());
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_position_dequant_offset)) {
+            shader_context->set_position_dequant_offset(glm::value_ptr(lod_mesh->get_position_dequant_offset()));
+        }
+        if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_position_dequant_scale)) {
+            shader_context->set_position_dequant_scale(glm::value_ptr(lod_mesh->get_position_dequant_scale()));
+        }
         if(program->has_var(Program::VAR_TYPE_UNIFORM, Program::var_uniform_type_random_texture)) {
             shader_context->set_random_texture_index(material->get_texture_index_by_name("random_texture"));
         }
@@ -770,11 +815,15 @@ void Scene::draw_debug_lines(Mesh* mesh) const
 
     glLoadMatrixf(glm::value_ptr(m_camera->get_transform()));
 
-    for(std::vector<std::tuple<glm::vec3, glm::vec3, glm::vec3, float>>::const_iterator p = mesh->m_debug_lines.begin(); p != mesh->m_debug_lines.end(); ++p) {
-        glm::vec3 p1        = std::get<vt::Scene::DEBUG_LINE_P1>(*p);
-        glm::vec3 p2        = std::get<vt::Scene::DEBUG_LINE_P2>(*p);
-        glm::vec3 color     = std::get<vt::Scene::DEBUG_LINE_COLOR>(*p);
-        float     linewidth = std::get<vt::Scene::DEBUG_LINE_LINEWIDTH>(*p);
+    const DebugArena::debug_lines_t &debug_lines = DebugArena::instance()->get_debug_lines();
+    for(DebugArena::debug_lines_t::const_iterator p = debug_lines.begin(); p != debug_lines.end(); ++p) {
+        if((*p).first != mesh) {
+            continue;
+        }
+        glm::vec3 p1        = std::get<vt::Scene::DEBUG_LINE_P1>((*p).second);
+        glm::vec3 p2        = std::get<vt::Scene::DEBUG_LINE_P2>((*p).second);
+        glm::vec3 color     = std::get<vt::Scene::DEBUG_LINE_COLOR>((*p).second);
+        float     linewidth = std::get<vt::Scene::DEBUG_LINE_LINEWIDTH>((*p).second);
 
         glLineWidth(linewidth);
         glBegin(GL_LINES);
@@ -837,6 +886,11 @@ void Scene::draw_ik_guide_wires(Mesh* mesh) const
     const float target_dir_length           = 10 * up_arm_length; // cyan
     const float guide_wire_width            = 1;
 
+    const IKGuideWire* guide_wire = DebugArena::instance()->find_ik_guide_wire(mesh);
+    if(!guide_wire) {
+        return;
+    }
+
     glLoadMatrixf(glm::value_ptr(m_camera->get_transform() * mesh->get_parent()->get_transform()));
     glLineWidth(guide_wire_width);
     glBegin(GL_LINES);
@@ -846,7 +900,7 @@ void Scene::draw_ik_guide_wires(Mesh* mesh) const
         glColor3f(1, 0, 1);
         glm::vec3 origin(glm::vec4(mesh->get_origin(), 1));
         glVertex3fv(&origin.x);
-        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + mesh->m_debug_local_pivot * local_pivot_length, 1));
+        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + guide_wire->m_local_pivot * local_pivot_length, 1));
         glVertex3fv(&endpoint.x);
     }
 
@@ -855,7 +909,7 @@ void Scene::draw_ik_guide_wires(Mesh* mesh) const
         glColor3f(1, 1, 0);
         glm::vec3 origin(glm::vec4(mesh->get_origin(), 1));
         glVertex3fv(&origin.x);
-        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + mesh->m_debug_end_effector_tip_dir * end_effector_tip_dir_length, 1));
+        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + guide_wire->m_end_effector_tip_dir * end_effector_tip_dir_length, 1));
         glVertex3fv(&endpoint.x);
     }
 
@@ -864,7 +918,7 @@ void Scene::draw_ik_guide_wires(Mesh* mesh) const
         glColor3f(0, 1, 1);
         glm::vec3 origin(glm::vec4(mesh->get_origin(), 1));
         glVertex3fv(&origin.x);
-        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + mesh->m_debug_target_dir * target_dir_length, 1));
+        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + guide_wire->m_target_dir * target_dir_length, 1));
         glVertex3fv(&endpoint.x);
     }
 
@@ -873,7 +927,7 @@ void Scene::draw_ik_guide_wires(Mesh* mesh) const
         glColor3f(0, 0, 1);
         glm::vec3 origin(glm::vec4(mesh->get_origin(), 1));
         glVertex3fv(&origin.x);
-        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + mesh->m_debug_local_target, 1));
+        glm::vec3 endpoint(glm::vec4(mesh->get_origin() + guide_wire->m_local_target, 1));
         glVertex3fv(&endpoint.x);
     }
 
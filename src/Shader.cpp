@@ -20,16 +20,18 @@
 #include <GL/glew.h>
 #include <string>
 #include <iostream>
+#include <stdio.h>
 #include <assert.h>
 
 namespace vt {
 
-Shader::Shader(std::string filename, GLenum type)
+// NOTE: deferred shaders don't wait for the compile result, call check_compile_status() once it's needed
+Shader::Shader(std::string filename, GLenum type, bool deferred)
     : m_filename(filename),
       m_type(type)
 {
     std::cout << "Creating shader \"" << filename << "\"" << std::endl;
-    m_id = create_shader(filename.c_str(), type);
+    m_id = deferred ? create_shader_deferred(filename.c_str(), type) : create_shader(filename.c_str(), type);
     assert(m_id);
 }
 
@@ -38,4 +40,16 @@ Shader::~Shader()
     glDeleteShader(m_id);
 }
 
+bool Shader::check_compile_status() const
+{
+    GLint compile_ok = GL_FALSE;
+    glGetShaderiv(m_id, GL_COMPILE_STATUS, &compile_ok);
+    if(compile_ok == GL_FALSE) {
+        fprintf(stderr, "%s:", m_filename.c_str());
+        print_log(m_id);
+        return false;
+    }
+    return true;
+}
+
 }
@@ -25,11 +25,13 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
 #include <assert.h>
 
 #define NUM_LIGHTS        8
 //#define BLOOM_KERNEL_SIZE 5
 #define BLOOM_KERNEL_SIZE 7
+#define NUM_BONES         32
 
 namespace vt {
 
@@ -38,13 +40,25 @@ ShaderContext::ShaderContext(Material* material,
                              Buffer*   vbo_vert_normal,
                              Buffer*   vbo_vert_tangent,
                              Buffer*   vbo_tex_coords,
-                             Buffer*   ibo_tri_indices)
+                             Buffer*   ibo_tri_indices,
+                             Buffer*   vbo_bone_indices,
+                             Buffer*   vbo_bone_weights,
+                             Buffer*   vbo_packed_vert_coords,
+                             Buffer*   vbo_packed_vert_normal,
+                             Buffer*   vbo_packed_vert_tangent,
+                             Buffer*   vbo_packed_tex_coords)
     : m_material(material),
       m_vbo_vert_coords(vbo_vert_coords),
       m_vbo_vert_normal(vbo_vert_normal),
       m_vbo_vert_tangent(vbo_vert_tangent),
       m_vbo_tex_coords(vbo_tex_coords),
       m_ibo_tri_indices(ibo_tri_indices),
+      m_vbo_bone_indices(vbo_bone_indices),
+      m_vbo_bone_weights(vbo_bone_weights),
+      m_vbo_packed_vert_coords(vbo_packed_vert_coords),
+      m_vbo_packed_vert_normal(vbo_packed_vert_normal),
+      m_vbo_packed_vert_tangent(vbo_packed_vert_tangent),
+      m_vbo_packed_tex_coords(vbo_packed_tex_coords),
       m_textures(material->get_textures())
 {
     Program* program = material->get_program();
@@ -102,14 +116,16 @@ void ShaderContext::render()
         glEnable(GL_DEPTH_TEST);
         return;
     }
-    m_var_attributes[Program::var_attribute_type_vertex_position]->enable_vertex_attrib_array();
-    m_var_attributes[Program::var_attribute_type_vertex_position]->vertex_attrib_pointer(m_vbo_vert_coords,
-                                                                                         3,        // number of elements per vertex, here (x, y, z)
-                                                                                         GL_FLOAT, // the type of each element
-                                                                                         GL_FALSE, // take our values as-is
-                                                                                         0,        // no extra data between each position
-                                                                                         0);       // offset of first element
-    if(m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_vertex_normal)) {
+    if(m_vbo_vert_coords && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_vertex_position)) {
+        m_var_attributes[Program::var_attribute_type_vertex_position]->enable_vertex_attrib_array();
+        m_var_attributes[Program::var_attribute_type_vertex_position]->vertex_attrib_pointer(m_vbo_vert_coords,
+                                                                                             3,        // number of elements per vertex, here (x, y, z)
+                                                                                             GL_FLOAT, // the type of each element
+                                                                                             GL_FALSE, // take our values as-is
+                                                                                             0,        // no extra data between each position
+                                                                                             0);       // offset of first element
+    }
+    if(m_vbo_vert_normal && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_vertex_normal)) {
         m_var_attributes[Program::var_attribute_type_vertex_normal]->enable_vertex_attrib_array();
         m_var_attributes[Program::var_attribute_type_vertex_normal]->vertex_attrib_pointer(m_vbo_vert_normal,
                                                                                            3,        // number of elements per vertex, here (x, y, z)
@@ -118,7 +134,7 @@ void ShaderContext::render()
                                                                                            0,        // no extra data between each position
                                                                                            0);       // offset of first element
     }
-    if(m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_vertex_tangent)) {
+    if(m_vbo_vert_tangent && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_vertex_tangent)) {
         m_var_attributes[Program::var_attribute_type_vertex_tangent]->enable_vertex_attrib_array();
         m_var_attributes[Program::var_attribute_type_vertex_tangent]->vertex_attrib_pointer(m_vbo_vert_tangent,
                                                                                             3,        // number of elements per vertex, here (x, y, z)
@@ -127,7 +143,7 @@ void ShaderContext::render()
                                                                                             0,        // no extra data between each position
                                                                                             0);       // offset of first element
     }
-    if(m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_texcoord)) {
+    if(m_vbo_tex_coords && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_texcoord)) {
         m_var_attributes[Program::var_attribute_type_texcoord]->enable_vertex_attrib_array();
         m_var_attributes[Program::var_attribute_type_texcoord]->vertex_attrib_pointer(m_vbo_tex_coords,
                                                                                       2,        // number of elements per vertex, here (x, y)
@@ -136,6 +152,75 @@ void ShaderContext::render()
                                                                                       0,        // no extra data between each position
                                                                                       0);       // offset of first element
     }
+    if(m_vbo_packed_vert_coords && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_packed_position)) {
+        m_var_attributes[Program::var_attribute_type_packed_position]->enable_vertex_attrib_array();
+        m_var_attributes[Program::var_attribute_type_packed_position]->vertex_attrib_pointer(m_vbo_packed_vert_coords,
+                                                                                             4,        // number of elements per vertex, here (x, y, z, pad)
+                                                                                             GL_SHORT, // the type of each element
+                                                                                             GL_TRUE,  // map to [-1, 1]
+                                                                                             0,        // no extra data between each position
+                                                                                             0);       // offset of first element
+    }
+    if(m_vbo_packed_vert_normal && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_packed_normal)) {
+        m_var_attributes[Program::var_attribute_type_packed_normal]->enable_vertex_attrib_array();
+        m_var_attributes[Program::var_attribute_type_packed_normal]->vertex_attrib_pointer(m_vbo_packed_vert_normal,
+                                                                                           2,        // number of elements per vertex, here octahedral (u, v)
+                                                                                           GL_SHORT, // the type of each element
+                                                                                           GL_TRUE,  // map to [-1, 1]
+                                                                                           0,        // no extra data between each position
+                                                                                           0);       // offset of first element
+    }
+    if(m_vbo_packed_vert_tangent && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_packed_tangent)) {
+        m_var_attributes[Program::var_attribute_type_packed_tangent]->enable_vertex_attrib_array();
+        m_var_attributes[Program::var_attribute_type_packed_tangent]->vertex_attrib_pointer(m_vbo_packed_vert_tangent,
+                                                                                            2,        // number of elements per vertex, here octahedral (u, v)
+                                                                                            GL_SHORT, // the type of each element
+                                                                                            GL_TRUE,  // map to [-1, 1]
+                                                                                            0,        // no extra data between each position
+                                                                                            0);       // offset of first element
+    }
+    if(m_vbo_packed_tex_coords && m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_packed_texcoord)) {
+        m_var_attributes[Program::var_attribute_type_packed_texcoord]->enable_vertex_attrib_array();
+        m_var_attributes[Program::var_attribute_type_packed_texcoord]->vertex_attrib_pointer(m_vbo_packed_tex_coords,
+                                                                                             2,             // number of elements per vertex, here (x, y)
+                                                                                             GL_HALF_FLOAT, // the type of each element
+                                                                                             GL_FALSE,      // take our values as-is
+                                                                                             0,             // no extra data between each position
+                                                                                             0);            // offset of first element
+    }
+    if(m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_bone_indices)) {
+        if(m_vbo_bone_indices) {
+            m_var_attributes[Program::var_attribute_type_bone_indices]->enable_vertex_attrib_array();
+            m_var_attributes[Program::var_attribute_type_bone_indices]->vertex_attrib_pointer(m_vbo_bone_indices,
+                                                                                              4,        // number of elements per vertex, here (i0, i1, i2, i3)
+                                                                                              GL_FLOAT, // the type of each element
+                                                                                              GL_FALSE, // take our values as-is
+                                                                                              0,        // no extra data between each position
+                                                                                              0);       // offset of first element
+        } else {
+            m_var_attributes[Program::var_attribute_type_bone_indices]->vertex_attrib_4f(0, 0, 0, 0);
+        }
+    }
+    if(m_material->get_program()->has_var(Program::VAR_TYPE_ATTRIBUTE, Program::var_attribute_type_bone_weights)) {
+        if(m_vbo_bone_weights) {
+            m_var_attributes[Program::var_attribute_type_bone_weights]->enable_vertex_attrib_array();
+            m_var_attributes[Program::var_attribute_type_bone_weights]->vertex_attrib_pointer(m_vbo_bone_weights,
+                                                                                              4,        // number of elements per vertex, here (w0, w1, w2, w3)
+                                                                                              GL_FLOAT, // the type of each element
+                                                                                              GL_FALSE, // take our values as-is
+                                                                                              0,        // no extra data between each position
+                                                                                              0);       // offset of first element
+        } else {
+            m_var_attributes[Program::var_attribute_type_bone_weights]->vertex_attrib_4f(0, 0, 0, 0); // unskinned mesh stays in bind pose
+        }
+    }
+    // NOTE: pass shaders declare both float and packed attributes, the set this mesh didn't bind must not fetch from
+    //       arrays left enabled by another context
+    for(int i = 0; i < Program::var_attribute_type_count; i++) {
+        if(m_var_attributes[i] && !m_var_attributes[i]->is_enabled()) {
+            m_var_attributes[i]->disable_vertex_attrib_array();
+        }
+    }
     if(m_ibo_tri_indices) {
         m_ibo_tri_indices->bind();
         glDrawElements(GL_TRIANGLES, m_ibo_tri_indices->size()/sizeof(GLushort), GL_UNSIGNED_SHORT, 0);
@@ -169,6 +254,11 @@ void ShaderContext::set_bloom_kernel(const float* bloom_kernel_arr)
     m_var_uniforms[Program::var_uniform_type_bloom_kernel]->uniform_1fv(BLOOM_KERNEL_SIZE, bloom_kernel_arr);
 }
 
+void ShaderContext::set_bone_transforms(size_t num_bones, const float* bone_transforms_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_bone_transforms]->uniform_matrix_4fv(std::min(static_cast<int>(num_bones), NUM_BONES), GL_FALSE, bone_transforms_arr);
+}
+
 void ShaderContext::set_bump_texture_index(GLint texture_id)
 {
     assert(texture_id >= 0 && texture_id < static_cast<int>(m_textures.size()));
@@ -195,6 +285,21 @@ void ShaderContext::set_camera_pos(const float* camera_pos_arr)
     m_var_uniforms[Program::var_uniform_type_camera_pos]->uniform_3fv(1, camera_pos_arr);
 }
 
+void ShaderContext::set_deformer_origin(const float* deformer_origin_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_deformer_origin]->uniform_3fv(1, deformer_origin_arr);
+}
+
+void ShaderContext::set_deformer_params(const float* deformer_params_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_deformer_params]->uniform_4fv(1, deformer_params_arr);
+}
+
+void ShaderContext::set_deformer_type(GLint deformer_type)
+{
+    m_var_uniforms[Program::var_uniform_type_deformer_type]->uniform_1i(deformer_type);
+}
+
 void ShaderContext::set_env_map_texture_index(GLint texture_id)
 {
     assert(texture_id >= 0 && texture_id < static_cast<int>(m_textures.size()));
@@ -262,6 +367,21 @@ void ShaderContext::set_normal_transform(glm::mat4 normal_transform)
     m_var_uniforms[Program::var_uniform_type_normal_transform]->uniform_matrix_4fv(1, GL_FALSE, glm::value_ptr(normal_transform));
 }
 
+void ShaderContext::set_packed_vertices(bool packed_vertices)
+{
+    m_var_uniforms[Program::var_uniform_type_packed_vertices]->uniform_1i(packed_vertices);
+}
+
+void ShaderContext::set_position_dequant_offset(const float* position_dequant_offset_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_position_dequant_offset]->uniform_3fv(1, position_dequant_offset_arr);
+}
+
+void ShaderContext::set_position_dequant_scale(const float* position_dequant_scale_arr)
+{
+    m_var_uniforms[Program::var_uniform_type_position_dequant_scale]->uniform_3fv(1, position_dequant_scale_arr);
+}
+
 void ShaderContext::set_random_texture_index(GLint texture_id)
 {
     assert(texture_id >= 0 && texture_id < static_cast<int>(m_textures.size()));
@@ -0,0 +1,190 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include <StaticBatch.h>
+#include <Mesh.h>
+#include <Material.h>
+#include <Util.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <sstream>
+#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+#define MAX_BATCH_VERTEX 65536 // tri indices are 16-bit
+
+namespace vt {
+
+StaticBatch::StaticBatch(const std::string& name, Material* material)
+    : m_name(name),
+      m_material(material),
+      m_mesh(NULL),
+      m_num_vertex(0),
+      m_num_tri(0)
+{
+}
+
+// per-mesh uniforms the batch mesh copies from its first sub-mesh
+static bool has_same_mesh_uniforms(const Mesh* mesh, const Mesh* other)
+{
+    return mesh->is_smooth()                                 == other->is_smooth() &&
+           mesh->get_texture_index()                         == other->get_texture_index() &&
+           mesh->get_texture2_index()                        == other->get_texture2_index() &&
+           mesh->get_bump_texture_index()                    == other->get_bump_texture_index() &&
+           mesh->get_env_map_texture_index()                 == other->get_env_map_texture_index() &&
+           mesh->get_random_texture_index()                  == other->get_random_texture_index() &&
+           mesh->get_frontface_depth_overlay_texture_index() == other->get_frontface_depth_overlay_texture_index() &&
+           mesh->get_backface_depth_overlay_texture_index()  == other->get_backface_depth_overlay_texture_index() &&
+           mesh->get_backface_normal_overlay_texture_index() == other->get_backface_normal_overlay_texture_index() &&
+           mesh->get_reflect_to_refract_ratio()              == other->get_reflect_to_refract_ratio() &&
+           mesh->get_ambient_color()                         == other->get_ambient_color();
+}
+
+// NOTE: per-mesh uniforms (texture indices, reflect to refract ratio, ambient color) come from first sub-mesh, so all must match
+bool StaticBatch::can_add(const Mesh* mesh) const
+{
+    if(m_mesh || mesh->get_material() != m_material || mesh->is_skinned() || mesh->get_deformer() || mesh->get_num_lods()) {
+        return false;
+    }
+    if(!m_sub_meshes.empty() && !has_same_mesh_uniforms(mesh, m_sub_meshes[0].m_source)) {
+        return false;
+    }
+    return m_num_vertex + mesh->get_num_vertex() <= MAX_BATCH_VERTEX;
+}
+
+bool StaticBatch::add(Mesh* mesh)
+{
+    if(!can_add(mesh)) {
+        return false;
+    }
+    SubMesh sub_mesh;
+    sub_mesh.m_source       = mesh;
+    sub_mesh.m_first_vertex = m_num_vertex;
+    sub_mesh.m_num_vertex   = mesh->get_num_vertex();
+    sub_mesh.m_first_tri    = m_num_tri;
+    sub_mesh.m_num_tri      = mesh->get_num_tri();
+    sub_mesh.m_visible      = true;
+    m_sub_meshes.push_back(sub_mesh);
+    m_num_vertex += mesh->get_num_vertex();
+    m_num_tri    += mesh->get_num_tri();
+    return true;
+}
+
+// single pass: storage is sized up front, then each source is copied and baked into world space once
+Mesh* StaticBatch::build(bool hide_sources)
+{
+    if(m_mesh || m_sub_meshes.empty()) {
+        return m_mesh;
+    }
+    m_mesh = new Mesh(m_name, m_num_vertex, m_num_tri);
+    for(std::vector<SubMesh>::const_iterator p = m_sub_meshes.begin(); p != m_sub_meshes.end(); p++) {
+        Mesh* source = (*p).m_source;
+        m_mesh->copy_vertices(source, (*p).m_first_vertex, 0, (*p).m_num_vertex);
+        m_mesh->copy_tri_indices(source, (*p).m_first_tri, 0, (*p).m_num_tri, (*p).m_first_vertex);
+        glm::mat4  transform        = source->get_transform();
+        glm::mat4  normal_transform = source->get_normal_transform();
+        glm::vec3* vert_coords      = m_mesh->get_vert_coords()   + (*p).m_first_vertex;
+        glm::vec3* vert_normals     = m_mesh->get_vert_normals()  + (*p).m_first_vertex;
+        glm::vec3* vert_tangents    = m_mesh->get_vert_tangents() + (*p).m_first_vertex;
+        for(int i = 0; i < (*p).m_num_vertex; i++) {
+            vert_coords[i]   = glm::vec3(transform * glm::vec4(vert_coords[i], 1));
+            vert_normals[i]  = safe_normalize(glm::vec3(normal_transform * glm::vec4(vert_normals[i],  0)));
+            vert_tangents[i] = safe_normalize(glm::vec3(transform        * glm::vec4(vert_tangents[i], 0)));
+        }
+        if(hide_sources) {
+            source->set_visible(false);
+        }
+    }
+    Mesh* first = m_sub_meshes[0].m_source;
+    m_mesh->set_smooth(first->is_smooth());
+    m_mesh->set_material(m_material);
+    m_mesh->set_texture_index(first->get_texture_index());
+    m_mesh->set_texture2_index(first->get_texture2_index());
+    m_mesh->set_bump_texture_index(first->get_bump_texture_index());
+    m_mesh->set_env_map_texture_index(first->get_env_map_texture_index());
+    m_mesh->set_random_texture_index(first->get_random_texture_index());
+    m_mesh->set_frontface_depth_overlay_texture_index(first->get_frontface_depth_overlay_texture_index());
+    m_mesh->set_backface_depth_overlay_texture_index(first->get_backface_depth_overlay_texture_index());
+    m_mesh->set_backface_normal_overlay_texture_index(first->get_backface_normal_overlay_texture_index());
+    m_mesh->set_reflect_to_refract_ratio(first->get_reflect_to_refract_ratio());
+    m_mesh->set_ambient_color(first->get_ambient_color());
+    m_mesh->update_bbox();
+    m_tri_indices.assign(m_mesh->get_tri_indices(), m_mesh->get_tri_indices() + m_num_tri * 3);
+    return m_mesh;
+}
+
+int StaticBatch::find_sub_mesh(const Mesh* source) const
+{
+    for(int i = 0; i < static_cast<int>(m_sub_meshes.size()); i++) {
+        if(m_sub_meshes[i].m_source == source) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// NOTE: hidden sub-meshes collapse to degenerate triangles, so buffer sizes and draw call stay unchanged
+void StaticBatch::set_sub_mesh_visible(int index, bool visible)
+{
+    SubMesh &sub_mesh = m_sub_meshes[index];
+    if(!m_mesh || sub_mesh.m_visible == visible) {
+        return;
+    }
+    sub_mesh.m_visible = visible;
+    uint16_t* tri_indices = m_mesh->get_tri_indices() + sub_mesh.m_first_tri * 3;
+    int       count       = sub_mesh.m_num_tri * 3;
+    if(visible) {
+        memcpy(tri_indices, &m_tri_indices[sub_mesh.m_first_tri * 3], sizeof(uint16_t) * count);
+    } else {
+        for(int i = 0; i < count; i++) {
+            tri_indices[i] = sub_mesh.m_first_vertex;
+        }
+    }
+    m_mesh->update_buffers();
+}
+
+void build_static_batches(const std::vector<Mesh*> &meshes, std::vector<StaticBatch*>* batches, bool hide_sources)
+{
+    for(std::vector<Mesh*>::const_iterator p = meshes.begin(); p != meshes.end(); p++) {
+        Mesh* mesh = *p;
+        if(!mesh->get_material() || !mesh->is_visible()) {
+            continue;
+        }
+        // NOTE: same material may need several open batches (one per set of per-mesh uniforms)
+        bool added = false;
+        for(std::vector<StaticBatch*>::const_iterator q = batches->begin(); q != batches->end() && !added; q++) {
+            added = (*q)->add(mesh);
+        }
+        if(added) {
+            continue;
+        }
+        std::stringstream ss;
+        ss << "static_batch" << batches->size();
+        StaticBatch* batch = new StaticBatch(ss.str(), mesh->get_material());
+        if(!batch->add(mesh)) {
+            delete batch; // skinned, deformed, lod or too large
+            continue;
+        }
+        batches->push_back(batch);
+    }
+    for(std::vector<StaticBatch*>::const_iterator q = batches->begin(); q != batches->end(); q++) {
+        (*q)->build(hide_sources);
+    }
+}
+
+}
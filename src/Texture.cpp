@@ -23,17 +23,43 @@
 #include <glm/glm.hpp>
 #include <string>
 #include <iostream>
+#include <vector>
+#include <thread>
+#include <algorithm>
 #include <memory.h>
 #include <unistd.h>
 
+#define TEXTURE_BYTES_PER_PIXEL  4 // rgba8, r32f and depth (as float) are all 4 bytes
+#define TEXTURE_FENCE_TIMEOUT_NS 1000000
+
 namespace vt {
 
+static GLenum get_gl_compressed_format(Texture::compressed_format_t compressed_format)
+{
+    switch(compressed_format) {
+        case Texture::BC1: return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        case Texture::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case Texture::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
+        default:
+            break;
+    }
+    return 0;
+}
+
+static const GLenum cube_map_targets[6] = {GL_TEXTURE_CUBE_MAP_POSITIVE_X,
+                                           GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
+                                           GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
+                                           GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
+                                           GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
+                                           GL_TEXTURE_CUBE_MAP_NEGATIVE_Z};
+
 Texture::Texture(const std::string&         name,
                        format_t             internal_format,
                        glm::ivec2           dim,
                        bool                 smooth,
                        format_t             format,
-                       const unsigned char* pixels)
+                       const unsigned char* pixels,
+                       bool                 mipmap)
     : NamedObject(name),
       FrameObject(glm::ivec2(0), dim),
       m_skybox(false),
@@ -44,7 +70,14 @@ Texture::Texture(const std::string&         name,
       m_pixels_pos_y(NULL),
       m_pixels_neg_y(NULL),
       m_pixels_pos_z(NULL),
-      m_pixels_neg_z(NULL)
+      m_pixels_neg_z(NULL),
+      m_num_levels(1),
+      m_compressed(false),
+      m_dirty_min(0),
+      m_dirty_max(0),
+      m_unpack_pbo(0),
+      m_pack_pbo(0),
+      m_pack_fence(NULL)
 {
     unsigned char* dest_pixels = NULL;
     if(format == RGB && pixels) {
@@ -60,7 +93,7 @@ Texture::Texture(const std::string&         name,
                 dest_pixels[dest_pixel_offset + 0] = pixels[src_pixel_offset + 0];
                 dest_pixels[dest_pixel_offset + 1] = pixels[src_pixel_offset + 1];
                 dest_pixels[dest_pixel_offset + 2] = pixels[src_pixel_offset + 2];
-                dest_pixels[dest_pixel_offset + 3] = 1;
+                dest_pixels[dest_pixel_offset + 3] = 255;
             }
         }
     } else {
@@ -69,7 +102,8 @@ Texture::Texture(const std::string&         name,
     alloc(internal_format,
           dim,
           smooth,
-          dest_pixels);
+          dest_pixels,
+          mipmap);
     if(pixels) {
         return;
     }
@@ -90,7 +124,14 @@ Texture::Texture(const std::string& name,
       m_pixels_pos_y(NULL),
       m_pixels_neg_y(NULL),
       m_pixels_pos_z(NULL),
-      m_pixels_neg_z(NULL)
+      m_pixels_neg_z(NULL),
+      m_num_levels(1),
+      m_compressed(false),
+      m_dirty_min(0),
+      m_dirty_max(0),
+      m_unpack_pbo(0),
+      m_pack_pbo(0),
+      m_pack_fence(NULL)
 {
     unsigned char* pixels = NULL;
     size_t width  = 0;
@@ -101,7 +142,8 @@ Texture::Texture(const std::string& name,
     alloc(Texture::RGBA,
           glm::ivec2(width, height),
           smooth,
-          pixels);
+          pixels,
+          smooth); // mipmap
     if(!pixels) {
         return;
     }
@@ -125,7 +167,14 @@ Texture::Texture(const std::string& name,
       m_pixels_pos_y(NULL),
       m_pixels_neg_y(NULL),
       m_pixels_pos_z(NULL),
-      m_pixels_neg_z(NULL)
+      m_pixels_neg_z(NULL),
+      m_num_levels(1),
+      m_compressed(false),
+      m_dirty_min(0),
+      m_dirty_max(0),
+      m_unpack_pbo(0),
+      m_pack_pbo(0),
+      m_pack_fence(NULL)
 {
     if(png_filename_pos_x.empty() ||
        png_filename_neg_x.empty() ||
@@ -145,51 +194,181 @@ Texture::Texture(const std::string& name,
     {
         return;
     }
-    size_t width  = 0;
-    size_t height = 0;
-    unsigned char* pixels_pos_x = NULL;
-    unsigned char* pixels_neg_x = NULL;
-    unsigned char* pixels_pos_y = NULL;
-    unsigned char* pixels_neg_y = NULL;
-    unsigned char* pixels_pos_z = NULL;
-    unsigned char* pixels_neg_z = NULL;
-    if(!read_png(png_filename_pos_x, (void**)&pixels_pos_x, &width, &height) || !pixels_pos_x) {
-        std::cout << "failed to load cube map positive x" << std::endl;
-        return;
-    }
-    if(!read_png(png_filename_neg_x, (void**)&pixels_neg_x, &width, &height) || !pixels_neg_x) {
-        std::cout << "failed to load cube map negative x" << std::endl;
-        return;
+    // NOTE: faces decode in parallel, one thread per face
+    const std::string png_filenames[6] = {png_filename_pos_x,
+                                          png_filename_neg_x,
+                                          png_filename_pos_y,
+                                          png_filename_neg_y,
+                                          png_filename_pos_z,
+                                          png_filename_neg_z};
+    unsigned char* pixels[6]  = {};
+    size_t         widths[6]  = {};
+    size_t         heights[6] = {};
+    bool           results[6] = {};
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 6; i++) {
+        threads.push_back(std::thread([&, i]() {
+            results[i] = read_png(png_filenames[i], (void**)&pixels[i], &widths[i], &heights[i]) && pixels[i];
+        }));
     }
-    if(!read_png(png_filename_pos_y, (void**)&pixels_pos_y, &width, &height) || !pixels_pos_y) {
-        std::cout << "failed to load cube map positive y" << std::endl;
-        return;
+    for(int i = 0; i < 6; i++) {
+        threads[i].join();
     }
-    if(!read_png(png_filename_neg_y, (void**)&pixels_neg_y, &width, &height) || !pixels_neg_y) {
-        std::cout << "failed to load cube map negative y" << std::endl;
-        return;
+    static const char* face_names[6] = {"positive x",
+                                        "negative x",
+                                        "positive y",
+                                        "negative y",
+                                        "positive z",
+                                        "negative z"};
+    bool success = true;
+    for(int i = 0; i < 6; i++) {
+        if(!results[i]) {
+            std::cout << "failed to load cube map " << face_names[i] << std::endl;
+            success = false;
+        } else if(widths[i] != widths[0] || heights[i] != heights[0]) {
+            std::cout << "cube map " << face_names[i] << " size mismatch" << std::endl;
+            success = false;
+        }
     }
-    if(!read_png(png_filename_pos_z, (void**)&pixels_pos_z, &width, &height) || !pixels_pos_z) {
-        std::cout << "failed to load cube map positive z" << std::endl;
-        return;
+    if(success) {
+        alloc(glm::ivec2(widths[0], heights[0]),
+              pixels[0],
+              pixels[1],
+              pixels[2],
+              pixels[3],
+              pixels[4],
+              pixels[5],
+              true); // mipmap
     }
-    if(!read_png(png_filename_neg_z, (void**)&pixels_neg_z, &width, &height) || !pixels_neg_z) {
-        std::cout << "failed to load cube map negative z" << std::endl;
-        return;
+    for(int i = 0; i < 6; i++) {
+        if(pixels[i]) {
+            delete[] pixels[i];
+        }
     }
-    alloc(glm::ivec2(width, height),
+}
+
+Texture::Texture(const std::string&   name,
+                       glm::ivec2     dim,
+                 const unsigned char* pixels_pos_x,
+                 const unsigned char* pixels_neg_x,
+                 const unsigned char* pixels_pos_y,
+                 const unsigned char* pixels_neg_y,
+                 const unsigned char* pixels_pos_z,
+                 const unsigned char* pixels_neg_z,
+                       bool           mipmap)
+    : NamedObject(name),
+      FrameObject(glm::ivec2(0), glm::ivec2(0)),
+      m_skybox(true),
+      m_internal_format(Texture::RGBA),
+      m_pixels(NULL),
+      m_pixels_pos_x(NULL),
+      m_pixels_neg_x(NULL),
+      m_pixels_pos_y(NULL),
+      m_pixels_neg_y(NULL),
+      m_pixels_pos_z(NULL),
+      m_pixels_neg_z(NULL),
+      m_num_levels(1),
+      m_compressed(false),
+      m_dirty_min(0),
+      m_dirty_max(0),
+      m_unpack_pbo(0),
+      m_pack_pbo(0),
+      m_pack_fence(NULL)
+{
+    alloc(dim,
           pixels_pos_x,
           pixels_neg_x,
           pixels_pos_y,
           pixels_neg_y,
           pixels_pos_z,
-          pixels_neg_z);
-    delete[] pixels_pos_x;
-    delete[] pixels_neg_x;
-    delete[] pixels_pos_y;
-    delete[] pixels_neg_y;
-    delete[] pixels_pos_z;
-    delete[] pixels_neg_z;
+          pixels_neg_z,
+          mipmap);
+}
+
+// NOTE: face_data holds each face's level chain back to back (level 0 first), no cpu copy is kept
+Texture::Texture(const std::string&          name,
+                       compressed_format_t   compressed_format,
+                       glm::ivec2            dim,
+                       int                   num_levels,
+                       int                   num_faces,
+                 const unsigned char* const* face_data)
+    : NamedObject(name),
+      FrameObject(glm::ivec2(0), dim),
+      m_skybox(num_faces == 6),
+      m_internal_format(Texture::RGBA),
+      m_pixels(NULL),
+      m_pixels_pos_x(NULL),
+      m_pixels_neg_x(NULL),
+      m_pixels_pos_y(NULL),
+      m_pixels_neg_y(NULL),
+      m_pixels_pos_z(NULL),
+      m_pixels_neg_z(NULL),
+      m_num_levels(std::max(num_levels, 1)),
+      m_compressed(true),
+      m_dirty_min(0),
+      m_dirty_max(0),
+      m_unpack_pbo(0),
+      m_pack_pbo(0),
+      m_pack_fence(NULL)
+{
+    if((num_faces != 1 && num_faces != 6) || !face_data) {
+        return;
+    }
+    if(!is_compressed_format_supported(compressed_format)) {
+        std::cout << "compressed texture format not supported" << std::endl;
+        return;
+    }
+    glGenTextures(1, &m_id);
+    if(!m_id) {
+        return;
+    }
+    GLenum target = m_skybox ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    glBindTexture(target, m_id);
+    glTexParameteri(target, GL_TEXTURE_MIN_FILTER, (m_num_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, m_num_levels - 1);
+    glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(target, GL_TEXTURE_WRAP_S, m_skybox ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    glTexParameteri(target, GL_TEXTURE_WRAP_T, m_skybox ? GL_CLAMP_TO_EDGE : GL_REPEAT);
+    if(m_skybox) {
+        glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    }
+    GLenum gl_compressed_format = get_gl_compressed_format(compressed_format);
+    if(GLEW_ARB_texture_storage) {
+        glTexStorage2D(target, m_num_levels, gl_compressed_format, dim.x, dim.y);
+    }
+    for(int i = 0; i < num_faces; i++) {
+        int face = (m_skybox && (i == 2 || i == 3)) ? (5 - i) : i; // y faces are swapped, same as get_face_pixels()
+        if(!face_data[face]) {
+            continue;
+        }
+        GLenum face_target = m_skybox ? cube_map_targets[i] : GL_TEXTURE_2D;
+        const unsigned char* level_data = face_data[face];
+        for(int level = 0; level < m_num_levels; level++) {
+            glm::ivec2 level_dim  = glm::max(dim >> level, glm::ivec2(1));
+            size_t     level_size = get_compressed_size(compressed_format, level_dim);
+            if(GLEW_ARB_texture_storage) {
+                glCompressedTexSubImage2D(face_target,          // target
+                                          level,                // level
+                                          0,                    // x offset
+                                          0,                    // y offset
+                                          level_dim.x,          // width
+                                          level_dim.y,          // height
+                                          gl_compressed_format, // format
+                                          level_size,           // image size
+                                          level_data);
+            } else {
+                glCompressedTexImage2D(face_target,          // target
+                                       level,                // level
+                                       gl_compressed_format, // internal format
+                                       level_dim.x,          // width
+                                       level_dim.y,          // height
+                                       0,                    // border, always 0 in OpenGL ES
+                                       level_size,           // image size
+                                       level_data);
+            }
+            level_data += level_size;
+        }
+    }
 }
 
 Texture::~Texture()
@@ -198,6 +377,15 @@ Texture::~Texture()
         return;
     }
     glDeleteTextures(1, &m_id);
+    if(m_unpack_pbo) {
+        glDeleteBuffers(1, &m_unpack_pbo);
+    }
+    if(m_pack_pbo) {
+        glDeleteBuffers(1, &m_pack_pbo);
+    }
+    if(m_pack_fence) {
+        glDeleteSync(m_pack_fence);
+    }
     if(m_skybox) {
         if(!m_pixels_pos_x ||
            !m_pixels_neg_x ||
@@ -241,14 +429,17 @@ void Texture::bind()
 void Texture::alloc(format_t    internal_format,
                     glm::ivec2  dim,
                     bool        smooth,
-                    const void* pixels)
+                    const void* pixels,
+                    bool        mipmap)
 {
     glGenTextures(1, &m_id);
     if(!m_id) {
         return;
     }
+    m_num_levels = (mipmap && internal_format == Texture::RGBA) ? get_num_mip_levels(dim) : 1;
     glBindTexture(GL_TEXTURE_2D, m_id);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (m_num_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_num_levels - 1);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, smooth ? GL_LINEAR : GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -260,12 +451,10 @@ void Texture::alloc(format_t    internal_format,
     if(!m_pixels) {
         return;
     }
-    if(!pixels) {
-        update();
-        return;
+    if(pixels) {
+        memcpy(m_pixels, pixels, size_buf);
     }
-    memcpy(m_pixels, pixels, size_buf);
-    update();
+    alloc_storage();
 }
 
 void Texture::alloc(glm::ivec2  dim,
@@ -274,14 +463,17 @@ void Texture::alloc(glm::ivec2  dim,
                     const void* pixels_pos_y,
                     const void* pixels_neg_y,
                     const void* pixels_pos_z,
-                    const void* pixels_neg_z)
+                    const void* pixels_neg_z,
+                    bool        mipmap)
 {
     glGenTextures(1, &m_id);
     if(!m_id) {
         return;
     }
+    m_num_levels = mipmap ? get_num_mip_levels(dim) : 1;
     glBindTexture(GL_TEXTURE_CUBE_MAP, m_id);
-    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, (m_num_levels > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL, m_num_levels - 1);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
@@ -312,7 +504,7 @@ void Texture::alloc(glm::ivec2  dim,
        !pixels_pos_z   ||
        !pixels_neg_z)
     {
-        update();
+        alloc_storage();
         return;
     }
     memcpy(m_pixels_pos_x, pixels_pos_x, size_buf);
@@ -321,7 +513,7 @@ void Texture::alloc(glm::ivec2  dim,
     memcpy(m_pixels_neg_y, pixels_neg_y, size_buf);
     memcpy(m_pixels_pos_z, pixels_pos_z, size_buf);
     memcpy(m_pixels_neg_z, pixels_neg_z, size_buf);
-    update();
+    alloc_storage();
 }
 
 size_t Texture::size() const
@@ -340,6 +532,93 @@ size_t Texture::size() const
     return 0;
 }
 
+int Texture::get_num_mip_levels(glm::ivec2 dim)
+{
+    int num_levels = 1;
+    for(int max_dim = std::max(dim.x, dim.y); max_dim > 1; max_dim >>= 1) {
+        num_levels++;
+    }
+    return num_levels;
+}
+
+// NOTE: 2x2 box filter on rgba8, odd edges clamp so 1-pixel-wide levels still average correctly
+void Texture::downsample(const unsigned char* src_pixels,
+                               glm::ivec2     src_dim,
+                               unsigned char* dest_pixels)
+{
+    glm::ivec2 dest_dim = glm::max(src_dim >> 1, glm::ivec2(1));
+    for(int y = 0; y < dest_dim.y; y++) {
+        int y0 = std::min(y * 2,     src_dim.y - 1);
+        int y1 = std::min(y * 2 + 1, src_dim.y - 1);
+        for(int x = 0; x < dest_dim.x; x++) {
+            int x0 = std::min(x * 2,     src_dim.x - 1);
+            int x1 = std::min(x * 2 + 1, src_dim.x - 1);
+            const unsigned char* p00 = &src_pixels[(y0 * src_dim.x + x0) * TEXTURE_BYTES_PER_PIXEL];
+            const unsigned char* p01 = &src_pixels[(y0 * src_dim.x + x1) * TEXTURE_BYTES_PER_PIXEL];
+            const unsigned char* p10 = &src_pixels[(y1 * src_dim.x + x0) * TEXTURE_BYTES_PER_PIXEL];
+            const unsigned char* p11 = &src_pixels[(y1 * src_dim.x + x1) * TEXTURE_BYTES_PER_PIXEL];
+            unsigned char* dest_pixel = &dest_pixels[(y * dest_dim.x + x) * TEXTURE_BYTES_PER_PIXEL];
+            for(int c = 0; c < TEXTURE_BYTES_PER_PIXEL; c++) {
+                dest_pixel[c] = (p00[c] + p01[c] + p10[c] + p11[c] + 2) >> 2;
+            }
+        }
+    }
+}
+
+size_t Texture::get_compressed_size(compressed_format_t compressed_format,
+                                    glm::ivec2          dim,
+                                    int                 num_levels)
+{
+    size_t block_size = (compressed_format == Texture::BC1) ? 8 : 16;
+    size_t total_size = 0;
+    for(int level = 0; level < num_levels; level++) {
+        glm::ivec2 level_dim  = glm::max(dim >> level, glm::ivec2(1));
+        glm::ivec2 num_blocks = (level_dim + glm::ivec2(COMPRESSED_BLOCK_DIM - 1)) / COMPRESSED_BLOCK_DIM;
+        total_size += num_blocks.x * num_blocks.y * block_size;
+    }
+    return total_size;
+}
+
+bool Texture::is_compressed_format_supported(compressed_format_t compressed_format)
+{
+    switch(compressed_format) {
+        case Texture::BC1:
+        case Texture::BC3: return GLEW_EXT_texture_compression_s3tc;
+        case Texture::BC7: return GLEW_ARB_texture_compression_bptc;
+        default:
+            break;
+    }
+    return false;
+}
+
+// NOTE: storage is immutable, so only same-sized rgba replacements are accepted
+bool Texture::replace_pixels(const unsigned char* pixels, glm::ivec2 dim, int face)
+{
+    if(!pixels || m_compressed || m_internal_format != Texture::RGBA) {
+        return false;
+    }
+    if(dim != m_dim) {
+        std::cout << "texture " << get_name() << " changed size, restart to reload" << std::endl;
+        return false;
+    }
+    unsigned char* dest_pixels = m_pixels;
+    if(m_skybox) {
+        unsigned char* face_pixels[6] = {m_pixels_pos_x,
+                                         m_pixels_neg_x,
+                                         m_pixels_pos_y,
+                                         m_pixels_neg_y,
+                                         m_pixels_pos_z,
+                                         m_pixels_neg_z};
+        dest_pixels = (face >= 0 && face < 6) ? face_pixels[face] : NULL;
+    }
+    if(!dest_pixels) {
+        return false;
+    }
+    memcpy(dest_pixels, pixels, size());
+    update_async();
+    return true;
+}
+
 // NOTE: (warning) The class 'Texture' has 'operator=' but lack of 'copy constructor'.
 #if 1
 Texture& Texture::operator=(Texture& other)
@@ -374,6 +653,7 @@ void Texture::randomize(bool binary)
                 for(int i = 0; i < static_cast<int>(size_buf); i++) {
                     m_pixels[i] = rand() % 256;
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         case Texture::RED:
@@ -384,6 +664,7 @@ void Texture::randomize(bool binary)
                 for(int i = 0; i < static_cast<int>(n); i++) {
                     pixels[i] = (static_cast<float>(rand()) / RAND_MAX) > 0.5;
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         default:
@@ -412,6 +693,7 @@ void Texture::draw_x()
                         m_pixels[pixel_offset2 + c] = 255;
                     }
                 }
+                mark_dirty(glm::ivec2(0), glm::ivec2(m_dim.x, min_dim));
             }
             break;
         case Texture::RED:
@@ -423,6 +705,7 @@ void Texture::draw_x()
                     pixels[i * m_dim.x + i]                 = 1;
                     pixels[i * m_dim.x + (m_dim.x - 1 - i)] = 1;
                 }
+                mark_dirty(glm::ivec2(0), glm::ivec2(m_dim.x, min_dim));
             }
             break;
         default:
@@ -458,6 +741,7 @@ void Texture::draw_frame()
                         m_pixels[pixel_offset_right + c] = 255;
                     }
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         case Texture::RED:
@@ -476,6 +760,7 @@ void Texture::draw_frame()
                     pixels[pixel_offset_left]  = 1;
                     pixels[pixel_offset_right] = 1;
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         default:
@@ -510,6 +795,7 @@ void Texture::set_pixel(glm::ivec2 pos, glm::ivec4 color)
     m_pixels[pixel_offset + 1] = color.g;
     m_pixels[pixel_offset + 2] = color.b;
     m_pixels[pixel_offset + 3] = color.a;
+    mark_dirty(pos, glm::ivec2(1));
 }
 
 void Texture::set_color(glm::ivec4 color)
@@ -530,6 +816,7 @@ void Texture::set_color(glm::ivec4 color)
                     m_pixels[i + 2] = color.b;
                     m_pixels[i + 3] = color.a;
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         default:
@@ -558,6 +845,7 @@ void Texture::set_pixel_r32f(glm::ivec2 pos, float color)
     }
     int pixel_offset = (pos.y * m_dim.x + pos.x) * 4;
     *reinterpret_cast<float*>(&(m_pixels[pixel_offset + 0])) = color;
+    mark_dirty(pos, glm::ivec2(1));
 }
 
 void Texture::set_color_r32f(float color)
@@ -576,6 +864,7 @@ void Texture::set_color_r32f(float color)
                 for(int i = 0; i < static_cast<int>(n); i++) {
                     pixels[i] = color;
                 }
+                mark_dirty(glm::ivec2(0), m_dim);
             }
             break;
         default:
@@ -588,95 +877,58 @@ void Texture::set_color_r32f(float color)
 // core functionality
 //===================
 
-// NOTE: upload to gpu
-void Texture::update()
+// NOTE: allocate once, later updates only replace contents (immutable storage where supported)
+void Texture::alloc_storage()
 {
-    bind();
     if(m_skybox) {
-        if(!m_pixels_pos_x ||
-           !m_pixels_neg_x ||
-           !m_pixels_pos_y ||
-           !m_pixels_neg_y ||
-           !m_pixels_pos_z ||
-           !m_pixels_neg_z)
-        {
-            return;
+        if(GLEW_ARB_texture_storage) {
+            glTexStorage2D(GL_TEXTURE_CUBE_MAP, m_num_levels, GL_RGBA8, m_dim.x, m_dim.y);
+        } else {
+            for(int i = 0; i < 6; i++) {
+                for(int level = 0; level < m_num_levels; level++) {
+                    glm::ivec2 level_dim = glm::max(m_dim >> level, glm::ivec2(1));
+                    glTexImage2D(cube_map_targets[i], // target
+                                 level,               // level
+                                 GL_RGBA,             // internal format
+                                 level_dim.x,         // width
+                                 level_dim.y,         // height
+                                 0,                   // border, always 0 in OpenGL ES
+                                 GL_RGBA,             // format
+                                 GL_UNSIGNED_BYTE,    // type
+                                 NULL);
+                }
+            }
         }
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_pos_x);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_neg_x);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_neg_y);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_pos_y);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_pos_z);
-        glTexImage2D(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, // target
-                     0,                              // level, 0 = base, no mipmap,
-                     GL_RGBA,                        // internal format
-                     m_dim.x,                        // width
-                     m_dim.y,                        // height
-                     0,                              // border, always 0 in OpenGL ES
-                     GL_RGBA,                        // format
-                     GL_UNSIGNED_BYTE,               // type
-                     m_pixels_neg_z);
-        return;
-    }
-    if(!m_pixels) {
+        update_async();
         return;
     }
     switch(m_internal_format) {
         case Texture::RGBA:
-            glTexImage2D(GL_TEXTURE_2D,    // target
-                         0,                // level, 0 = base, no mipmap,
-                         GL_RGBA,          // internal format
-                         m_dim.x,          // width
-                         m_dim.y,          // height
-                         0,                // border, always 0 in OpenGL ES
-                         GL_RGBA,          // format
-                         GL_UNSIGNED_BYTE, // type
-                         m_pixels);
+            if(GLEW_ARB_texture_storage) {
+                glTexStorage2D(GL_TEXTURE_2D, m_num_levels, GL_RGBA8, m_dim.x, m_dim.y);
+                break;
+            }
+            for(int level = 0; level < m_num_levels; level++) {
+                glm::ivec2 level_dim = glm::max(m_dim >> level, glm::ivec2(1));
+                glTexImage2D(GL_TEXTURE_2D,    // target
+                             level,            // level
+                             GL_RGBA,          // internal format
+                             level_dim.x,      // width
+                             level_dim.y,      // height
+                             0,                // border, always 0 in OpenGL ES
+                             GL_RGBA,          // format
+                             GL_UNSIGNED_BYTE, // type
+                             NULL);
+            }
             break;
         case Texture::RGB:
             assert(false);
             break;
         case Texture::RED:
+            if(GLEW_ARB_texture_storage) {
+                glTexStorage2D(GL_TEXTURE_2D, 1, GL_R32F, m_dim.x, m_dim.y);
+                break;
+            }
             glTexImage2D(GL_TEXTURE_2D, // target
                          0,             // level, 0 = base, no mipmap,
                          GL_R32F,       // internal format
@@ -685,9 +937,10 @@ void Texture::update()
                          0,             // border, always 0 in OpenGL ES
                          GL_RED,        // format
                          GL_FLOAT,      // type
-                         m_pixels);
+                         NULL);
             break;
         case Texture::DEPTH:
+            // NOTE: depth keeps unsized mutable storage, sized depth formats need different ssao tuning
             glTexImage2D(GL_TEXTURE_2D,      // target
                          0,                  // level, 0 = base, no mipmap,
 #if 0
@@ -701,10 +954,229 @@ void Texture::update()
                          GL_DEPTH_COMPONENT, // format
                          GL_FLOAT,           // type
                          m_pixels);
+            clear_dirty();
+            return;
+        default:
             break;
+    }
+    update();
+}
+
+// NOTE: cube map faces in upload order (y faces are swapped to match skybox orientation)
+unsigned char* Texture::get_face_pixels(int face) const
+{
+    switch(face) {
+        case 0: return m_pixels_pos_x;
+        case 1: return m_pixels_neg_x;
+        case 2: return m_pixels_neg_y;
+        case 3: return m_pixels_pos_y;
+        case 4: return m_pixels_pos_z;
+        case 5: return m_pixels_neg_z;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+GLenum Texture::get_gl_format() const
+{
+    switch(m_internal_format) {
+        case Texture::RGBA:  return GL_RGBA;
+        case Texture::RED:   return GL_RED;
+        case Texture::DEPTH: return GL_DEPTH_COMPONENT;
         default:
             break;
     }
+    return GL_RGBA;
+}
+
+GLenum Texture::get_gl_type() const
+{
+    switch(m_internal_format) {
+        case Texture::RGBA:  return GL_UNSIGNED_BYTE;
+        case Texture::RED:   return GL_FLOAT;
+        case Texture::DEPTH: return GL_FLOAT;
+        default:
+            break;
+    }
+    return GL_UNSIGNED_BYTE;
+}
+
+void Texture::mark_dirty(glm::ivec2 pos, glm::ivec2 dim)
+{
+    glm::ivec2 dirty_min = glm::max(pos, glm::ivec2(0));
+    glm::ivec2 dirty_max = glm::min(pos + dim, m_dim);
+    if(dirty_min.x >= dirty_max.x || dirty_min.y >= dirty_max.y) {
+        return;
+    }
+    if(m_dirty_min.x >= m_dirty_max.x || m_dirty_min.y >= m_dirty_max.y) {
+        m_dirty_min = dirty_min;
+        m_dirty_max = dirty_max;
+        return;
+    }
+    m_dirty_min = glm::min(m_dirty_min, dirty_min);
+    m_dirty_max = glm::max(m_dirty_max, dirty_max);
+}
+
+void Texture::clear_dirty()
+{
+    m_dirty_min = m_dirty_max = glm::ivec2(0);
+}
+
+// NOTE: rebuilds levels 1..n from level 0, on the gpu where possible, else with a cpu box filter
+void Texture::update_mipmaps()
+{
+    if(m_num_levels <= 1 || m_compressed) {
+        return;
+    }
+    GLenum target = m_skybox ? GL_TEXTURE_CUBE_MAP : GL_TEXTURE_2D;
+    if(GLEW_VERSION_3_0 || GLEW_ARB_framebuffer_object) {
+        glGenerateMipmap(target);
+        return;
+    }
+    size_t size_buf = size();
+    unsigned char* src_pixels  = new unsigned char[size_buf];
+    unsigned char* dest_pixels = new unsigned char[size_buf];
+    if(!src_pixels || !dest_pixels) {
+        return;
+    }
+    int num_faces = m_skybox ? 6 : 1;
+    for(int i = 0; i < num_faces; i++) {
+        const unsigned char* face_pixels = m_skybox ? get_face_pixels(i) : m_pixels;
+        if(!face_pixels) {
+            continue;
+        }
+        memcpy(src_pixels, face_pixels, size_buf);
+        glm::ivec2 level_dim = m_dim;
+        for(int level = 1; level < m_num_levels; level++) {
+            downsample(src_pixels, level_dim, dest_pixels);
+            level_dim = glm::max(level_dim >> 1, glm::ivec2(1));
+            glTexSubImage2D(m_skybox ? cube_map_targets[i] : GL_TEXTURE_2D,
+                            level,
+                            0,
+                            0,
+                            level_dim.x,
+                            level_dim.y,
+                            GL_RGBA,
+                            GL_UNSIGNED_BYTE,
+                            dest_pixels);
+            std::swap(src_pixels, dest_pixels);
+        }
+    }
+    delete[] src_pixels;
+    delete[] dest_pixels;
+}
+
+// NOTE: upload to gpu
+void Texture::update()
+{
+    if(m_skybox) {
+        if(!m_pixels_pos_x ||
+           !m_pixels_neg_x ||
+           !m_pixels_pos_y ||
+           !m_pixels_neg_y ||
+           !m_pixels_pos_z ||
+           !m_pixels_neg_z)
+        {
+            return;
+        }
+        bind();
+        for(int i = 0; i < 6; i++) {
+            glTexSubImage2D(cube_map_targets[i], 0, 0, 0, m_dim.x, m_dim.y, GL_RGBA, GL_UNSIGNED_BYTE, get_face_pixels(i));
+        }
+        update_mipmaps();
+        return;
+    }
+    update(glm::ivec2(0), m_dim);
+}
+
+// NOTE: upload sub-rectangle to gpu, rows are read in place from cpu pixels
+void Texture::update(glm::ivec2 pos, glm::ivec2 dim)
+{
+    if(m_skybox) {
+        return;
+    }
+    if(!m_pixels) {
+        return;
+    }
+    pos = glm::max(pos, glm::ivec2(0));
+    dim = glm::min(pos + dim, m_dim) - pos;
+    if(dim.x <= 0 || dim.y <= 0) {
+        return;
+    }
+    bind();
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, m_dim.x);
+    glTexSubImage2D(GL_TEXTURE_2D,   // target
+                    0,               // level, 0 = base, no mipmap,
+                    pos.x,           // x offset
+                    pos.y,           // y offset
+                    dim.x,           // width
+                    dim.y,           // height
+                    get_gl_format(), // format
+                    get_gl_type(),   // type
+                    &m_pixels[(pos.y * m_dim.x + pos.x) * TEXTURE_BYTES_PER_PIXEL]);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    update_mipmaps();
+    if(pos == glm::ivec2(0) && dim == m_dim) {
+        clear_dirty();
+    }
+}
+
+// NOTE: upload only what modifiers touched since the last upload
+void Texture::update_dirty()
+{
+    if(m_dirty_min.x >= m_dirty_max.x || m_dirty_min.y >= m_dirty_max.y) {
+        return;
+    }
+    update(m_dirty_min, m_dirty_max - m_dirty_min);
+    clear_dirty();
+}
+
+// NOTE: stages pixels in an orphaned unpack pbo, so the upload doesn't wait on the gpu still reading the previous one
+void Texture::update_async()
+{
+    if(!GLEW_ARB_pixel_buffer_object) {
+        update();
+        return;
+    }
+    int num_faces = m_skybox ? 6 : 1;
+    for(int i = 0; i < num_faces; i++) {
+        if(!(m_skybox ? get_face_pixels(i) : m_pixels)) {
+            return;
+        }
+    }
+    size_t face_size = size();
+    bind();
+    if(!m_unpack_pbo) {
+        glGenBuffers(1, &m_unpack_pbo);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_unpack_pbo);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, face_size * num_faces, NULL, GL_STREAM_DRAW);
+    unsigned char* dest_pixels = static_cast<unsigned char*>(glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY));
+    if(dest_pixels) {
+        for(int i = 0; i < num_faces; i++) {
+            memcpy(&dest_pixels[face_size * i], m_skybox ? get_face_pixels(i) : m_pixels, face_size);
+        }
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        for(int i = 0; i < num_faces; i++) {
+            glTexSubImage2D(m_skybox ? cube_map_targets[i] : GL_TEXTURE_2D,
+                            0,
+                            0,
+                            0,
+                            m_dim.x,
+                            m_dim.y,
+                            m_skybox ? GL_RGBA : get_gl_format(),
+                            m_skybox ? GL_UNSIGNED_BYTE : get_gl_type(),
+                            reinterpret_cast<const void*>(face_size * i)); // offset into pbo
+        }
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if(!dest_pixels) {
+        update();
+        return;
+    }
+    update_mipmaps();
+    clear_dirty();
 }
 
 // NOTE: download from gpu
@@ -721,69 +1193,71 @@ void Texture::refresh()
         {
             return;
         }
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_X, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_pos_x);
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_NEGATIVE_X, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_neg_x);
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_Y, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_neg_y);
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_pos_y);
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_POSITIVE_Z, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_pos_z);
-        glGetTexImage(GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, // target
-                      0,                              // level, 0 = base, no mipmap,
-                      GL_RGBA,                        // format
-                      GL_UNSIGNED_BYTE,               // type
-                      m_pixels_neg_z);
+        for(int i = 0; i < 6; i++) {
+            glGetTexImage(cube_map_targets[i], 0, GL_RGBA, GL_UNSIGNED_BYTE, get_face_pixels(i));
+        }
         return;
     }
     if(!m_pixels) {
         return;
     }
-    switch(m_internal_format) {
-        case Texture::RGBA:
-            glGetTexImage(GL_TEXTURE_2D,    // target
-                          0,                // level, 0 = base, no mipmap,
-                          GL_RGBA,          // format
-                          GL_UNSIGNED_BYTE, // type
-                          m_pixels);
-            break;
-        case Texture::RGB:
-            assert(false);
-            break;
-        case Texture::RED:
-            glGetTexImage(GL_TEXTURE_2D, // target
-                          0,             // level, 0 = base, no mipmap,
-                          GL_RED,        // format
-                          GL_FLOAT,      // type
-                          m_pixels);
-            break;
-        case Texture::DEPTH:
-            glGetTexImage(GL_TEXTURE_2D,      // target
-                          0,                  // level, 0 = base, no mipmap,
-                          GL_DEPTH_COMPONENT, // format
-                          GL_FLOAT,           // type
-                          m_pixels);
-            break;
-        default:
-            break;
+    if(m_internal_format == Texture::RGB) {
+        assert(false);
+        return;
+    }
+    glGetTexImage(GL_TEXTURE_2D,   // target
+                  0,               // level, 0 = base, no mipmap,
+                  get_gl_format(), // format
+                  get_gl_type(),   // type
+                  m_pixels);
+}
+
+// NOTE: starts a gpu -> pbo copy and returns immediately, poll_refresh() lands it in cpu pixels once its fence signals
+void Texture::refresh_async()
+{
+    if(m_skybox || !m_pixels || !GLEW_ARB_pixel_buffer_object || !GLEW_ARB_sync) {
+        refresh();
+        return;
+    }
+    if(m_pack_fence) {
+        return; // already in flight
+    }
+    bind();
+    if(!m_pack_pbo) {
+        glGenBuffers(1, &m_pack_pbo);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pack_pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, size(), NULL, GL_STREAM_READ);
+    } else {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pack_pbo);
+    }
+    glGetTexImage(GL_TEXTURE_2D, 0, get_gl_format(), get_gl_type(), NULL); // offset into pbo
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_pack_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// returns true once cpu pixels hold the last requested readback (always true if none is in flight)
+bool Texture::poll_refresh(bool wait)
+{
+    if(!m_pack_fence) {
+        return true;
+    }
+    GLenum status = glClientWaitSync(m_pack_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while(wait && status == GL_TIMEOUT_EXPIRED) {
+        status = glClientWaitSync(m_pack_fence, GL_SYNC_FLUSH_COMMANDS_BIT, TEXTURE_FENCE_TIMEOUT_NS);
+    }
+    if(status == GL_TIMEOUT_EXPIRED) {
+        return false;
+    }
+    glDeleteSync(m_pack_fence);
+    m_pack_fence = NULL;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, m_pack_pbo);
+    const unsigned char* src_pixels = static_cast<const unsigned char*>(glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+    if(src_pixels) {
+        memcpy(m_pixels, src_pixels, size());
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
     }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
 }
 
 }
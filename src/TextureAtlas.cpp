@@ -0,0 +1,196 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include <TextureAtlas.h>
+#include <Texture.h>
+#include <Material.h>
+#include <Mesh.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+#define TEX_COORD_EPSILON 0.0001
+
+namespace vt {
+
+TextureAtlas::TextureAtlas(const std::string& name,
+                                 glm::ivec2   dim,
+                                 int          padding)
+    : m_name(name),
+      m_dim(dim),
+      m_padding(padding),
+      m_texture(NULL)
+{
+}
+
+// NOTE: needs the cpu copy of an rgba 2d texture (compressed textures and cube maps keep none)
+bool TextureAtlas::can_add(const Texture* texture) const
+{
+    if(m_texture || !texture || !texture->get_pixels() || texture->get_internal_format() != Texture::RGBA) {
+        return false;
+    }
+    if(find_entry(texture) != -1) {
+        return false;
+    }
+    glm::ivec2 dim = texture->get_dim() + glm::ivec2(m_padding * 2);
+    return dim.x <= m_dim.x && dim.y <= m_dim.y;
+}
+
+bool TextureAtlas::add(Texture* texture)
+{
+    if(!can_add(texture)) {
+        return false;
+    }
+    Entry entry;
+    entry.m_source = texture;
+    entry.m_pos    = glm::ivec2(0);
+    entry.m_dim    = texture->get_dim();
+    entry.m_packed = false;
+    m_entries.push_back(entry);
+    return true;
+}
+
+Texture* TextureAtlas::build(bool smooth)
+{
+    if(m_texture || m_entries.empty()) {
+        return m_texture;
+    }
+    pack();
+    std::vector<unsigned char> pixels(m_dim.x * m_dim.y * 4, 0);
+    for(std::vector<Entry>::const_iterator p = m_entries.begin(); p != m_entries.end(); p++) {
+        if(!(*p).m_packed) {
+            std::cout << "texture atlas " << m_name << " is full, " << (*p).m_source->get_name() << " left out" << std::endl;
+            continue;
+        }
+        // NOTE: padding repeats the edge texels, so filtering (and the first few mip levels) don't bleed between entries
+        const unsigned char* src_pixels = (*p).m_source->get_pixels();
+        for(int y = -m_padding; y < (*p).m_dim.y + m_padding; y++) {
+            int src_y  = std::min(std::max(y, 0), (*p).m_dim.y - 1);
+            int dest_y = (*p).m_pos.y + y;
+            for(int x = -m_padding; x < (*p).m_dim.x + m_padding; x++) {
+                int src_x  = std::min(std::max(x, 0), (*p).m_dim.x - 1);
+                int dest_x = (*p).m_pos.x + x;
+                memcpy(&pixels[(dest_y * m_dim.x + dest_x) * 4], &src_pixels[(src_y * (*p).m_dim.x + src_x) * 4], 4);
+            }
+        }
+    }
+    m_texture = new Texture(m_name, Texture::RGBA, m_dim, smooth, Texture::RGBA, &pixels[0], smooth); // mipmap if smooth
+    return m_texture;
+}
+
+int TextureAtlas::find_entry(const Texture* source) const
+{
+    for(int i = 0; i < static_cast<int>(m_entries.size()); i++) {
+        if(m_entries[i].m_source == source) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+glm::vec4 TextureAtlas::get_tex_coord_rect(int index) const
+{
+    const Entry &entry = m_entries[index];
+    return glm::vec4(glm::vec2(entry.m_pos) / glm::vec2(m_dim),
+                     glm::vec2(entry.m_dim) / glm::vec2(m_dim));
+}
+
+bool TextureAtlas::can_remap(const Mesh* mesh)
+{
+    const glm::vec2* tex_coords = mesh->get_tex_coords();
+    for(int i = 0; i < static_cast<int>(mesh->get_num_vertex()); i++) {
+        if(tex_coords[i].x < -TEX_COORD_EPSILON || tex_coords[i].x > 1 + TEX_COORD_EPSILON ||
+           tex_coords[i].y < -TEX_COORD_EPSILON || tex_coords[i].y > 1 + TEX_COORD_EPSILON)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// NOTE: call before the mesh is first rendered, its shader context snapshots the material's textures on creation
+bool TextureAtlas::remap(Mesh* mesh) const
+{
+    Material* material = mesh->get_material();
+    if(!m_texture || !material) {
+        return false;
+    }
+    int texture_index = mesh->get_texture_index();
+    if(texture_index < 0 || texture_index >= static_cast<int>(material->get_textures().size())) {
+        return false;
+    }
+    int index = find_entry(material->get_texture_by_index(texture_index));
+    if(index == -1 || !m_entries[index].m_packed) {
+        return false;
+    }
+    for(int i = 0; i <= mesh->get_num_lods(); i++) {
+        if(!can_remap(mesh->get_lod(i))) {
+            return false;
+        }
+    }
+    int atlas_texture_index = material->get_texture_index(m_texture);
+    if(atlas_texture_index == -1) {
+        material->add_texture(m_texture);
+        atlas_texture_index = material->get_texture_index(m_texture);
+    }
+    glm::vec4 rect = get_tex_coord_rect(index);
+    for(int i = 0; i <= mesh->get_num_lods(); i++) {
+        Mesh*      lod_mesh   = mesh->get_lod(i);
+        glm::vec2* tex_coords = lod_mesh->get_tex_coords();
+        for(int j = 0; j < static_cast<int>(lod_mesh->get_num_vertex()); j++) {
+            tex_coords[j] = glm::vec2(rect.x, rect.y) + glm::clamp(tex_coords[j], glm::vec2(0), glm::vec2(1)) * glm::vec2(rect.z, rect.w);
+        }
+        lod_mesh->set_texture_index(atlas_texture_index);
+        lod_mesh->update_buffers();
+    }
+    return true;
+}
+
+// shelf packing, tallest first
+void TextureAtlas::pack()
+{
+    std::vector<int> order(m_entries.size());
+    for(int i = 0; i < static_cast<int>(order.size()); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return m_entries[a].m_dim.y > m_entries[b].m_dim.y;
+    });
+    glm::ivec2 shelf_pos(0);
+    int        shelf_height = 0;
+    for(std::vector<int>::const_iterator p = order.begin(); p != order.end(); p++) {
+        Entry &entry = m_entries[*p];
+        glm::ivec2 padded_dim = entry.m_dim + glm::ivec2(m_padding * 2);
+        if(shelf_pos.x + padded_dim.x > m_dim.x) {
+            shelf_pos    = glm::ivec2(0, shelf_pos.y + shelf_height);
+            shelf_height = 0;
+        }
+        if(shelf_pos.y + padded_dim.y > m_dim.y) {
+            continue;
+        }
+        entry.m_pos    = shelf_pos + glm::ivec2(m_padding);
+        entry.m_packed = true;
+        shelf_pos.x   += padded_dim.x;
+        shelf_height   = std::max(shelf_height, padded_dim.y);
+    }
+}
+
+}
@@ -16,6 +16,7 @@
 // along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <TransformObject.h>
+#include <DebugArena.h>
 #include <NamedObject.h>
 #include <Util.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -27,15 +28,30 @@
 
 namespace vt {
 
+IKChainState::IKChainState()
+{
+    reset();
+}
+
+void IKChainState::reset()
+{
+    m_has_prev_solution     = false;
+    m_prev_target           = glm::vec3(0);
+    m_prev_end_effector_dir = glm::vec3(0);
+    m_prev_end_effector_tip = glm::vec3(0);
+    m_prev_converged        = false;
+    m_last_iters            = 0;
+    m_total_iters           = 0;
+    m_solve_count           = 0;
+    m_skip_count            = 0;
+    m_converge_count        = 0;
+}
+
 TransformObject::TransformObject(const std::string& name,
                                        glm::vec3    origin,
                                        glm::vec3    euler,
                                        glm::vec3    scale)
     : NamedObject(name),
-      m_debug_target_dir(0),
-      m_debug_end_effector_tip_dir(0),
-      m_debug_local_pivot(0),
-      m_debug_local_target(0),
       m_origin(origin),
       m_euler(euler),
       m_scale(scale),
@@ -46,7 +62,8 @@ TransformObject::TransformObject(const std::string& name,
       m_joint_constraints_max_deviation(glm::vec3(0)),
       m_hinge_type(EULER_INDEX_UNDEF),
       m_is_dirty_transform(true),
-      m_is_dirty_normal_transform(true)
+      m_is_dirty_normal_transform(true),
+      m_joint_constraints_kernel(&TransformObject::apply_free_joint_constraints)
 {
 }
 
@@ -228,23 +245,77 @@ void TransformObject::check_roll_hinge()
     }
 }
 
+void TransformObject::set_joint_type(joint_type_t joint_type)
+{
+    m_joint_type = joint_type;
+    update_joint_constraints_kernel();
+}
+
 void TransformObject::set_hinge_type(euler_index_t hinge_type)
 {
     m_hinge_type = hinge_type;
     check_roll_hinge();
+    update_joint_constraints_kernel();
 }
 
 void TransformObject::set_enable_joint_constraints(glm::ivec3 enable_joint_constraints)
 {
     m_enable_joint_constraints = enable_joint_constraints;
     check_roll_hinge();
+    update_joint_constraints_kernel();
+}
+
+// pick specialized kernel once, so apply_joint_constraints doesn't re-branch on joint mode every ik iteration
+void TransformObject::update_joint_constraints_kernel()
+{
+    // only leading enabled axes are constrained (axis scan stops at first disabled axis)
+    int num_constrained_axes = 0;
+    while(num_constrained_axes < 3 && m_enable_joint_constraints[num_constrained_axes]) {
+        num_constrained_axes++;
+    }
+    switch(m_joint_type) {
+        case JOINT_TYPE_REVOLUTE:
+            switch(m_hinge_type) {
+                case EULER_INDEX_ROLL:  m_joint_constraints_kernel = &TransformObject::apply_hinge_joint_constraints<EULER_INDEX_ROLL>;  return;
+                case EULER_INDEX_PITCH: m_joint_constraints_kernel = &TransformObject::apply_hinge_joint_constraints<EULER_INDEX_PITCH>; return;
+                case EULER_INDEX_YAW:   m_joint_constraints_kernel = &TransformObject::apply_hinge_joint_constraints<EULER_INDEX_YAW>;   return;
+                default:                break;
+            }
+            switch(num_constrained_axes) {
+                case 1:  m_joint_constraints_kernel = &TransformObject::apply_euler_joint_constraints<1>; break;
+                case 2:  m_joint_constraints_kernel = &TransformObject::apply_euler_joint_constraints<2>; break;
+                case 3:  m_joint_constraints_kernel = &TransformObject::apply_euler_joint_constraints<3>; break;
+                default: m_joint_constraints_kernel = &TransformObject::apply_free_joint_constraints;     break;
+            }
+            break;
+        case JOINT_TYPE_PRISMATIC:
+            switch(num_constrained_axes) {
+                case 1:  m_joint_constraints_kernel = &TransformObject::apply_prismatic_joint_constraints<1>; break;
+                case 2:  m_joint_constraints_kernel = &TransformObject::apply_prismatic_joint_constraints<2>; break;
+                case 3:  m_joint_constraints_kernel = &TransformObject::apply_prismatic_joint_constraints<3>; break;
+                default: m_joint_constraints_kernel = &TransformObject::apply_free_joint_constraints;         break;
+            }
+            break;
+    }
 }
 
+static bool disable_recalibrate_heading_recursion = false;
+
 // explode heading into axis endpoints and reconstruct heading from axis endpoints
 void TransformObject::recalibrate_heading_in_parent_system()
 {
-    static bool disable_recursion = false;
-    if(!is_hinge() || disable_recursion) {
+    switch(m_hinge_type) {
+        case EULER_INDEX_ROLL:  recalibrate_heading_in_parent_system_impl<EULER_INDEX_ROLL>();  break;
+        case EULER_INDEX_PITCH: recalibrate_heading_in_parent_system_impl<EULER_INDEX_PITCH>(); break;
+        case EULER_INDEX_YAW:   recalibrate_heading_in_parent_system_impl<EULER_INDEX_YAW>();   break;
+        default:                break;
+    }
+}
+
+template<euler_index_t HINGE_TYPE>
+void TransformObject::recalibrate_heading_in_parent_system_impl()
+{
+    if(disable_recalibrate_heading_recursion) {
         return;
     }
 
@@ -261,7 +332,7 @@ void TransformObject::recalibrate_heading_in_parent_system()
     glm::vec3 joint_abs_up_axis_endpoint      = joint_origin + get_abs_up_direction();   // Y
     glm::vec3 joint_abs_heading_axis_endpoint = joint_origin + get_abs_heading();        // Z
 
-    switch(m_hinge_type) {
+    switch(HINGE_TYPE) {
         case EULER_INDEX_ROLL: // allow ONLY roll -- project onto XY plane
             {
                 // roll on Z axis
@@ -326,18 +397,25 @@ void TransformObject::recalibrate_heading_in_parent_system()
     }
 
     // reconstruct heading from local axis endpoints
-    disable_recursion = true;
+    disable_recalibrate_heading_recursion = true;
     point_at_local(local_heading, &local_up_dir);
-    disable_recursion = false;
+    disable_recalibrate_heading_recursion = false;
 }
 
 // hinge constraints algorithm core
 void TransformObject::apply_hinge_constraints_within_plane_of_free_rotation()
 {
-    if(!is_hinge()) {
-        return;
+    switch(m_hinge_type) {
+        case EULER_INDEX_ROLL:  apply_hinge_constraints_within_plane_of_free_rotation_impl<EULER_INDEX_ROLL>();  break;
+        case EULER_INDEX_PITCH: apply_hinge_constraints_within_plane_of_free_rotation_impl<EULER_INDEX_PITCH>(); break;
+        case EULER_INDEX_YAW:   apply_hinge_constraints_within_plane_of_free_rotation_impl<EULER_INDEX_YAW>();   break;
+        default:                break;
     }
+}
 
+template<euler_index_t HINGE_TYPE>
+void TransformObject::apply_hinge_constraints_within_plane_of_free_rotation_impl()
+{
     glm::vec3 parent_abs_origin;
     glm::mat4 parent_transform;
     glm::vec3 parent_abs_up_direction;
@@ -351,16 +429,16 @@ void TransformObject::apply_hinge_constraints_within_plane_of_free_rotation()
         parent_abs_up_direction = VEC_UP;
     }
 
-    bool is_roll_hinge = (m_hinge_type == EULER_INDEX_ROLL);
+    const bool is_roll_hinge = (HINGE_TYPE == EULER_INDEX_ROLL);
 
     // calculate heading with hinge axis replaced by constraint center scalar
     glm::vec3 deviation_dir          = is_roll_hinge ? get_abs_up_direction() : get_abs_heading();
     glm::vec3 center_local_euler     = m_euler;
-    center_local_euler[m_hinge_type] = m_joint_constraints_center[m_hinge_type];
+    center_local_euler[HINGE_TYPE]   = m_joint_constraints_center[HINGE_TYPE];
     glm::vec3 center_dir             = dir_from_point_as_offset_in_other_system(center_local_euler, parent_transform, parent_abs_origin, is_roll_hinge);
 
     // if pitch hinge joint, pointing backwards, and not yet suppressed roll and yaw
-    if(m_hinge_type == EULER_INDEX_PITCH &&                                // pitch hinge joint
+    if(HINGE_TYPE == EULER_INDEX_PITCH &&                                  // pitch hinge joint
        glm::dot(get_abs_up_direction(), parent_abs_up_direction) < 0 &&    // pointing backwards
        !(m_euler[EULER_INDEX_ROLL] == 0 && m_euler[EULER_INDEX_YAW] == 0)) // not yet suppressed roll and yaw
     {
@@ -382,54 +460,61 @@ void TransformObject::apply_hinge_constraints_within_plane_of_free_rotation()
     }
 
     // if not violating constraints, leave it
-    if(glm::degrees(glm::angle(deviation_dir, center_dir)) <= m_joint_constraints_max_deviation[m_hinge_type]) {
+    if(glm::degrees(glm::angle(deviation_dir, center_dir)) <= m_joint_constraints_max_deviation[HINGE_TYPE]) {
         return;
     }
 
     // if violating constraints, snap to nearest hinge boundary
-    float min_value = m_joint_constraints_center[m_hinge_type] - m_joint_constraints_max_deviation[m_hinge_type];
-    float max_value = m_joint_constraints_center[m_hinge_type] + m_joint_constraints_max_deviation[m_hinge_type];
+    float min_value = m_joint_constraints_center[HINGE_TYPE] - m_joint_constraints_max_deviation[HINGE_TYPE];
+    float max_value = m_joint_constraints_center[HINGE_TYPE] + m_joint_constraints_max_deviation[HINGE_TYPE];
     glm::vec3 min_local_euler = m_euler;
     glm::vec3 max_local_euler = m_euler;
-    min_local_euler[m_hinge_type] = min_value;
-    max_local_euler[m_hinge_type] = max_value;
+    min_local_euler[HINGE_TYPE] = min_value;
+    max_local_euler[HINGE_TYPE] = max_value;
     glm::vec3 min_dir = dir_from_point_as_offset_in_other_system(min_local_euler, parent_transform, parent_abs_origin, is_roll_hinge);
     glm::vec3 max_dir = dir_from_point_as_offset_in_other_system(max_local_euler, parent_transform, parent_abs_origin, is_roll_hinge);
-    m_euler[m_hinge_type] = (glm::distance(deviation_dir, min_dir) < glm::distance(deviation_dir, max_dir)) ? min_value : max_value;
+    m_euler[HINGE_TYPE] = (glm::distance(deviation_dir, min_dir) < glm::distance(deviation_dir, max_dir)) ? min_value : max_value;
     mark_dirty_transform();
 }
 
-void TransformObject::apply_joint_constraints()
+template<euler_index_t HINGE_TYPE>
+void TransformObject::apply_hinge_joint_constraints()
 {
-    switch(m_joint_type) {
-        case JOINT_TYPE_REVOLUTE:
-            if(!is_hinge()) {
-                for(int i = 0; i < 3 && m_enable_joint_constraints[i]; i++) {
-                    if(angle_distance(m_euler[i], m_joint_constraints_center[i]) > m_joint_constraints_max_deviation[i]) {
-                        float min_value = m_joint_constraints_center[i] - m_joint_constraints_max_deviation[i];
-                        float max_value = m_joint_constraints_center[i] + m_joint_constraints_max_deviation[i];
-                        m_euler[i] = (angle_distance(m_euler[i], min_value) < angle_distance(m_euler[i], max_value)) ? min_value : max_value;
-                        mark_dirty_transform();
-                    }
-                }
-                return;
-            }
-            recalibrate_heading_in_parent_system();                  // enforces hinge constraints perpendicular to the plane of free rotation
-            apply_hinge_constraints_within_plane_of_free_rotation(); // enforces joint limits
-            break;
-        case JOINT_TYPE_PRISMATIC:
-            for(int i = 0; i < 3 && m_enable_joint_constraints[i]; i++) {
-                if(fabs(m_origin[i] - m_joint_constraints_center[i]) > m_joint_constraints_max_deviation[i]) {
-                    float min_value = m_joint_constraints_center[i] - m_joint_constraints_max_deviation[i];
-                    float max_value = m_joint_constraints_center[i] + m_joint_constraints_max_deviation[i];
-                    m_origin[i] = (fabs(m_origin[i] - min_value) < fabs(m_origin[i] - max_value)) ? min_value : max_value;
-                    mark_dirty_transform();
-                }
-            }
-            break;
+    recalibrate_heading_in_parent_system_impl<HINGE_TYPE>();                  // enforces hinge constraints perpendicular to the plane of free rotation
+    apply_hinge_constraints_within_plane_of_free_rotation_impl<HINGE_TYPE>(); // enforces joint limits
+}
+
+template<int N>
+void TransformObject::apply_euler_joint_constraints()
+{
+    for(int i = 0; i < N; i++) {
+        if(angle_distance(m_euler[i], m_joint_constraints_center[i]) > m_joint_constraints_max_deviation[i]) {
+            float min_value = m_joint_constraints_center[i] - m_joint_constraints_max_deviation[i];
+            float max_value = m_joint_constraints_center[i] + m_joint_constraints_max_deviation[i];
+            m_euler[i] = (angle_distance(m_euler[i], min_value) < angle_distance(m_euler[i], max_value)) ? min_value : max_value;
+            mark_dirty_transform();
+        }
     }
 }
 
+template<int N>
+void TransformObject::apply_prismatic_joint_constraints()
+{
+    for(int i = 0; i < N; i++) {
+        if(fabs(m_origin[i] - m_joint_constraints_center[i]) > m_joint_constraints_max_deviation[i]) {
+            float min_value = m_joint_constraints_center[i] - m_joint_constraints_max_deviation[i];
+            float max_value = m_joint_constraints_center[i] + m_joint_constraints_max_deviation[i];
+            m_origin[i] = (fabs(m_origin[i] - min_value) < fabs(m_origin[i] - max_value)) ? min_value : max_value;
+            mark_dirty_transform();
+        }
+    }
+}
+
+void TransformObject::apply_joint_constraints()
+{
+    (this->*m_joint_constraints_kernel)();
+}
+
 //==================
 // advanced features
 //==================
@@ -474,9 +559,14 @@ bool TransformObject::solve_ik_ccd(TransformObject* root,
                                    glm::vec3*       end_effector_dir,
                                    int              iters,
                                    float            accept_end_effector_distance,
-                                   float            accept_avg_angle_distance)
+                                   float            accept_avg_angle_distance,
+                                   int*             iters_used)
 {
+    DebugArena* debug_arena = DebugArena::instance()->is_enabled() ? DebugArena::instance() : NULL;
     for(int i = 0; i < iters; i++) {
+        if(iters_used) {
+            *iters_used = i + 1;
+        }
         glm::vec3 _target;
     	glm::vec3 end_effector_tip;
         int segment_count = 0;
@@ -507,15 +597,9 @@ bool TransformObject::solve_ik_ccd(TransformObject* root,
     #if 1
             current_segment->set_local_rotation_transform(local_arc_rotation_transform * current_segment->get_local_rotation_transform());
             // update guide wires (for debug)
-            glm::vec3 debug_local_target_dir              = safe_normalize(current_segment->from_origin_in_parent_system(_target));
-            glm::vec3 debug_local_end_effector_tip_dir    = safe_normalize(current_segment->from_origin_in_parent_system(end_effector_tip));
-            glm::vec3 debug_local_arc_delta_dir           = safe_normalize(debug_local_target_dir - debug_local_end_effector_tip_dir);
-            glm::vec3 debug_local_arc_midpoint_dir        = safe_normalize((debug_local_target_dir + debug_local_end_effector_tip_dir) * 0.5f);
-            glm::vec3 debug_local_arc_pivot_dir           = glm::cross(debug_local_arc_delta_dir, debug_local_arc_midpoint_dir);
-            current_segment->m_debug_target_dir           = debug_local_target_dir;
-            current_segment->m_debug_end_effector_tip_dir = debug_local_end_effector_tip_dir;
-            current_segment->m_debug_local_pivot          = debug_local_arc_pivot_dir;
-            current_segment->m_debug_local_target         = current_segment->from_origin_in_parent_system(_target);
+            if(debug_arena) {
+                debug_arena->add_ik_guide_wire(current_segment, _target, end_effector_tip);
+            }
         #ifdef DEBUG
             //std::cout << "TARGET: " << glm::to_string(local_target_dir) << ", END_EFF: " << glm::to_string(local_end_effector_tip_dir) << ", ANGLE: " << angle_delta << std::endl;
             //std::cout << "BEFORE: " << glm::to_string(new_current_segment_transform * glm::vec4(VEC_FORWARD, 1))
@@ -553,6 +637,83 @@ bool TransformObject::solve_ik_ccd(TransformObject* root,
     return false;
 }
 
+// warm-started ik -- the current pose is the previous frame's solution, so a coherent target needs few (or no) sweeps
+bool TransformObject::solve_ik_ccd_incremental(TransformObject* root,
+                                               glm::vec3        local_end_effector_tip,
+                                               glm::vec3        target,
+                                               glm::vec3*       end_effector_dir,
+                                               int              max_iters,
+                                               float            accept_end_effector_distance,
+                                               float            accept_avg_angle_distance,
+                                               float            accept_target_delta)
+{
+    IKChainState &state = m_ik_chain_state;
+    glm::vec3 _end_effector_dir = end_effector_dir ? *end_effector_dir : glm::vec3(0);
+
+    // skip if target barely moved and nobody disturbed the previous solution
+    if(state.m_has_prev_solution && state.m_prev_converged &&
+       glm::distance(target, state.m_prev_target) < accept_target_delta &&
+       glm::distance(_end_effector_dir, state.m_prev_end_effector_dir) < accept_target_delta &&
+       glm::distance(in_abs_system(local_end_effector_tip), state.m_prev_end_effector_tip) < accept_target_delta)
+    {
+        // NOTE: debug arena is cleared every frame, so re-record guide wires for the unchanged pose
+        if(DebugArena::instance()->is_enabled()) {
+            add_ik_guide_wires(root, local_end_effector_tip, target, end_effector_dir);
+        }
+        state.m_last_iters = 0;
+        state.m_skip_count++;
+        return true;
+    }
+
+    // bounded sweeps starting from effector-nearest segment
+    int iters_used = 0;
+    bool converged = solve_ik_ccd(root,
+                                  local_end_effector_tip,
+                                  target,
+                                  end_effector_dir,
+                                  max_iters,
+                                  accept_end_effector_distance,
+                                  accept_avg_angle_distance,
+                                  &iters_used);
+
+    // record solution
+    state.m_has_prev_solution     = true;
+    state.m_prev_target           = target;
+    state.m_prev_end_effector_dir = _end_effector_dir;
+    state.m_prev_end_effector_tip = in_abs_system(local_end_effector_tip);
+    state.m_prev_converged        = converged;
+    state.m_last_iters            = iters_used;
+    state.m_total_iters          += iters_used;
+    state.m_solve_count++;
+    if(converged) {
+        state.m_converge_count++;
+    }
+#ifdef DEBUG
+    std::cout << "NAME: " << m_name << ", ITERS: " << iters_used << ", CONVERGED: " << converged << std::endl;
+#endif
+    return converged;
+}
+
+// same targets as one solve_ik_ccd sweep, without moving any segment
+void TransformObject::add_ik_guide_wires(TransformObject* root,
+                                         glm::vec3        local_end_effector_tip,
+                                         glm::vec3        target,
+                                         glm::vec3*       end_effector_dir)
+{
+    DebugArena* debug_arena = DebugArena::instance();
+    for(TransformObject* current_segment = this; current_segment && current_segment != root->get_parent(); current_segment = current_segment->get_parent()) {
+        if(current_segment->get_joint_type() == JOINT_TYPE_PRISMATIC) {
+            continue;
+        }
+        glm::vec3 _target          = (end_effector_dir && current_segment == this) ? in_abs_system() + *end_effector_dir : target;
+        glm::vec3 end_effector_tip = in_abs_system(local_end_effector_tip);
+        if(is_hinge()) {
+            current_segment->project_to_plane_of_free_rotation(&_target, &end_effector_tip);
+        }
+        debug_arena->add_ik_guide_wire(current_segment, _target, end_effector_tip);
+    }
+}
+
 void TransformObject::update_boid(glm::vec3 target,
                                   float     forward_speed,
                                   float     angle_delta,
@@ -32,14 +32,16 @@ VarAttribute::~VarAttribute()
 {
 }
 
-void VarAttribute::enable_vertex_attrib_array() const
+void VarAttribute::enable_vertex_attrib_array()
 {
     glEnableVertexAttribArray(m_id);
+    m_is_enabled = true;
 }
 
-void VarAttribute::disable_vertex_attrib_array() const
+void VarAttribute::disable_vertex_attrib_array()
 {
     glDisableVertexAttribArray(m_id);
+    m_is_enabled = false;
 }
 
 void VarAttribute::vertex_attrib_pointer(Buffer*       buffer,
@@ -58,4 +60,11 @@ void VarAttribute::vertex_attrib_pointer(Buffer*       buffer,
                           pointer);
 }
 
+// NOTE: the constant is ignored while an array is enabled at this location
+void VarAttribute::vertex_attrib_4f(GLfloat v0, GLfloat v1, GLfloat v2, GLfloat v3)
+{
+    disable_vertex_attrib_array();
+    glVertexAttrib4f(m_id, v0, v1, v2, v3);
+}
+
 }
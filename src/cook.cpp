@@ -0,0 +1,96 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// offline cooker: writes <source>.cooked next to each 3ds / png source so the app loads warm
+
+#include <FileCooked.h>
+#include <Mesh.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <string>
+#include <iostream> // std::cout
+#include <stdlib.h> // atoi
+#include <string.h> // strcmp
+
+#define DEFAULT_COOK_NUM_LODS 3
+
+static bool ends_with(const std::string& s, const std::string& suffix)
+{
+    return s.size() >= suffix.size() && !s.compare(s.size() - suffix.size(), suffix.size(), suffix);
+}
+
+static bool cook(const std::string& filename, int num_lods, vt::cooked_format_t image_format)
+{
+    bool cache_hit = false;
+    if(ends_with(filename, ".3ds")) {
+        std::vector<vt::Mesh*> meshes;
+        if(!vt::load_3ds_cached(filename, -1, num_lods, &meshes, true, &cache_hit)) {
+            return false;
+        }
+        for(std::vector<vt::Mesh*>::iterator p = meshes.begin(); p != meshes.end(); p++) {
+            delete *p;
+        }
+    } else if(ends_with(filename, ".png")) {
+        vt::CookedFile  cooked_file;
+        vt::CookedImage image;
+        if(!vt::load_png_cached(filename, &cooked_file, &image, image_format, true, &cache_hit)) {
+            return false;
+        }
+        if(!cooked_file.is_open()) {
+            delete[] image.m_data;
+        }
+    } else {
+        std::cout << "unsupported source: " << filename << std::endl;
+        return false;
+    }
+    std::cout << (cache_hit ? "up to date: " : "cooked: ") << vt::get_cooked_filename(filename) << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    if(argc < 2) {
+        std::cout << "usage: " << argv[0] << " [-l <num_lods>] [-rgba|-bc1|-bc3] <file.3ds|file.png> ..." << std::endl;
+        return 1;
+    }
+    int                 num_lods     = DEFAULT_COOK_NUM_LODS;
+    vt::cooked_format_t image_format = vt::COOKED_FORMAT_RGBA;
+    int                 result       = 0;
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-l") && i + 1 < argc) {
+            num_lods = atoi(argv[++i]);
+            continue;
+        }
+        if(!strcmp(argv[i], "-rgba")) {
+            image_format = vt::COOKED_FORMAT_RGBA;
+            continue;
+        }
+        if(!strcmp(argv[i], "-bc1")) {
+            image_format = vt::COOKED_FORMAT_BC1;
+            continue;
+        }
+        if(!strcmp(argv[i], "-bc3")) {
+            image_format = vt::COOKED_FORMAT_BC3;
+            continue;
+        }
+        if(!cook(argv[i], num_lods, image_format)) {
+            std::cout << "failed to cook " << argv[i] << std::endl;
+            result = 1;
+        }
+    }
+    return result;
+}
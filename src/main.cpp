@@ -23,20 +23,28 @@
 #include "res_texture.c"
 #include "res_texture2.c"
 
+#include <AssetLoader.h>
 #include <Buffer.h>
 #include <Camera.h>
+#include <DebugArena.h>
+#include <Deformer.h>
 #include <File3ds.h>
+#include <Flock.h>
 #include <FrameBuffer.h>
+#include <HotReloader.h>
 #include <Light.h>
 #include <Modifiers.h>
 #include <Material.h>
 #include <Mesh.h>
+#include <MeshAllocator.h>
 #include <PrimitiveFactory.h>
 #include <Program.h>
 #include <Scene.h>
 #include <Shader.h>
 #include <ShaderContext.h>
+#include <StaticBatch.h>
 #include <Texture.h>
+#include <TextureAtlas.h>
 #include <Util.h>
 #include <VarAttribute.h>
 #include <VarUniform.h>
@@ -45,6 +53,7 @@
 #include <sstream> // std::stringstream
 #include <iomanip> // std::setprecision
 #include <unistd.h> // access
+#include <sys/resource.h> // getrusage
 
 #include <cfenv>
 
@@ -54,6 +63,17 @@
 #define BLUR_ITERS      5
 #define RAND_TEX_DIM    8
 
+#define IK_SEGMENT_COUNT                4
+#define IK_SEGMENT_LENGTH               0.5
+#define IK_ITERS                        5 // per frame budget, warm start makes up the rest
+#define IK_ACCEPT_END_EFFECTOR_DISTANCE 0.001
+#define IK_ACCEPT_AVG_ANGLE_DISTANCE    0.001
+#define IK_ACCEPT_TARGET_DELTA          0.001
+
+#define FLOCK_BOID_COUNT    64
+#define FLOCK_FORWARD_SPEED 0.02
+#define FLOCK_TURN_RATE     0.05
+
 enum demo_mode_t {
     DEMO_MODE_DEFAULT,
     DEMO_MODE_DIAMOND,
@@ -61,6 +81,8 @@ enum demo_mode_t {
     DEMO_MODE_BOX,
     DEMO_MODE_GRID,
     DEMO_MODE_MESHES_IMPORTED,
+    DEMO_MODE_IK,
+    DEMO_MODE_FLOCK,
     DEMO_MODE_COUNT
 };
 
@@ -96,6 +118,12 @@ vt::Mesh *mesh_skybox  = NULL,
          *hidden_mesh3 = NULL,
          *hidden_mesh4 = NULL;
 std::vector<vt::Mesh*> meshes_imported;
+std::vector<vt::Mesh*> ik_segments; // root first
+vt::Mesh* ik_tentacle = NULL;       // skinned to ik_segments
+glm::vec3 ik_target;
+std::vector<vt::Mesh*> flock_meshes;
+vt::Flock* flock = NULL;
+std::vector<vt::StaticBatch*> static_batches;
 vt::Light *light  = NULL,
           *light2 = NULL,
           *light3 = NULL;
@@ -156,6 +184,8 @@ int overlay_mode = OVERLAY_MODE_DEFAULT,
     demo_mode    = DEMO_MODE_DEFAULT;
 
 float phase = 0;
+vt::Deformer* ripple_deformer = NULL;
+vt::HotReloader* hot_reloader = NULL;
 
 vt::Material *overlay_write_through_material = NULL,
              *overlay_bloom_filter_material  = NULL,
@@ -165,6 +195,27 @@ int init_resources()
 {
     vt::Scene* scene = vt::Scene::instance();
 
+    // NOTE: static scene geometry is carved from scene's arena, so load doesn't churn the heap
+    int load_start_tick = glutGet(GLUT_ELAPSED_TIME);
+    vt::MeshAllocator::set_default(scene->get_mesh_arena());
+
+    // NOTE: files decode on workers while primitives are generated and shaders compile below
+    vt::AssetLoader asset_loader;
+    const char* model_filename = "data/star_wars/TI_Low0.3ds";
+    if(access(model_filename, F_OK) != -1) {
+        asset_loader.load_3ds(model_filename, -1, &meshes_imported, 3, true); // num_lods, compressed
+    }
+    asset_loader.load_texture( "chesterfield_color",  "data/chesterfield_color.png",  &texture3);
+    asset_loader.load_texture( "chesterfield_normal", "data/chesterfield_normal.png", &texture4);
+    asset_loader.load_cube_map("skybox_texture",
+                               "data/SaintPetersSquare2/posx.png",
+                               "data/SaintPetersSquare2/negx.png",
+                               "data/SaintPetersSquare2/posy.png",
+                               "data/SaintPetersSquare2/negy.png",
+                               "data/SaintPetersSquare2/posz.png",
+                               "data/SaintPetersSquare2/negz.png",
+                               &texture5);
+
     mesh_skybox = vt::PrimitiveFactory::create_viewport_quad("grid");
     scene->set_skybox(mesh_skybox);
 
@@ -173,8 +224,8 @@ int init_resources()
 
     scene->add_mesh(mesh         = vt::PrimitiveFactory::create_box(                  "box"));
     scene->add_mesh(mesh2        = vt::PrimitiveFactory::create_grid(                 "grid",       1,  1,   10, 10, 0.05, 0.05));
-    scene->add_mesh(mesh3        = vt::PrimitiveFactory::create_sphere(               "sphere",     16, 16,  0.5));
-    scene->add_mesh(mesh4        = vt::PrimitiveFactory::create_torus(                "torus",      16, 16,  0.5, 0.25));
+    scene->add_mesh(mesh3        = vt::PrimitiveFactory::create_sphere(               "sphere",     16, 16,  0.5, 2));
+    scene->add_mesh(mesh4        = vt::PrimitiveFactory::create_torus(                "torus",      16, 16,  0.5, 0.25, 2));
     scene->add_mesh(mesh5        = vt::PrimitiveFactory::create_cylinder(             "cylinder",   16, 0.5, 1));
     scene->add_mesh(mesh6        = vt::PrimitiveFactory::create_cone(                 "cone",       16, 0.5, 1));
     scene->add_mesh(mesh7        = vt::PrimitiveFactory::create_hemisphere(           "hemisphere", 16, 16,  0.5));
@@ -185,13 +236,6 @@ int init_resources()
     scene->add_mesh(hidden_mesh2 = vt::PrimitiveFactory::create_sphere(               "sphere2", 16, 16, 0.5));
     scene->add_mesh(hidden_mesh3 = vt::PrimitiveFactory::create_box(                  "box3"));
     scene->add_mesh(hidden_mesh4 = vt::PrimitiveFactory::create_grid(                 "grid2",   32, 32, 1, 1));
-    const char* model_filename = "data/star_wars/TI_Low0.3ds";
-    if(access(model_filename, F_OK) != -1) {
-        vt::File3ds::load3ds(model_filename, -1, &meshes_imported);
-    }
-    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        scene->add_mesh(*p);
-    }
 
     mesh->set_origin(        glm::vec3(-0.5, -0.5, -0.5)); // box
     mesh2->set_origin(       glm::vec3(-5, 5, -1));        // grid
@@ -207,9 +251,6 @@ int init_resources()
     hidden_mesh2->set_origin(glm::vec3(0, 0, 0));          // sphere2
     hidden_mesh3->set_origin(glm::vec3(-1, -1, -1));       // box3
     hidden_mesh4->set_origin(glm::vec3(-2, 0, -2));        // grid2
-    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        (*p)->set_origin(glm::vec3(0, 0, 0));
-    }
 
     mesh2->set_euler(glm::vec3(0, 90, 0));
 
@@ -220,17 +261,11 @@ int init_resources()
     hidden_mesh2->set_visible(false);
     hidden_mesh3->set_visible(false);
     hidden_mesh4->set_visible(false);
-    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        (*p)->set_visible(false);
-    }
 
     hidden_mesh->set_scale(glm::vec3( 2, 2, 2)); // diamond2
     hidden_mesh2->set_scale(glm::vec3(2, 2, 2)); // sphere2
     hidden_mesh3->set_scale(glm::vec3(2, 2, 2)); // box3
     hidden_mesh4->set_scale(glm::vec3(4, 4, 4)); // grid2
-    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        (*p)->set_scale(glm::vec3(0.1, 0.1, 0.1));
-    }
 
     vt::Material* bump_mapped_material = new vt::Material("bump_mapped",
                                                           "src/shaders/bump_mapped.v.glsl",
@@ -242,6 +277,16 @@ int init_resources()
                                                     "src/shaders/phong.f.glsl");
     scene->add_material(phong_material);
 
+    vt::Material* skinned_phong_material = new vt::Material("skinned_phong",
+                                                            "src/shaders/skinned_phong.v.glsl",
+                                                            "src/shaders/phong.f.glsl");
+    scene->add_material(skinned_phong_material);
+
+    vt::Material* deformed_phong_material = new vt::Material("deformed_phong",
+                                                             "src/shaders/deformed_phong.v.glsl",
+                                                             "src/shaders/phong.f.glsl");
+    scene->add_material(deformed_phong_material);
+
     vt::Material* ssao_material = new vt::Material("ssao",
                                                    "src/shaders/ssao.v.glsl",
                                                    "src/shaders/ssao.f.glsl");
@@ -292,6 +337,11 @@ int init_resources()
                                                               "src/shaders/env_mapped_fast.f.glsl");
     scene->add_material(env_mapped_fast_material);
 
+    vt::Material* compressed_env_mapped_fast_material = new vt::Material("compressed_env_mapped_fast",
+                                                                         "src/shaders/compressed_env_mapped_fast.v.glsl",
+                                                                         "src/shaders/env_mapped_fast.f.glsl");
+    scene->add_material(compressed_env_mapped_fast_material);
+
     vt::Material* normal_material = new vt::Material("normal",
                                                      "src/shaders/normal.v.glsl",
                                                      "src/shaders/normal.f.glsl");
@@ -308,6 +358,19 @@ int init_resources()
                                                       "src/shaders/ambient.f.glsl");
     scene->add_material(ambient_material);
     scene->set_wireframe_material(ambient_material);
+    scene->set_fallback_material(ambient_material);
+
+    // uploads run here, on the gl thread
+    while(!asset_loader.is_done()) {
+        asset_loader.poll(true);
+        std::cout << "Loading assets: " << asset_loader.get_num_uploaded() << "/" << asset_loader.get_num_jobs() << std::endl;
+    }
+    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
+        scene->add_mesh(*p);
+        (*p)->set_origin(glm::vec3(0, 0, 0));
+        (*p)->set_visible(false);
+        (*p)->set_scale(glm::vec3(0.1, 0.1, 0.1));
+    }
 
     texture = new vt::Texture("dex3d",
                               vt::Texture::RGBA,
@@ -328,33 +391,23 @@ int init_resources()
     scene->add_texture(               texture2);
     bump_mapped_material->add_texture(texture2);
 
-    texture3 = new vt::Texture("chesterfield_color",
-                               "data/chesterfield_color.png");
     scene->add_texture(                          texture3);
     bump_mapped_material->add_texture(           texture3);
     env_mapped_chroma_disp_material->add_texture(texture3);
     env_mapped_dbl_refract_material->add_texture(texture3);
 
-    texture4 = new vt::Texture("chesterfield_normal",
-                               "data/chesterfield_normal.png");
     scene->add_texture(                          texture4);
     bump_mapped_material->add_texture(           texture4);
     env_mapped_chroma_disp_material->add_texture(texture4);
     env_mapped_dbl_refract_material->add_texture(texture4);
     normal_material->add_texture(                texture4);
 
-    texture5 = new vt::Texture("skybox_texture",
-                               "data/SaintPetersSquare2/posx.png",
-                               "data/SaintPetersSquare2/negx.png",
-                               "data/SaintPetersSquare2/posy.png",
-                               "data/SaintPetersSquare2/negy.png",
-                               "data/SaintPetersSquare2/posz.png",
-                               "data/SaintPetersSquare2/negz.png");
-    scene->add_texture(                          texture5);
-    skybox_material->add_texture(                texture5);
-    env_mapped_chroma_disp_material->add_texture(texture5);
-    env_mapped_dbl_refract_material->add_texture(texture5);
-    env_mapped_fast_material->add_texture(       texture5);
+    scene->add_texture(                              texture5);
+    skybox_material->add_texture(                    texture5);
+    env_mapped_chroma_disp_material->add_texture(    texture5);
+    env_mapped_dbl_refract_material->add_texture(    texture5);
+    env_mapped_fast_material->add_texture(           texture5);
+    compressed_env_mapped_fast_material->add_texture(texture5);
 
     frontface_depth_overlay_texture = new vt::Texture("frontface_depth_overlay",
                                                       vt::Texture::DEPTH,
@@ -427,6 +480,7 @@ int init_resources()
                                      vt::Texture::RGBA,
                                      NULL);
     random_texture->randomize();
+    random_texture->update_async();
     texture_mapped_material->add_texture(random_texture);
     ssao_material->add_texture(          random_texture);
 
@@ -482,6 +536,17 @@ int init_resources()
     mesh5->set_material(texture_mapped_material);
     mesh5->set_texture_index(mesh5->get_material()->get_texture_index_by_name("dex3d"));
 
+    // small color textures share one atlas, so meshes textured by either can batch under texture_mapped
+    vt::TextureAtlas small_texture_atlas("small_texture_atlas", glm::ivec2(64));
+    small_texture_atlas.add(texture);
+    small_texture_atlas.add(texture2);
+    if(small_texture_atlas.build(false)) {
+        scene->add_texture(small_texture_atlas.get_texture());
+        if(!small_texture_atlas.remap(mesh5)) {
+            std::cout << "cannot remap " << mesh5->get_name() << " into " << small_texture_atlas.get_texture()->get_name() << std::endl;
+        }
+    }
+
     // cone
     mesh6->set_material(normal_material);
     mesh6->set_bump_texture_index(mesh6->get_material()->get_texture_index_by_name("chesterfield_normal"));
@@ -530,7 +595,9 @@ int init_resources()
     hidden_mesh2->set_backface_normal_overlay_texture_index(hidden_mesh2->get_material()->get_texture_index_by_name("backface_normal_overlay"));
 
     for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
-        (*p)->set_material(env_mapped_fast_material);
+        //(*p)->set_material(env_mapped_fast_material);
+        (*p)->set_material(compressed_env_mapped_fast_material);
+        (*p)->set_compressed(true);
         //(*p)->set_reflect_to_refract_ratio(0.33); // 33% reflective
     }
 
@@ -545,9 +612,121 @@ int init_resources()
 
     // grid2
     //hidden_mesh4->set_material(env_mapped_fast_material);
-    hidden_mesh4->set_material(phong_material);
+    //hidden_mesh4->set_material(phong_material); // ripple via cpu fallback
+    hidden_mesh4->set_material(deformed_phong_material);
     //hidden_mesh4->set_reflect_to_refract_ratio(0.33); // 33% reflective
     hidden_mesh4->set_ambient_color(glm::vec3(0, 0, 0));
+    ripple_deformer = new vt::Deformer(vt::Deformer::DEFORMER_TYPE_RIPPLE,
+                                       glm::vec3(0.5, 0, 0.5),
+                                       glm::vec4(0.1, 0.5, 0, 0)); // amplitude, wavelength, phase
+    hidden_mesh4->set_deformer(ripple_deformer);
+
+    // ik chain
+    for(int i = 0; i < IK_SEGMENT_COUNT; i++) {
+        std::stringstream ss;
+        ss << "ik_segment" << i;
+        vt::Mesh* ik_segment = vt::PrimitiveFactory::create_box(ss.str(), 0.1, 0.1, IK_SEGMENT_LENGTH);
+        ik_segment->center_axis(vt::BBoxObject::ALIGN_Z_MIN);
+        if(ik_segments.empty()) {
+            ik_segment->set_origin(glm::vec3(0, -1, 0));
+        } else {
+            ik_segment->link_parent(ik_segments.back());
+            ik_segment->set_origin(glm::vec3(0, 0, IK_SEGMENT_LENGTH)); // tip of parent
+        }
+        ik_segment->set_material(phong_material);
+        ik_segment->set_visible(false);
+        scene->add_mesh(ik_segment);
+        ik_segments.push_back(ik_segment);
+    }
+
+    // ik tentacle (bound while ik chain is still in rest pose)
+    for(int i = 0; i < IK_SEGMENT_COUNT; i++) {
+        vt::Mesh* tentacle_segment = vt::PrimitiveFactory::create_cylinder("tentacle_segment", 16, 0.05, IK_SEGMENT_LENGTH);
+        tentacle_segment->transform_vertices(GLM_ROTATION_TRANSFORM(glm::translate(glm::mat4(1), glm::vec3(0, 0, IK_SEGMENT_LENGTH * i)), 90, VEC_LEFT)); // y to z
+        if(!ik_tentacle) {
+            ik_tentacle = tentacle_segment;
+            continue;
+        }
+        ik_tentacle->merge(tentacle_segment);
+        delete tentacle_segment;
+    }
+    ik_tentacle->set_name("ik_tentacle");
+    ik_tentacle->set_origin(ik_segments.front()->get_origin());
+    for(std::vector<vt::Mesh*>::iterator p = ik_segments.begin(); p != ik_segments.end(); p++) {
+        ik_tentacle->add_bone(*p);
+    }
+    // NOTE: cylinder rings only sit on joints, each joint split evenly between the bones it connects
+    for(int i = 0; i < static_cast<int>(ik_tentacle->get_num_vertex()); i++) {
+        int joint = glm::clamp(static_cast<int>(floor(ik_tentacle->get_vert_coord(i).z / IK_SEGMENT_LENGTH + 0.5)), 0, IK_SEGMENT_COUNT);
+        if(joint == 0 || joint == IK_SEGMENT_COUNT) {
+            ik_tentacle->set_bone_indices(i, glm::ivec4(std::min(joint, IK_SEGMENT_COUNT - 1), 0, 0, 0));
+            ik_tentacle->set_bone_weights(i, glm::vec4(1, 0, 0, 0));
+        } else {
+            ik_tentacle->set_bone_indices(i, glm::ivec4(joint - 1, joint, 0, 0));
+            ik_tentacle->set_bone_weights(i, glm::vec4(0.5, 0.5, 0, 0));
+        }
+    }
+    ik_tentacle->set_material(skinned_phong_material);
+    ik_tentacle->set_visible(false);
+    scene->add_mesh(ik_tentacle);
+    scene->m_debug_targets.push_back(std::make_tuple(ik_target, glm::vec3(1, 0, 0), 0.25f, 1.0f)); // color, radius, linewidth
+
+    // flock
+    flock = new vt::Flock(glm::vec3(-2, -2, -2), glm::vec3(4, 4, 4));
+    flock->set_neighbor_radius(0.5);
+    flock->set_separation_radius(0.2);
+    for(int i = 0; i < FLOCK_BOID_COUNT; i++) {
+        std::stringstream ss;
+        ss << "boid" << i;
+        vt::Mesh* boid_mesh = vt::PrimitiveFactory::create_tetrahedron(ss.str(), 0.05, 0.05, 0.1);
+        boid_mesh->center_axis();
+        boid_mesh->set_material(phong_material);
+        boid_mesh->set_visible(false);
+        scene->add_mesh(boid_mesh);
+        flock_meshes.push_back(boid_mesh);
+        glm::vec3 pos(static_cast<float>(rand()) / RAND_MAX * 4 - 2,
+                      static_cast<float>(rand()) / RAND_MAX * 4 - 2,
+                      static_cast<float>(rand()) / RAND_MAX * 4 - 2);
+        glm::vec3 heading(static_cast<float>(rand()) / RAND_MAX - 0.5,
+                          static_cast<float>(rand()) / RAND_MAX - 0.5,
+                          static_cast<float>(rand()) / RAND_MAX - 0.5);
+        flock->add_boid(pos, heading, boid_mesh);
+    }
+
+    // static batches (sources are hidden, batch meshes stand in for them)
+    std::vector<vt::Mesh*> static_meshes;
+    static_meshes.push_back(mesh8);  // tetrahedron
+    static_meshes.push_back(mesh10); // box2
+    vt::build_static_batches(static_meshes, &static_batches);
+    for(std::vector<vt::StaticBatch*>::iterator p = static_batches.begin(); p != static_batches.end(); p++) {
+        scene->add_mesh((*p)->get_mesh());
+    }
+
+    // meshes created from here on are dynamic
+    vt::MeshAllocator::set_default(vt::PoolMeshAllocator::instance());
+
+    // NOTE: edits to watched files are picked up between frames
+    hot_reloader = new vt::HotReloader();
+    for(vt::Scene::materials_t::const_iterator p = scene->get_materials().begin(); p != scene->get_materials().end(); p++) {
+        hot_reloader->watch_material(*p);
+    }
+    hot_reloader->watch_texture(texture3, "data/chesterfield_color.png");
+    hot_reloader->watch_texture(texture4, "data/chesterfield_normal.png");
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/posx.png", 0);
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/negx.png", 1);
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/posy.png", 2);
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/negy.png", 3);
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/posz.png", 4);
+    hot_reloader->watch_texture(texture5, "data/SaintPetersSquare2/negz.png", 5);
+    if(access(model_filename, F_OK) != -1) {
+        hot_reloader->watch_3ds(model_filename, -1, &meshes_imported);
+    }
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << "Load time: " << (glutGet(GLUT_ELAPSED_TIME) - load_start_tick) << "ms, "
+              << "peak RSS: " << usage.ru_maxrss << "KB, "
+              << "mesh arena: " << scene->get_mesh_arena()->get_peak_bytes_in_use() << "/"
+                                << scene->get_mesh_arena()->get_bytes_reserved() << " bytes used/reserved" << std::endl;
 
     return 1;
 }
@@ -562,6 +741,12 @@ int deinit_resources()
     if(hi_res_color_overlay_fb)     { delete hi_res_color_overlay_fb; }
     if(med_res_color_overlay_fb)    { delete med_res_color_overlay_fb; }
     if(lo_res_color_overlay_fb)     { delete lo_res_color_overlay_fb; }
+    if(ripple_deformer)             { delete ripple_deformer; }
+    if(flock)                       { delete flock; }
+    for(std::vector<vt::StaticBatch*>::iterator p = static_batches.begin(); p != static_batches.end(); p++) {
+        delete *p;
+    }
+    if(hot_reloader)                { delete hot_reloader; }
 
     return 1;
 }
@@ -590,14 +775,45 @@ void onTick()
             << "Yaw=" << EULER_YAW(euler) << ", Pitch=" << EULER_PITCH(euler) << ", Radius=" << orbit_radius << ", "
             << "Zoom=" << zoom;
         //ss << "Width=" << camera->get_width() << ", Width=" << camera->get_height();
+        if(demo_mode == DEMO_MODE_IK) {
+            const vt::IKChainState &ik_chain_state = ik_segments.back()->get_ik_chain_state();
+            ss << ", IK iters/solve=" << ik_chain_state.get_avg_iters() << ", IK skips=" << ik_chain_state.m_skip_count;
+        }
         glutSetWindowTitle(ss.str().c_str());
     }
     frames++;
 
+    vt::DebugArena::instance()->begin_frame();
+    hot_reloader->update();
+
     phase = static_cast<float>(glutGet(GLUT_ELAPSED_TIME)) / 1000 * 15; // base 15 degrees per second
 
-    mesh_apply_ripple(hidden_mesh4, glm::vec3(0.5, 0, 0.5), 0.1, 0.5, -phase * 0.1, false);
-    hidden_mesh4->update_buffers();
+    ripple_deformer->set_phase(-phase * 0.1);
+    if(hidden_mesh4->get_material()->is_ready() &&
+       !hidden_mesh4->get_material()->get_program()->has_var(vt::Program::VAR_TYPE_UNIFORM, vt::Program::var_uniform_type_deformer_type))
+    {
+        ripple_deformer->apply(hidden_mesh4); // cpu fallback
+        hidden_mesh4->update_buffers();
+    }
+
+    // NOTE: warm-started from last frame's pose, so a slow-moving target only needs a few sweeps
+    if(demo_mode == DEMO_MODE_IK) {
+        float angle = phase * 4 * PI / 180;
+        ik_target = glm::vec3(cos(angle), sin(angle) - 1, 1);
+        std::get<vt::Scene::DEBUG_TARGET_ORIGIN>(vt::Scene::instance()->m_debug_targets[0]) = ik_target;
+        ik_segments.back()->solve_ik_ccd_incremental(ik_segments.front(),
+                                                     glm::vec3(0, 0, IK_SEGMENT_LENGTH), // end effector tip
+                                                     ik_target,
+                                                     NULL,
+                                                     IK_ITERS,
+                                                     IK_ACCEPT_END_EFFECTOR_DISTANCE,
+                                                     IK_ACCEPT_AVG_ANGLE_DISTANCE,
+                                                     IK_ACCEPT_TARGET_DELTA);
+    }
+
+    if(demo_mode == DEMO_MODE_FLOCK) {
+        flock->update(FLOCK_FORWARD_SPEED, FLOCK_TURN_RATE);
+    }
 }
 
 void apply_bloom_filter(vt::Scene*       scene,
@@ -644,6 +860,32 @@ void apply_bloom_filter(vt::Scene*       scene,
     output_fb->unbind();
 }
 
+// NOTE: vbos are created on first draw, so this waits until the imported meshes have been drawn
+void report_imported_vertex_buffer_size()
+{
+    static bool reported = false;
+    if(reported || meshes_imported.empty() || !meshes_imported[0]->is_visible()) {
+        return;
+    }
+    size_t num_vertex         = 0;
+    size_t vertex_buffer_size = 0;
+    for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
+        for(int i = 0; i <= (*p)->get_num_lods(); i++) {
+            vt::Mesh* lod_mesh = (*p)->get_lod(i);
+            if(lod_mesh->get_vertex_buffer_size()) { // only lods drawn so far have vbos
+                num_vertex         += lod_mesh->get_num_vertex();
+                vertex_buffer_size += lod_mesh->get_vertex_buffer_size();
+            }
+        }
+    }
+    if(!vertex_buffer_size) {
+        return; // programs still linking
+    }
+    std::cout << "Imported vertex buffers: " << vertex_buffer_size << " bytes ("
+              << static_cast<float>(vertex_buffer_size) / num_vertex << " bytes per vertex)" << std::endl;
+    reported = true;
+}
+
 void onDisplay()
 {
     if(do_animation) {
@@ -728,6 +970,7 @@ void onDisplay()
         scene->render_lights();
     }
     glutSwapBuffers();
+    report_imported_vertex_buffer_size();
 }
 
 void set_mesh_visibility(bool visible)
@@ -739,9 +982,9 @@ void set_mesh_visibility(bool visible)
     mesh5->set_visible(visible);        // cylinder
     mesh6->set_visible(visible);        // cone
     mesh7->set_visible(visible);        // hemisphe
-    mesh8->set_visible(visible);        // tetrahed
+    //mesh8->set_visible(visible);      // tetrahed (static batch)
     mesh9->set_visible(visible);        // diamond
-    mesh10->set_visible(visible);       // box2
+    //mesh10->set_visible(visible);     // box2 (static batch)
     hidden_mesh->set_visible(visible);  // diamond2
     hidden_mesh2->set_visible(visible); // sphere2
     hidden_mesh3->set_visible(visible); // box3
@@ -749,6 +992,13 @@ void set_mesh_visibility(bool visible)
     for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
         (*p)->set_visible(visible);
     }
+    ik_tentacle->set_visible(visible);
+    for(std::vector<vt::StaticBatch*>::iterator r = static_batches.begin(); r != static_batches.end(); r++) {
+        (*r)->get_mesh()->set_visible(visible);
+    }
+    for(std::vector<vt::Mesh*>::iterator r = flock_meshes.begin(); r != flock_meshes.end(); r++) {
+        (*r)->set_visible(visible);
+    }
 }
 
 void onKeyboard(unsigned char key, int x, int y)
@@ -769,6 +1019,10 @@ void onKeyboard(unsigned char key, int x, int y)
                     for(std::vector<vt::Mesh*>::iterator p = meshes_imported.begin(); p != meshes_imported.end(); p++) {
                         (*p)->set_visible(false);
                     }
+                    ik_tentacle->set_visible(false);
+                    for(std::vector<vt::Mesh*>::iterator r = flock_meshes.begin(); r != flock_meshes.end(); r++) {
+                        (*r)->set_visible(false);
+                    }
                     break;
                 case DEMO_MODE_DIAMOND:
                     set_mesh_visibility(false);
@@ -792,6 +1046,16 @@ void onKeyboard(unsigned char key, int x, int y)
                         (*p)->set_visible(true);
                     }
                     break;
+                case DEMO_MODE_IK:
+                    set_mesh_visibility(false);
+                    ik_tentacle->set_visible(true);
+                    break;
+                case DEMO_MODE_FLOCK:
+                    set_mesh_visibility(false);
+                    for(std::vector<vt::Mesh*>::iterator r = flock_meshes.begin(); r != flock_meshes.end(); r++) {
+                        (*r)->set_visible(true);
+                    }
+                    break;
                 default:
                     break;
             }
@@ -804,6 +1068,11 @@ void onKeyboard(unsigned char key, int x, int y)
             break;
         case 'g': // guide wires
             show_guide_wires = !show_guide_wires;
+            if(show_guide_wires) {
+                vt::DebugArena::instance()->register_consumer();
+            } else {
+                vt::DebugArena::instance()->unregister_consumer();
+            }
             break;
         case 'l': // lights
             show_lights = !show_lights;
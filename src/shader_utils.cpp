@@ -22,7 +22,13 @@
  */
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <GL/glew.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define MAX_INCLUDE_DEPTH 8
 
 /**
  * Store all the file's contents in memory, useful to pass shaders
@@ -66,6 +72,60 @@ char* file_read(const char* filename)
   return res;
 }
 
+static bool expand_includes(const std::string& filename, std::string* source, std::vector<std::string>* include_files, int depth)
+{
+  char* text = file_read(filename.c_str());
+  if (text == NULL) {
+    if (depth) {
+      fprintf(stderr, "Error opening %s: ", filename.c_str()); perror("");
+    }
+    return false;
+  }
+  size_t slash_pos = filename.rfind('/');
+  std::string dir = (slash_pos == std::string::npos) ? "" : filename.substr(0, slash_pos + 1);
+  bool result = true;
+  for (const char* line = text; *line && result;) {
+    const char* line_end = strchr(line, '\n');
+    size_t line_len = line_end ? (line_end - line + 1) : strlen(line);
+    const char* open_quote  = !strncmp(line, "#include", 8) ? (const char*)memchr(line, '"', line_len) : NULL;
+    const char* close_quote = open_quote ? (const char*)memchr(open_quote + 1, '"', line_len - (open_quote + 1 - line)) : NULL;
+    if (close_quote) {
+      std::string include_file = dir + std::string(open_quote + 1, close_quote);
+      if (std::find(include_files->begin(), include_files->end(), include_file) == include_files->end()) { // include once
+        if (depth == MAX_INCLUDE_DEPTH) {
+          fprintf(stderr, "Error including %s: nested too deep\n", include_file.c_str());
+          result = false;
+        } else {
+          include_files->push_back(include_file);
+          result = expand_includes(include_file, source, include_files, depth + 1);
+          if (!source->empty() && (*source)[source->size() - 1] != '\n')
+            source->push_back('\n');
+        }
+      }
+    } else {
+      source->append(line, line_len);
+    }
+    line += line_len;
+  }
+  free(text);
+  return result;
+}
+
+/**
+ * Same as file_read, but replaces each '#include "file"' line (path relative to the including file)
+ * with the file's contents, since GLSL has no include of its own
+ */
+char* file_read_with_includes(const char* filename, std::vector<std::string>* include_files)
+{
+  std::vector<std::string> _include_files;
+  std::string source;
+  if (!expand_includes(filename, &source, &_include_files, 0))
+    return NULL;
+  if (include_files)
+    *include_files = _include_files;
+  return strdup(source.c_str());
+}
+
 /**
  * Display compilation errors from the OpenGL shader compiler
  */
@@ -93,11 +153,12 @@ void print_log(GLuint object)
 }
 
 /**
- * Compile the shader from file 'filename', with error handling
+ * Start compiling the shader from file 'filename', without waiting for the result
+ * (check GL_COMPILE_STATUS later, e.g. after linking)
  */
-GLuint create_shader(const char* filename, GLenum type)
+GLuint create_shader_deferred(const char* filename, GLenum type)
 {
-  const GLchar* source = file_read(filename);
+  const GLchar* source = file_read_with_includes(filename, NULL);
   if (source == NULL) {
     fprintf(stderr, "Error opening %s: ", filename); perror("");
     return 0;
@@ -135,6 +196,17 @@ GLuint create_shader(const char* filename, GLenum type)
   free((void*)source);
 
   glCompileShader(res);
+  return res;
+}
+
+/**
+ * Compile the shader from file 'filename', with error handling
+ */
+GLuint create_shader(const char* filename, GLenum type)
+{
+  GLuint res = create_shader_deferred(filename, type);
+  if (!res)
+    return 0;
   GLint compile_ok = GL_FALSE;
   glGetShaderiv(res, GL_COMPILE_STATUS, &compile_ok);
   if (compile_ok == GL_FALSE) {
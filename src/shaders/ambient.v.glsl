@@ -15,10 +15,18 @@
 // You should have received a copy of the GNU General Public License
 // along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
 
-attribute vec3 vertex_position;
+#include "deformer.inc.glsl"
+#include "skinning.inc.glsl"
+#include "vertex_decode.inc.glsl"
+
 uniform mat4 mvp_transform;
 
 void main()
 {
-    gl_Position = mvp_transform * vec4(vertex_position, 1);
+    vec3 pos    = decode_position();
+    vec3 normal = decode_normal();
+    deform(pos, normal);
+    pos = vec3(get_skin_transform() * vec4(pos, 1));
+
+    gl_Position = mvp_transform * vec4(pos, 1);
 }
@@ -0,0 +1,46 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "vertex_decode.inc.glsl"
+
+const float AIR_REFRACTIVE_INDEX = 1.0;
+const float WATER_REFRACTIVE_INDEX = 1.333;
+uniform mat4 model_transform;
+uniform mat4 mvp_transform;
+uniform mat4 normal_transform;
+uniform vec3 camera_pos;
+varying vec3 lerp_reflected_flipped_cubemap_texcoord;
+varying vec3 lerp_refracted_flipped_cubemap_texcoord;
+
+void main()
+{
+    vec3 position = decode_position();
+    vec3 normal = decode_normal();
+
+    vec3 vertex_position_world = vec3(model_transform * vec4(position, 1));
+    vec3 normal_world = normalize(vec3(normal_transform * vec4(normal, 0)));
+
+    vec3 camera_direction = normalize(camera_pos - vertex_position_world);
+
+    vec3 reflected_camera_dir = reflect(-camera_direction, normal_world);
+    vec3 refracted_camera_dir = refract(-camera_direction, normal_world, AIR_REFRACTIVE_INDEX / WATER_REFRACTIVE_INDEX);
+
+    lerp_reflected_flipped_cubemap_texcoord = vec3(reflected_camera_dir.x, -reflected_camera_dir.y, reflected_camera_dir.z);
+    lerp_refracted_flipped_cubemap_texcoord = vec3(refracted_camera_dir.x, -refracted_camera_dir.y, refracted_camera_dir.z);
+
+    gl_Position = mvp_transform * vec4(position, 1);
+}
@@ -0,0 +1,66 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// NOTE: keep in sync with Deformer::deformer_type_t and Deformer::apply (cpu fallback)
+const int DEFORMER_TYPE_NONE   = 0;
+const int DEFORMER_TYPE_RIPPLE = 1;
+const int DEFORMER_TYPE_TWIST  = 2;
+const int DEFORMER_TYPE_BEND   = 3;
+const int DEFORMER_TYPE_NOISE  = 4;
+const float PI = 3.1415926;
+const float EPSILON = 0.0001;
+
+uniform int deformer_type;
+uniform vec3 deformer_origin;
+uniform vec4 deformer_params;
+
+void deform(inout vec3 pos, inout vec3 normal)
+{
+    vec3 local = pos - deformer_origin;
+    if(deformer_type == DEFORMER_TYPE_RIPPLE) {
+        float wavenumber = (PI * 2.0) / deformer_params.y;
+        float radius     = length(local.xz);
+        float angle      = radius * wavenumber + deformer_params.z;
+        float slope      = (radius > EPSILON) ? cos(angle) * deformer_params.x * wavenumber / radius : 0.0;
+        pos.y  = deformer_origin.y + sin(angle) * deformer_params.x;
+        normal = normalize(vec3(-local.x * slope, 1.0, -local.z * slope));
+    } else if(deformer_type == DEFORMER_TYPE_TWIST) {
+        float theta = local.y * deformer_params.x;
+        mat2 rotation = mat2(cos(theta), sin(theta), -sin(theta), cos(theta));
+        pos.xz    = deformer_origin.xz + rotation * local.xz;
+        normal.xz = rotation * normal.xz;
+    } else if(deformer_type == DEFORMER_TYPE_BEND) {
+        float curvature = deformer_params.x;
+        if(abs(curvature) > EPSILON) {
+            float bend_radius = 1.0 / curvature;
+            float theta = local.x * curvature;
+            mat2 rotation = mat2(cos(theta), sin(theta), -sin(theta), cos(theta));
+            pos.xy    = deformer_origin.xy + vec2((bend_radius - local.y) * sin(theta),
+                                                  bend_radius - (bend_radius - local.y) * cos(theta));
+            normal.xy = rotation * normal.xy;
+        }
+    } else if(deformer_type == DEFORMER_TYPE_NOISE) {
+        vec3 q  = local * deformer_params.y + vec3(deformer_params.z);
+        vec3 sq = sin(q);
+        vec3 cq = cos(q);
+        vec3 grad = vec3(cq.x * sq.y * sq.z,
+                         sq.x * cq.y * sq.z,
+                         sq.x * sq.y * cq.z) * (deformer_params.x * deformer_params.y);
+        pos    += normal * (sq.x * sq.y * sq.z * deformer_params.x);
+        normal  = normalize(normal - (grad - normal * dot(grad, normal)));
+    }
+}
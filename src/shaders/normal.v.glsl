@@ -1,7 +1,7 @@
-attribute vec2 texcoord;
-attribute vec3 vertex_normal;
-attribute vec3 vertex_position;
-attribute vec3 vertex_tangent;
+#include "deformer.inc.glsl"
+#include "skinning.inc.glsl"
+#include "vertex_decode.inc.glsl"
+
 uniform mat4 mvp_transform;
 uniform mat4 normal_transform;
 varying mat3 lerp_tbn_transform;
@@ -9,11 +9,20 @@ varying vec2 lerp_texcoord;
 
 void main()
 {
-    vec3 normal        = normalize(vec3(normal_transform * vec4(vertex_normal, 0)));
-    vec3 tangent       = normalize(vec3(normal_transform * vec4(vertex_tangent, 0)));
+    vec3 pos    = decode_position();
+    vec3 normal = decode_normal();
+    deform(pos, normal);
+    mat4 skin_transform = get_skin_transform();
+    pos          = vec3(skin_transform * vec4(pos, 1));
+    normal       = vec3(skin_transform * vec4(normal, 0));
+    vec3 tangent = vec3(skin_transform * vec4(decode_tangent(), 0));
+
+    normal             = normalize(vec3(normal_transform * vec4(normal, 0)));
+    tangent            = normalize(vec3(normal_transform * vec4(tangent, 0)));
+    tangent            = normalize(tangent - normal * dot(normal, tangent)); // re-orthogonalize after deform
     vec3 bitangent     = normalize(cross(normal, tangent));
     lerp_tbn_transform = mat3(tangent, bitangent, normal);
 
-    gl_Position = mvp_transform * vec4(vertex_position, 1);
-    lerp_texcoord = texcoord;
+    gl_Position = mvp_transform * vec4(pos, 1);
+    lerp_texcoord = decode_texcoord();
 }
@@ -0,0 +1,38 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+const int NUM_BONES = 32; // NOTE: keep in sync with NUM_BONES in ShaderContext.cpp
+
+attribute vec4 bone_indices;
+attribute vec4 bone_weights;
+uniform mat4 bone_transforms[NUM_BONES];
+
+// NOTE: unskinned meshes get constant zero weights (see ShaderContext::render), so this is identity for them
+mat4 get_skin_transform()
+{
+    // out of range bones are clamped for indexing but weigh nothing (same as Mesh::skin_vertices)
+    vec4  in_range = step(vec4(0), bone_indices) * (vec4(1) - step(vec4(float(NUM_BONES)), bone_indices));
+    vec4  weights  = bone_weights * in_range;
+    ivec4 indices  = ivec4(clamp(bone_indices, vec4(0), vec4(float(NUM_BONES - 1))));
+
+    // unweighted remainder stays in bind pose
+    return bone_transforms[indices.x] * weights.x +
+           bone_transforms[indices.y] * weights.y +
+           bone_transforms[indices.z] * weights.z +
+           bone_transforms[indices.w] * weights.w +
+           mat4(1.0) * (1.0 - dot(weights, vec4(1)));
+}
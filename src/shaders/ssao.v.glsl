@@ -1,6 +1,7 @@
-attribute vec2 texcoord;
-attribute vec3 vertex_normal;
-attribute vec3 vertex_position;
+#include "deformer.inc.glsl"
+#include "skinning.inc.glsl"
+#include "vertex_decode.inc.glsl"
+
 uniform mat4 mvp_transform;
 uniform mat4 normal_transform;
 varying vec2 lerp_texcoord;
@@ -8,8 +9,15 @@ varying vec3 lerp_normal;
 
 void main()
 {
-    lerp_normal = normalize(vec3(normal_transform * vec4(vertex_normal, 0)));
+    vec3 pos    = decode_position();
+    vec3 normal = decode_normal();
+    deform(pos, normal);
+    mat4 skin_transform = get_skin_transform();
+    pos    = vec3(skin_transform * vec4(pos, 1));
+    normal = vec3(skin_transform * vec4(normal, 0));
+
+    lerp_normal = normalize(vec3(normal_transform * vec4(normal, 0)));
 
-    gl_Position = mvp_transform * vec4(vertex_position, 1);
-    lerp_texcoord = texcoord;
+    gl_Position = mvp_transform * vec4(pos, 1);
+    lerp_texcoord = decode_texcoord();
 }
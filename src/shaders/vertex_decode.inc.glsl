@@ -0,0 +1,58 @@
+// This file is part of dexvt-lite.
+// -- 3D Inverse Kinematics (Cyclic Coordinate Descent) with Constraints
+// Copyright (C) 2018 onlyuser <mailto:onlyuser@gmail.com>
+//
+// dexvt-lite is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// dexvt-lite is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with dexvt-lite.  If not, see <http://www.gnu.org/licenses/>.
+
+// NOTE: compressed meshes bind only the packed attributes, others only the float ones (see Mesh::create_shader_context)
+attribute vec2 texcoord;
+attribute vec3 vertex_normal;
+attribute vec3 vertex_position;
+attribute vec3 vertex_tangent;
+attribute vec2 packed_normal;   // octahedral, snorm16
+attribute vec4 packed_position; // snorm16 relative to mesh bbox (w unused)
+attribute vec2 packed_tangent;  // octahedral, snorm16
+attribute vec2 packed_texcoord; // half float
+uniform bool packed_vertices;
+uniform vec3 position_dequant_offset;
+uniform vec3 position_dequant_scale;
+
+vec3 oct_decode(vec2 e)
+{
+    vec3 v = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+    if(v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
+vec3 decode_position()
+{
+    return packed_vertices ? position_dequant_offset + packed_position.xyz * position_dequant_scale : vertex_position;
+}
+
+vec3 decode_normal()
+{
+    return packed_vertices ? oct_decode(packed_normal) : normalize(vertex_normal);
+}
+
+vec3 decode_tangent()
+{
+    return packed_vertices ? oct_decode(packed_tangent) : normalize(vertex_tangent);
+}
+
+vec2 decode_texcoord()
+{
+    return packed_vertices ? packed_texcoord : texcoord;
+}